@@ -0,0 +1,104 @@
+//------------------------------------------------------------------------------
+// Arena first-touch latency benchmark
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+//> use: core
+
+#include <core/core.h>
+
+//------------------------------------------------------------------------------
+
+#define BENCH_TOTAL_SIZE MB(256)
+#define BENCH_REQUEST_SIZE KB(64)
+
+typedef struct {
+    cstr          name;
+    ArenaPrefault prefault;
+    ArenaPages    pages;
+    bool          chained;
+} BenchMode;
+
+internal void bench_mode(BenchMode mode)
+{
+    Arena arena;
+    arena_init(&arena,
+               .reserved_size = GB(1),
+               .prefault      = mode.prefault,
+               .pages         = mode.pages,
+               .chained       = mode.chained);
+
+    usize page     = KB(4); // Smallest page size on supported platforms
+    usize requests = BENCH_TOTAL_SIZE / BENCH_REQUEST_SIZE;
+
+    TimeDuration total = 0;
+    TimeDuration worst = 0;
+
+    // Each request allocates a block and writes to every page of it, as a
+    // request handler filling a buffer would.
+    for (usize i = 0; i < requests; ++i) {
+        TimePoint start = time_now();
+        u8*       data  = arena_alloc(&arena, BENCH_REQUEST_SIZE);
+        for (usize offset = 0; offset < BENCH_REQUEST_SIZE; offset += page) {
+            ((volatile u8*)data)[offset] = 1;
+        }
+        TimeDuration elapsed = time_elapsed(start, time_now());
+
+        total += elapsed;
+        worst = MAX(worst, elapsed);
+    }
+
+    ArenaStats stats = arena_stats(&arena);
+    cstr       pages = arena.pages == ARENA_PAGES_HUGETLB       ? "hugetlb"
+                       : arena.pages == ARENA_PAGES_TRANSPARENT ? "thp"
+                                                                : "normal";
+    prn("%-22s %-8s %10.2f %10.2f %8zu %12.2f",
+        mode.name,
+        pages,
+        (f64)time_duration_to_ns(total) / (f64)requests / 1000.0,
+        (f64)time_duration_to_ns(worst) / 1000.0,
+        stats.commit_count,
+        time_secs(total) * 1000.0);
+
+    arena_done(&arena);
+}
+
+int run(int argc, char** argv)
+{
+    UNUSED(argc);
+    UNUSED(argv);
+
+    BenchMode modes[] = {
+        {"lazy", ARENA_PREFAULT_NONE, ARENA_PAGES_NORMAL, false},
+        {"touch", ARENA_PREFAULT_TOUCH, ARENA_PAGES_NORMAL, false},
+        {"populate", ARENA_PREFAULT_POPULATE, ARENA_PAGES_NORMAL, false},
+        {"thp", ARENA_PREFAULT_NONE, ARENA_PAGES_TRANSPARENT, false},
+        {"thp+populate",
+         ARENA_PREFAULT_POPULATE,
+         ARENA_PAGES_TRANSPARENT,
+         false},
+        {"hugetlb", ARENA_PREFAULT_NONE, ARENA_PAGES_HUGETLB, false},
+        {"chained", ARENA_PREFAULT_NONE, ARENA_PAGES_NORMAL, true},
+        {"chained+populate",
+         ARENA_PREFAULT_POPULATE,
+         ARENA_PAGES_NORMAL,
+         true},
+    };
+
+    prn("First-touch latency: %llu MB in %llu KB requests",
+        (unsigned long long)(BENCH_TOTAL_SIZE / MB(1)),
+        (unsigned long long)(BENCH_REQUEST_SIZE / KB(1)));
+    prn(ANSI_BOLD "%-22s %-8s %10s %10s %8s %12s" ANSI_RESET,
+        "Mode",
+        "Pages",
+        "Avg (us)",
+        "Max (us)",
+        "Commits",
+        "Total (ms)");
+
+    for (usize i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i) {
+        bench_mode(modes[i]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,220 @@
+//------------------------------------------------------------------------------
+// Epoch reclamation and read-mostly publishing benchmark
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+//> use: core
+
+#include <core/core.h>
+
+//------------------------------------------------------------------------------
+
+#define BENCH_READS 2000000 // Per reader
+#define BENCH_WRITE_EVERY_US 100
+
+typedef struct {
+    u64 values[8];
+} BenchConfig;
+
+typedef enum {
+    BENCH_RWLOCK,   // Pointer swapped under a reader-writer lock
+    BENCH_EPOCH,    // Pointer swapped, old one retired through the epoch
+    BENCH_SNAPSHOT, // The same through the Snapshot API
+    BENCH_SEQLOCK,  // Config copied in and out under a seqlock
+    BENCH_MODE_COUNT,
+} BenchMode;
+
+typedef struct {
+    EpochDomain  domain;
+    RwLock       lock;
+    SeqLock      seqlock;
+    Snapshot     snapshot;
+    BenchConfig* config;
+    BenchConfig  inline_config; // Seqlock only
+    BenchMode    mode;
+    bool         done;
+    u64          sink;
+} BenchShared;
+
+internal u64 bench_sum(BenchConfig* config)
+{
+    u64 sum = 0;
+    for (usize i = 0; i < 8; ++i) {
+        sum += config->values[i];
+    }
+    return sum;
+}
+
+internal void bench_reader(void* context)
+{
+    BenchShared* shared = context;
+    EpochThread* me     = epoch_register(&shared->domain);
+    u64          sum    = 0;
+    switch (shared->mode) {
+    case BENCH_RWLOCK:
+        for (usize i = 0; i < BENCH_READS; ++i) {
+            rwlock_read_lock(&shared->lock);
+            sum += bench_sum(shared->config);
+            rwlock_read_unlock(&shared->lock);
+        }
+        break;
+
+    case BENCH_EPOCH:
+        for (usize i = 0; i < BENCH_READS; ++i) {
+            epoch_enter(me);
+            sum += bench_sum(
+                atomic_load_ptr((void**)&shared->config, MEMORY_ACQUIRE));
+            epoch_exit(me);
+        }
+        break;
+
+    case BENCH_SNAPSHOT:
+        for (usize i = 0; i < BENCH_READS; ++i) {
+            BenchConfig* config =
+                (BenchConfig*)snapshot_read_begin(&shared->snapshot, me);
+            sum += bench_sum(config);
+            snapshot_read_end(&shared->snapshot, me);
+        }
+        break;
+
+    case BENCH_SEQLOCK:
+        for (usize i = 0; i < BENCH_READS; ++i) {
+            BenchConfig config;
+            seqlock_read(&shared->seqlock,
+                         &config,
+                         &shared->inline_config,
+                         sizeof(config));
+            sum += bench_sum(&config);
+        }
+        break;
+
+    default:
+        break;
+    }
+    epoch_unregister(me);
+    atomic_fetch_add_u64(&shared->sink, sum, MEMORY_RELAXED);
+}
+
+// Replaces the config every BENCH_WRITE_EVERY_US until the readers finish.
+internal void bench_writer(void* context)
+{
+    BenchShared* shared = context;
+    EpochThread* me     = epoch_register(&shared->domain);
+    u64          writes = 0;
+    while (!atomic_load_bool(&shared->done, MEMORY_ACQUIRE)) {
+        BenchConfig* fresh = KORE_ALLOC(sizeof(BenchConfig));
+        memset(fresh, (int)++writes, sizeof(*fresh));
+        BenchConfig* old = NULL;
+        switch (shared->mode) {
+        case BENCH_RWLOCK:
+            rwlock_write_lock(&shared->lock);
+            old            = shared->config;
+            shared->config = fresh;
+            rwlock_write_unlock(&shared->lock);
+            KORE_FREE(old);
+            break;
+
+        case BENCH_EPOCH:
+            old = atomic_exchange_ptr(
+                (void**)&shared->config, fresh, MEMORY_ACQ_REL);
+            epoch_retire_mem(me, old);
+            break;
+
+        case BENCH_SNAPSHOT:
+            snapshot_publish(&shared->snapshot, me, fresh);
+            break;
+
+        case BENCH_SEQLOCK:
+            seqlock_write(&shared->seqlock,
+                          &shared->inline_config,
+                          fresh,
+                          sizeof(*fresh));
+            KORE_FREE(fresh);
+            break;
+
+        default:
+            break;
+        }
+        TimePoint until =
+            time_add_duration(time_now(), time_from_us(BENCH_WRITE_EVERY_US));
+        while (time_now() < until &&
+               !atomic_load_bool(&shared->done, MEMORY_ACQUIRE)) {
+            CPU_RELAX();
+        }
+    }
+    epoch_unregister(me);
+}
+
+internal f64 bench_run(BenchShared* shared, usize readers, BenchMode mode)
+{
+    shared->mode   = mode;
+    shared->done   = false;
+    shared->config = KORE_ALLOC(sizeof(BenchConfig));
+    memset(shared->config, 0, sizeof(BenchConfig));
+    snapshot_init(&shared->snapshot,
+                  .domain  = &shared->domain,
+                  .initial = shared->config);
+
+    Thread writer;
+    thread_create(&writer, bench_writer, shared);
+
+    Thread    threads[64];
+    TimePoint start = time_now();
+    for (usize i = 0; i < readers; ++i) {
+        thread_create(&threads[i], bench_reader, shared);
+    }
+    for (usize i = 0; i < readers; ++i) {
+        thread_join(&threads[i]);
+    }
+    TimeDuration elapsed = time_elapsed(start, time_now());
+
+    atomic_store_bool(&shared->done, true, MEMORY_RELEASE);
+    thread_join(&writer);
+    if (mode == BENCH_SNAPSHOT) {
+        shared->config = NULL;
+        snapshot_done(&shared->snapshot);
+    } else {
+        KORE_FREE(shared->config);
+    }
+
+    return (f64)time_duration_to_ns(elapsed) / (f64)(BENCH_READS * readers);
+}
+
+//------------------------------------------------------------------------------
+
+int run(int argc, char** argv)
+{
+    UNUSED(argc);
+    UNUSED(argv);
+
+    BenchShared shared = {0};
+    epoch_domain_init(&shared.domain);
+    rwlock_init(&shared.lock);
+    seqlock_init(&shared.seqlock);
+
+    prn("Read-mostly 64-byte config, replaced every %dus (ns per read)",
+        BENCH_WRITE_EVERY_US);
+    prn(ANSI_BOLD "%8s %10s %10s %10s %10s" ANSI_RESET,
+        "Readers",
+        "RwLock",
+        "Epoch",
+        "Snapshot",
+        "Seqlock");
+
+    usize cpus = MIN(thread_cpu_count(), 64);
+    for (usize readers = 1;; readers *= 2) {
+        readers = MIN(readers, cpus);
+        pr("%8zu", readers);
+        for (BenchMode mode = 0; mode < BENCH_MODE_COUNT; ++mode) {
+            pr(" %10.1f", bench_run(&shared, readers, mode));
+        }
+        prn("");
+        if (readers == cpus) {
+            break;
+        }
+    }
+
+    rwlock_done(&shared.lock);
+    epoch_domain_done(&shared.domain);
+    return 0;
+}
@@ -0,0 +1,127 @@
+//------------------------------------------------------------------------------
+// Fiber benchmark
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+//> use: core
+
+#include <core/core.h>
+
+//------------------------------------------------------------------------------
+
+#define BENCH_YIELDS 1000000
+#define BENCH_SPAWNS 100000
+#define BENCH_IN_FLIGHT 10000
+#define BENCH_PING_PONGS 100000
+
+internal void bench_yielder(void* context)
+{
+    UNUSED(context);
+    for (usize i = 0; i < BENCH_YIELDS; ++i) {
+        fiber_yield();
+    }
+}
+
+internal void bench_empty(void* context) { UNUSED(context); }
+
+internal void bench_parker(void* context)
+{
+    UNUSED(context);
+    fiber_park_until(time_add_duration(time_now(), time_from_ms(1)));
+}
+
+typedef struct {
+    Channel* ping;
+    Channel* pong;
+} BenchPingPong;
+
+internal void bench_ponger(void* context)
+{
+    BenchPingPong* pair = context;
+    u64            value;
+    while (channel_recv(pair->ping, &value)) {
+        channel_send(pair->pong, &value);
+    }
+}
+
+internal void bench_pinger(void* context)
+{
+    BenchPingPong* pair = context;
+    for (u64 i = 0; i < BENCH_PING_PONGS; ++i) {
+        u64 value = i;
+        channel_send(pair->ping, &value);
+        channel_recv(pair->pong, &value);
+    }
+    channel_close(pair->ping);
+}
+
+internal void bench_print(cstr name, usize count, TimePoint start)
+{
+    TimeDuration elapsed = time_elapsed(start, time_now());
+    prn("%-34s %10.1f ns/op",
+        name,
+        (f64)time_duration_to_ns(elapsed) / (f64)count);
+}
+
+//------------------------------------------------------------------------------
+
+int run(int argc, char** argv)
+{
+    UNUSED(argc);
+    UNUSED(argv);
+
+    FiberScheduler scheduler;
+    fiber_scheduler_init(&scheduler, .stack_size = KB(16));
+
+    TimePoint start = time_now();
+    fiber_spawn(&scheduler, bench_yielder, NULL);
+    fiber_spawn(&scheduler, bench_yielder, NULL);
+    fiber_scheduler_run(&scheduler);
+    bench_print("Yield (switch there and back)", BENCH_YIELDS * 2, start);
+
+    start = time_now();
+    for (usize round = 0; round < BENCH_SPAWNS / BENCH_IN_FLIGHT; ++round) {
+        for (usize i = 0; i < BENCH_IN_FLIGHT; ++i) {
+            fiber_spawn(&scheduler, bench_empty, NULL);
+        }
+        fiber_scheduler_run(&scheduler);
+    }
+    bench_print("Spawn and finish", BENCH_SPAWNS, start);
+
+    start = time_now();
+    for (usize i = 0; i < BENCH_IN_FLIGHT; ++i) {
+        fiber_spawn(&scheduler, bench_parker, NULL);
+    }
+    fiber_scheduler_run(&scheduler);
+    bench_print("Spawn, park 1ms and finish", BENCH_IN_FLIGHT, start);
+
+    Arena arena;
+    arena_init(&arena, .reserved_size = MB(1));
+    Channel ping, pong;
+    channel_init(&ping, &arena, 1, sizeof(u64));
+    channel_init(&pong, &arena, 1, sizeof(u64));
+    BenchPingPong pair = {&ping, &pong};
+
+    start = time_now();
+    fiber_spawn(&scheduler, bench_ponger, &pair);
+    fiber_spawn(&scheduler, bench_pinger, &pair);
+    fiber_scheduler_run(&scheduler);
+    bench_print("Channel round trip (fibers)", BENCH_PING_PONGS, start);
+    channel_done(&ping);
+    channel_done(&pong);
+
+    channel_init(&ping, &arena, 1, sizeof(u64));
+    channel_init(&pong, &arena, 1, sizeof(u64));
+    Thread thread;
+    start = time_now();
+    thread_create(&thread, bench_ponger, &pair);
+    bench_pinger(&pair);
+    thread_join(&thread);
+    bench_print("Channel round trip (threads)", BENCH_PING_PONGS, start);
+    channel_done(&ping);
+    channel_done(&pong);
+
+    arena_done(&arena);
+    fiber_scheduler_done(&scheduler);
+    return 0;
+}
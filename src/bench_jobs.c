@@ -0,0 +1,151 @@
+//------------------------------------------------------------------------------
+// Job system benchmark
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+//> use: core
+
+#include <core/core.h>
+
+//------------------------------------------------------------------------------
+
+#define BENCH_FIB_N 32
+#define BENCH_FIB_CUTOFF 12 // Below this fib runs serially inside one job
+#define BENCH_FAN_OUT_JOBS 1000000
+#define BENCH_FAN_OUT_WORK 64 // Iterations of busy work per fan-out job
+
+//------------------------------------------------------------------------------
+// Recursive splitting
+
+typedef struct {
+    JobSystem* system;
+    u64        n;
+    u64        result;
+    u64        jobs; // Jobs run in this subtree
+} BenchFib;
+
+internal u64 bench_fib_serial(u64 n)
+{
+    return n < 2 ? n : bench_fib_serial(n - 1) + bench_fib_serial(n - 2);
+}
+
+internal void bench_fib_job(void* context)
+{
+    BenchFib* fib = context;
+    if (fib->n < BENCH_FIB_CUTOFF) {
+        fib->result = bench_fib_serial(fib->n);
+        fib->jobs   = 1;
+        return;
+    }
+
+    BenchFib   a = {fib->system, fib->n - 1, 0, 0};
+    BenchFib   b = {fib->system, fib->n - 2, 0, 0};
+    Job        jobs[2];
+    JobCounter counter = {0};
+    job_init(&jobs[0], bench_fib_job, &a);
+    job_init(&jobs[1], bench_fib_job, &b);
+    job_submit(fib->system, &jobs[0], &counter);
+    job_submit(fib->system, &jobs[1], &counter);
+    job_wait(fib->system, &counter);
+
+    fib->result = a.result + b.result;
+    fib->jobs   = a.jobs + b.jobs + 1;
+}
+
+internal TimeDuration bench_fib(JobSystem* system, u64* jobs_run)
+{
+    TimePoint  start   = time_now();
+    BenchFib   fib     = {system, BENCH_FIB_N, 0, 0};
+    Job        job;
+    JobCounter counter = {0};
+    job_init(&job, bench_fib_job, &fib);
+    job_submit(system, &job, &counter);
+    job_wait(system, &counter);
+    TimeDuration elapsed = time_elapsed(start, time_now());
+
+    ASSERT(fib.result == bench_fib_serial(BENCH_FIB_N), "Wrong fib result.");
+    *jobs_run = fib.jobs;
+    return elapsed;
+}
+
+//------------------------------------------------------------------------------
+// Wide fan-out
+
+internal void bench_fan_out_job(void* context)
+{
+    volatile u64* value = context;
+    for (u32 i = 0; i < BENCH_FAN_OUT_WORK; ++i) {
+        *value = *value * 6364136223846793005ull + 1442695040888963407ull;
+    }
+}
+
+internal TimeDuration bench_fan_out(JobSystem* system, Job* jobs, u64* values)
+{
+    TimePoint  start   = time_now();
+    JobCounter counter = {0};
+    for (usize i = 0; i < BENCH_FAN_OUT_JOBS; ++i) {
+        job_init(&jobs[i], bench_fan_out_job, &values[i]);
+        job_submit(system, &jobs[i], &counter);
+    }
+    job_wait(system, &counter);
+    return time_elapsed(start, time_now());
+}
+
+//------------------------------------------------------------------------------
+
+int run(int argc, char** argv)
+{
+    UNUSED(argc);
+    UNUSED(argv);
+
+    Job* jobs   = KORE_ARRAY_ALLOC(Job, BENCH_FAN_OUT_JOBS);
+    u64* values = KORE_ARRAY_ALLOC(u64, BENCH_FAN_OUT_JOBS);
+    memset(values, 0, sizeof(u64) * BENCH_FAN_OUT_JOBS);
+
+    TimePoint start = time_now();
+    u64       fib   = bench_fib_serial(BENCH_FIB_N);
+    f64       base  = time_secs(time_elapsed(start, time_now())) * 1000.0;
+
+    prn("Job system: fib(%d) split down to fib(%d), %d fan-out jobs",
+        BENCH_FIB_N,
+        BENCH_FIB_CUTOFF,
+        BENCH_FAN_OUT_JOBS);
+    prn("Serial fib: %llu in %.2f ms", (unsigned long long)fib, base);
+    prn(ANSI_BOLD "%8s %12s %12s %10s %12s %14s" ANSI_RESET,
+        "Workers",
+        "Fib (ms)",
+        "Fib jobs",
+        "Speedup",
+        "Fan (ms)",
+        "Fan jobs/s");
+
+    usize cpus = thread_cpu_count();
+    for (usize workers = 1;; workers *= 2) {
+        workers = MIN(workers, cpus);
+
+        JobSystem system;
+        job_system_init(&system, .worker_count = workers);
+
+        u64          fib_jobs = 0;
+        TimeDuration fib_time = bench_fib(&system, &fib_jobs);
+        TimeDuration fan_time = bench_fan_out(&system, jobs, values);
+
+        f64 fib_ms = time_secs(fib_time) * 1000.0;
+        prn("%8zu %12.2f %12llu %9.2fx %12.2f %14.0f",
+            workers,
+            fib_ms,
+            (unsigned long long)fib_jobs,
+            base / fib_ms,
+            time_secs(fan_time) * 1000.0,
+            (f64)BENCH_FAN_OUT_JOBS / time_secs(fan_time));
+
+        job_system_done(&system);
+        if (workers == cpus) {
+            break;
+        }
+    }
+
+    KORE_ARRAY_FREE(values);
+    KORE_ARRAY_FREE(jobs);
+    return 0;
+}
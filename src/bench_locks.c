@@ -0,0 +1,157 @@
+//------------------------------------------------------------------------------
+// Lock contention benchmark
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+//> use: core
+
+#include <core/core.h>
+
+//------------------------------------------------------------------------------
+
+#define BENCH_OPS_PER_THREAD 200000
+#define BENCH_MAX_THREADS 16
+#define BENCH_READ_PERCENT 90 // Reads per hundred operations (rwlock only)
+
+typedef enum {
+    BENCH_LOCK_MUTEX,
+    BENCH_LOCK_MUTEX_PROFILED,
+    BENCH_LOCK_ADAPTIVE,
+    BENCH_LOCK_SPIN,
+    BENCH_LOCK_RW,
+    BENCH_LOCK_COUNT,
+} BenchLockKind;
+
+global_variable cstr g_bench_lock_names[BENCH_LOCK_COUNT] = {
+    "mutex",
+    "mutex (profiled)",
+    "adaptive",
+    "spinlock",
+    "rwlock 90% read",
+};
+
+typedef struct {
+    BenchLockKind kind;
+    Mutex         mutex;
+    AdaptiveMutex adaptive;
+    Spinlock      spin;
+    RwLock        rw;
+    u64           counter;
+    u64           table[16]; // Data touched inside the critical section
+} BenchLock;
+
+internal void bench_lock_worker(void* context)
+{
+    BenchLock* lock = context;
+    u64        sum  = 0;
+    for (u32 i = 0; i < BENCH_OPS_PER_THREAD; ++i) {
+        switch (lock->kind) {
+        case BENCH_LOCK_MUTEX:
+        case BENCH_LOCK_MUTEX_PROFILED:
+            mutex_lock(&lock->mutex);
+            lock->table[lock->counter++ % 16]++;
+            mutex_unlock(&lock->mutex);
+            break;
+
+        case BENCH_LOCK_ADAPTIVE:
+            adaptive_mutex_lock(&lock->adaptive);
+            lock->table[lock->counter++ % 16]++;
+            adaptive_mutex_unlock(&lock->adaptive);
+            break;
+
+        case BENCH_LOCK_SPIN:
+            spinlock_lock(&lock->spin);
+            lock->table[lock->counter++ % 16]++;
+            spinlock_unlock(&lock->spin);
+            break;
+
+        case BENCH_LOCK_RW:
+            if (i % 100 < BENCH_READ_PERCENT) {
+                rwlock_read_lock(&lock->rw);
+                sum += lock->table[i % 16];
+                rwlock_read_unlock(&lock->rw);
+            } else {
+                rwlock_write_lock(&lock->rw);
+                lock->table[lock->counter++ % 16]++;
+                rwlock_write_unlock(&lock->rw);
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    // Keep the reads from being optimised away.
+    if (sum == 1) {
+        prn("");
+    }
+}
+
+internal f64 bench_lock(BenchLockKind kind, usize thread_count)
+{
+    BenchLock lock     = {.kind = kind};
+    bool      profiled = kind == BENCH_LOCK_MUTEX_PROFILED;
+    mutex_init(&lock.mutex, .name = profiled ? "bench mutex" : NULL);
+    lock_profile_enable(profiled);
+    adaptive_mutex_init(&lock.adaptive);
+    spinlock_init(&lock.spin);
+    rwlock_init(&lock.rw);
+
+    Thread    threads[BENCH_MAX_THREADS];
+    TimePoint start = time_now();
+    for (usize i = 0; i < thread_count; ++i) {
+        thread_create(&threads[i], bench_lock_worker, &lock);
+    }
+    for (usize i = 0; i < thread_count; ++i) {
+        thread_join(&threads[i]);
+    }
+    TimeDuration elapsed = time_elapsed(start, time_now());
+
+    rwlock_done(&lock.rw);
+    spinlock_done(&lock.spin);
+    adaptive_mutex_done(&lock.adaptive);
+    mutex_done(&lock.mutex);
+    lock_profile_enable(false);
+
+    // Nanoseconds per operation across all threads.
+    return (f64)time_duration_to_ns(elapsed) /
+           (f64)(thread_count * BENCH_OPS_PER_THREAD);
+}
+
+int run(int argc, char** argv)
+{
+    UNUSED(argc);
+    UNUSED(argv);
+
+    usize cpus = thread_cpu_count();
+    prn("Lock contention: %d operations per thread, %zu CPUs",
+        BENCH_OPS_PER_THREAD,
+        cpus);
+    prn(ANSI_BOLD "%-18s %10s %10s %10s %10s %10s" ANSI_RESET,
+        "Lock (ns/op)",
+        "1",
+        "2",
+        "4",
+        "8",
+        "16");
+
+    // A ticket lock hands over to one particular waiter, so with more threads
+    // than CPUs every handover can wait for a context switch.  Those runs take
+    // minutes and are skipped.
+    for (BenchLockKind kind = 0; kind < BENCH_LOCK_COUNT; ++kind) {
+        pr("%-18s", g_bench_lock_names[kind]);
+        for (usize threads = 1; threads <= BENCH_MAX_THREADS; threads *= 2) {
+            if (kind == BENCH_LOCK_SPIN && threads > MAX(cpus, 2)) {
+                pr(" %10s", "-");
+            } else {
+                pr(" %10.1f", bench_lock(kind, threads));
+            }
+        }
+        prn("");
+    }
+
+    prn("");
+    lock_profile_print(5);
+    return 0;
+}
@@ -0,0 +1,138 @@
+//------------------------------------------------------------------------------
+// Buffered output benchmark
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+//> use: core
+
+#include <core/core.h>
+
+#include <stdio.h>
+
+#if OS_POSIX
+#    include <fcntl.h>
+#endif // OS_POSIX
+
+//------------------------------------------------------------------------------
+// A logging loop printing to /dev/null, so the cost is in getting the text
+// there: unbuffered like prn() used to be (lock, format, write, then the same
+// again for the newline), line buffered and fully buffered.
+
+#define BENCH_LINES 1000000
+#define BENCH_MAX_THREADS 4
+
+typedef enum {
+    BENCH_OUTPUT_UNBUFFERED,
+    BENCH_OUTPUT_LINES,
+    BENCH_OUTPUT_FULL,
+    BENCH_OUTPUT_COUNT,
+} BenchOutputMode;
+
+global_variable cstr g_bench_output_names[BENCH_OUTPUT_COUNT] = {
+    "unbuffered",
+    "lines",
+    "full",
+};
+
+typedef struct {
+    BenchOutputMode mode;
+    usize           lines;
+} BenchOutput;
+
+#if OS_POSIX
+
+global_variable AdaptiveMutex g_bench_output_mutex = {.name = "bench_output"};
+
+internal void bench_unbuffered_pr(cstr format, ...)
+{
+    char    text[256];
+    va_list args;
+    va_start(args, format);
+    adaptive_mutex_lock(&g_bench_output_mutex);
+    int size = vsnprintf(text, sizeof(text), format, args);
+    write(STDOUT_FILENO, text, (usize)MIN(size, (int)sizeof(text) - 1));
+    adaptive_mutex_unlock(&g_bench_output_mutex);
+    va_end(args);
+}
+
+internal void bench_output_worker(void* context)
+{
+    BenchOutput* bench = context;
+    for (usize i = 0; i < bench->lines; ++i) {
+        if (bench->mode == BENCH_OUTPUT_UNBUFFERED) {
+            bench_unbuffered_pr("request %zu took %d us", i, (int)(i % 977));
+            bench_unbuffered_pr("\n");
+        } else {
+            prn("request %zu took %d us", i, (int)(i % 977));
+        }
+    }
+}
+
+internal f64 bench_output(BenchOutputMode mode, usize thread_count)
+{
+    pr_set_flush(mode == BENCH_OUTPUT_FULL ? OUTPUT_FLUSH_FULL
+                                           : OUTPUT_FLUSH_LINES);
+    BenchOutput bench = {mode, BENCH_LINES / thread_count};
+    Thread      threads[BENCH_MAX_THREADS];
+
+    TimePoint begin = time_now();
+    for (usize i = 0; i < thread_count; ++i) {
+        thread_create(&threads[i], bench_output_worker, &bench);
+    }
+    for (usize i = 0; i < thread_count; ++i) {
+        thread_join(&threads[i]);
+    }
+    TimeDuration elapsed = time_elapsed(begin, time_now());
+    return (f64)time_duration_to_ns(elapsed) / (bench.lines * thread_count);
+}
+
+int run(int argc, char** argv)
+{
+    UNUSED(argc);
+    UNUSED(argv);
+
+    f64 results[BENCH_OUTPUT_COUNT][BENCH_MAX_THREADS];
+
+    // Results are printed once stdout is back, so they stay out of /dev/null.
+    pr_flush();
+    int null_file = open("/dev/null", O_WRONLY);
+    int saved     = dup(STDOUT_FILENO);
+    dup2(null_file, STDOUT_FILENO);
+    for (usize mode = 0; mode < BENCH_OUTPUT_COUNT; ++mode) {
+        for (usize threads = 1; threads <= BENCH_MAX_THREADS; threads *= 2) {
+            results[mode][threads - 1] = bench_output(mode, threads);
+        }
+    }
+    pr_flush();
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    close(null_file);
+    pr_set_flush(OUTPUT_FLUSH_AUTO);
+
+    prn("%d lines to /dev/null, ns per line", BENCH_LINES);
+    pr(ANSI_BOLD "%-12s" ANSI_RESET, "");
+    for (usize threads = 1; threads <= BENCH_MAX_THREADS; threads *= 2) {
+        pr(ANSI_BOLD " %8zu thr" ANSI_RESET, threads);
+    }
+    prn("");
+    for (usize mode = 0; mode < BENCH_OUTPUT_COUNT; ++mode) {
+        pr("%-12s", g_bench_output_names[mode]);
+        for (usize threads = 1; threads <= BENCH_MAX_THREADS; threads *= 2) {
+            pr(" %12.1f", results[mode][threads - 1]);
+        }
+        prn("");
+    }
+    return 0;
+}
+
+#else
+
+int run(int argc, char** argv)
+{
+    UNUSED(argc);
+    UNUSED(argv);
+    prn("The output benchmark redirects stdout, which needs a POSIX system.");
+    return 0;
+}
+
+#endif // OS_POSIX
@@ -0,0 +1,170 @@
+//------------------------------------------------------------------------------
+// Parallel algorithms benchmark
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+//> use: core
+
+#include <core/core.h>
+
+//------------------------------------------------------------------------------
+
+#define BENCH_RECORDS 4000000
+
+typedef struct {
+    u64 key;
+    u64 value;
+} BenchRecord;
+
+internal void bench_sum_range(void* context, usize begin, usize end, void* sum)
+{
+    BenchRecord* records = context;
+    u64          total   = 0;
+    for (usize i = begin; i < end; ++i) {
+        total += records[i].value;
+    }
+    *(u64*)sum += total;
+}
+
+internal void bench_add(void* context, void* accumulator, const void* value)
+{
+    UNUSED(context);
+    *(u64*)accumulator += *(const u64*)value;
+}
+
+internal int bench_compare(void* context, const void* a, const void* b)
+{
+    UNUSED(context);
+    u64 x = ((const BenchRecord*)a)->key;
+    u64 y = ((const BenchRecord*)b)->key;
+    return (x > y) - (x < y);
+}
+
+internal bool bench_is_small(void* context, const void* element)
+{
+    UNUSED(context);
+    return ((const BenchRecord*)element)->value < 500;
+}
+
+internal void bench_fill(BenchRecord* records)
+{
+    random_seed(1);
+    for (usize i = 0; i < BENCH_RECORDS; ++i) {
+        records[i].key   = random_u64();
+        records[i].value = random_range_u64(0, 999);
+    }
+}
+
+internal f64 bench_ms(TimePoint start)
+{
+    return time_secs(time_elapsed(start, time_now())) * 1000.0;
+}
+
+//------------------------------------------------------------------------------
+
+int run(int argc, char** argv)
+{
+    UNUSED(argc);
+    UNUSED(argv);
+
+    BenchRecord* records = KORE_ARRAY_ALLOC(BenchRecord, BENCH_RECORDS);
+    BenchRecord* output  = KORE_ARRAY_ALLOC(BenchRecord, BENCH_RECORDS);
+    u64*         scan    = KORE_ARRAY_ALLOC(u64, BENCH_RECORDS);
+
+    prn("Parallel algorithms: %d records of %zu bytes",
+        BENCH_RECORDS,
+        sizeof(BenchRecord));
+    prn(ANSI_BOLD "%8s %10s %10s %10s %10s %10s" ANSI_RESET,
+        "Workers",
+        "Reduce ms",
+        "Scan ms",
+        "Sort ms",
+        "Radix ms",
+        "Part. ms");
+
+    usize cpus = thread_cpu_count();
+    for (usize workers = 1;; workers *= 2) {
+        workers = MIN(workers, cpus);
+
+        JobSystem system;
+        job_system_init(&system, .worker_count = workers);
+        bench_fill(records);
+        for (usize i = 0; i < BENCH_RECORDS; ++i) {
+            scan[i] = records[i].value;
+        }
+
+        u64       sum   = 0;
+        TimePoint start = time_now();
+        parallel_reduce(&system,
+                        BENCH_RECORDS,
+                        0,
+                        bench_sum_range,
+                        bench_add,
+                        records,
+                        &sum,
+                        sizeof(sum));
+        f64 reduce_ms = bench_ms(start);
+
+        u64 zero = 0;
+        start    = time_now();
+        parallel_scan(&system,
+                      scan,
+                      BENCH_RECORDS,
+                      sizeof(u64),
+                      scan,
+                      0,
+                      bench_add,
+                      NULL,
+                      &zero,
+                      true);
+        f64 scan_ms = bench_ms(start);
+        ASSERT(scan[BENCH_RECORDS - 1] == sum, "Scan and reduce disagree.");
+
+        start = time_now();
+        parallel_partition(&system,
+                           records,
+                           BENCH_RECORDS,
+                           sizeof(BenchRecord),
+                           output,
+                           bench_is_small,
+                           NULL);
+        f64 partition_ms = bench_ms(start);
+
+        start = time_now();
+        parallel_sort(&system,
+                      records,
+                      BENCH_RECORDS,
+                      sizeof(BenchRecord),
+                      bench_compare,
+                      NULL);
+        f64 sort_ms = bench_ms(start);
+
+        bench_fill(records);
+        start = time_now();
+        parallel_radix_sort(&system,
+                            records,
+                            BENCH_RECORDS,
+                            sizeof(BenchRecord),
+                            offsetof(BenchRecord, key),
+                            sizeof(u64));
+        f64 radix_ms = bench_ms(start);
+
+        prn("%8zu %10.2f %10.2f %10.2f %10.2f %10.2f",
+            workers,
+            reduce_ms,
+            scan_ms,
+            sort_ms,
+            radix_ms,
+            partition_ms);
+
+        job_system_done(&system);
+        if (workers == cpus) {
+            break;
+        }
+    }
+
+    KORE_ARRAY_FREE(scan);
+    KORE_ARRAY_FREE(output);
+    KORE_ARRAY_FREE(records);
+    return 0;
+}
@@ -0,0 +1,210 @@
+//------------------------------------------------------------------------------
+// Queue throughput and latency benchmark
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+//> use: core
+
+#include <core/core.h>
+
+//------------------------------------------------------------------------------
+
+#define BENCH_QUEUE_ITEMS 1000000
+#define BENCH_QUEUE_CAPACITY 1024
+#define BENCH_QUEUE_BATCH 32
+#define BENCH_PING_PONGS 20000
+#define BENCH_MAX_THREADS 32
+
+//------------------------------------------------------------------------------
+// SPSC
+
+typedef struct {
+    SpscQueue* queue;
+    usize      batch; // Elements per pop, or 1 to use single pops
+} BenchSpsc;
+
+internal void bench_spsc_consumer(void* context)
+{
+    BenchSpsc* bench = context;
+    u64        batch[BENCH_QUEUE_BATCH];
+    u64        received = 0;
+    while (received < BENCH_QUEUE_ITEMS) {
+        if (bench->batch == 1) {
+            spsc_pop(bench->queue, &batch[0]);
+            received++;
+        } else {
+            usize popped = spsc_pop_batch(bench->queue, batch, bench->batch);
+            if (popped == 0) {
+                spsc_pop(bench->queue, &batch[0]);
+                popped = 1;
+            }
+            received += popped;
+        }
+    }
+}
+
+// Returns millions of items per second.
+internal f64 bench_spsc(Arena* arena, usize batch_size)
+{
+    SpscQueue queue;
+    spsc_init(&queue, arena, BENCH_QUEUE_CAPACITY, sizeof(u64));
+
+    BenchSpsc bench = {&queue, batch_size};
+    Thread    thread;
+    TimePoint start = time_now();
+    thread_create(&thread, bench_spsc_consumer, &bench);
+
+    u64 batch[BENCH_QUEUE_BATCH] = {0};
+    for (u64 sent = 0; sent < BENCH_QUEUE_ITEMS;) {
+        if (batch_size == 1) {
+            spsc_push(&queue, &sent);
+            sent++;
+        } else {
+            usize count  = MIN(batch_size, BENCH_QUEUE_ITEMS - sent);
+            usize pushed = spsc_push_batch(&queue, batch, count);
+            if (pushed == 0) {
+                spsc_push(&queue, &batch[0]);
+                pushed = 1;
+            }
+            sent += pushed;
+        }
+    }
+    thread_join(&thread);
+
+    return (f64)BENCH_QUEUE_ITEMS / time_secs(time_elapsed(start, time_now())) /
+           1000000.0;
+}
+
+typedef struct {
+    SpscQueue* ping;
+    SpscQueue* pong;
+} BenchPingPong;
+
+internal void bench_pong(void* context)
+{
+    BenchPingPong* bench = context;
+    for (u32 i = 0; i < BENCH_PING_PONGS; ++i) {
+        u64 value;
+        spsc_pop(bench->ping, &value);
+        spsc_push(bench->pong, &value);
+    }
+}
+
+// Returns the mean round trip in nanoseconds.
+internal f64 bench_spsc_round_trip(Arena* arena)
+{
+    SpscQueue ping;
+    SpscQueue pong;
+    spsc_init(&ping, arena, 2, sizeof(u64));
+    spsc_init(&pong, arena, 2, sizeof(u64));
+
+    BenchPingPong bench = {&ping, &pong};
+    Thread        thread;
+    thread_create(&thread, bench_pong, &bench);
+
+    TimePoint start = time_now();
+    for (u64 i = 0; i < BENCH_PING_PONGS; ++i) {
+        u64 value = i;
+        spsc_push(&ping, &value);
+        spsc_pop(&pong, &value);
+    }
+    TimeDuration elapsed = time_elapsed(start, time_now());
+    thread_join(&thread);
+
+    return (f64)time_duration_to_ns(elapsed) / BENCH_PING_PONGS;
+}
+
+//------------------------------------------------------------------------------
+// MPMC
+
+typedef struct {
+    MpmcQueue* queue;
+    u64        items;
+} BenchMpmc;
+
+internal void bench_mpmc_producer(void* context)
+{
+    BenchMpmc* bench = context;
+    u64        batch[BENCH_QUEUE_BATCH] = {0};
+    for (u64 sent = 0; sent < bench->items;) {
+        usize count  = MIN(BENCH_QUEUE_BATCH, bench->items - sent);
+        usize pushed = mpmc_push_batch(bench->queue, batch, count);
+        if (pushed == 0) {
+            mpmc_push(bench->queue, &batch[0]);
+            pushed = 1;
+        }
+        sent += pushed;
+    }
+}
+
+internal void bench_mpmc_consumer(void* context)
+{
+    BenchMpmc* bench = context;
+    u64        batch[BENCH_QUEUE_BATCH];
+    for (u64 received = 0; received < bench->items;) {
+        usize count  = MIN(BENCH_QUEUE_BATCH, bench->items - received);
+        usize popped = mpmc_pop_batch(bench->queue, batch, count);
+        if (popped == 0) {
+            mpmc_pop(bench->queue, &batch[0]);
+            popped = 1;
+        }
+        received += popped;
+    }
+}
+
+// Returns millions of items per second with `threads` producers and as many
+// consumers.
+internal f64 bench_mpmc(Arena* arena, usize threads)
+{
+    MpmcQueue queue;
+    mpmc_init(&queue, arena, BENCH_QUEUE_CAPACITY, sizeof(u64));
+
+    u64       items = BENCH_QUEUE_ITEMS / threads * threads;
+    BenchMpmc bench = {&queue, items / threads};
+    Thread    workers[BENCH_MAX_THREADS * 2];
+
+    TimePoint start = time_now();
+    for (usize i = 0; i < threads; ++i) {
+        thread_create(&workers[i], bench_mpmc_consumer, &bench);
+        thread_create(&workers[threads + i], bench_mpmc_producer, &bench);
+    }
+    for (usize i = 0; i < threads * 2; ++i) {
+        thread_join(&workers[i]);
+    }
+
+    return (f64)items / time_secs(time_elapsed(start, time_now())) / 1000000.0;
+}
+
+//------------------------------------------------------------------------------
+
+int run(int argc, char** argv)
+{
+    UNUSED(argc);
+    UNUSED(argv);
+
+    Arena arena;
+    arena_init(&arena, .reserved_size = MB(64));
+
+    prn("Queues: %d items, capacity %d, %zu CPUs",
+        BENCH_QUEUE_ITEMS,
+        BENCH_QUEUE_CAPACITY,
+        thread_cpu_count());
+
+    prn("SPSC single:     %8.2f M items/s", bench_spsc(&arena, 1));
+    prn("SPSC batch of %d: %7.2f M items/s",
+        BENCH_QUEUE_BATCH,
+        bench_spsc(&arena, BENCH_QUEUE_BATCH));
+    prn("SPSC round trip: %8.1f ns", bench_spsc_round_trip(&arena));
+
+    prn(ANSI_BOLD "%10s %10s %12s" ANSI_RESET,
+        "Producers",
+        "Consumers",
+        "M items/s");
+    for (usize threads = 1; threads <= BENCH_MAX_THREADS; threads *= 2) {
+        f64 rate = bench_mpmc(&arena, threads);
+        prn("%10zu %10zu %12.2f", threads, threads, rate);
+    }
+
+    arena_done(&arena);
+    return 0;
+}
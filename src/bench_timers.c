@@ -0,0 +1,197 @@
+//------------------------------------------------------------------------------
+// Timer wheel benchmark
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+//> use: core
+
+#include <core/core.h>
+
+//------------------------------------------------------------------------------
+// Connection timeouts: every timer is scheduled 1-60s out, 90% are cancelled
+// before they fire and the rest expire as simulated time moves in 1ms steps.
+
+#define BENCH_TIMERS 1000000
+#define BENCH_SPAN_MS 60000
+#define BENCH_CANCEL_PERCENT 90
+
+typedef struct {
+    f64   schedule_ns; // Per timer
+    f64   cancel_ns;   // Per cancelled timer
+    f64   expire_ms;   // Whole run
+    usize fired;
+} BenchResult;
+
+internal void bench_count(void* context) { ++*(usize*)context; }
+
+internal BenchResult bench_wheel(const u64* deadlines_ms)
+{
+    BenchResult  result  = {0};
+    TimePoint    start   = time_from_secs(1);
+    TimerHandle* handles = KORE_ALLOC(sizeof(TimerHandle) * BENCH_TIMERS);
+    TimerWheel   wheel;
+    timer_wheel_init(&wheel, .start = start);
+
+    TimePoint begin = time_now();
+    for (usize i = 0; i < BENCH_TIMERS; ++i) {
+        handles[i] = timer_schedule(&wheel,
+                                    start + time_from_ms(deadlines_ms[i]),
+                                    bench_count,
+                                    &result.fired);
+    }
+    result.schedule_ns =
+        (f64)time_duration_to_ns(time_elapsed(begin, time_now())) /
+        BENCH_TIMERS;
+
+    usize cancels = 0;
+    begin         = time_now();
+    for (usize i = 0; i < BENCH_TIMERS; ++i) {
+        if (i % 100 < BENCH_CANCEL_PERCENT) {
+            timer_cancel(&wheel, handles[i]);
+            cancels++;
+        }
+    }
+    result.cancel_ns =
+        (f64)time_duration_to_ns(time_elapsed(begin, time_now())) / cancels;
+
+    begin = time_now();
+    for (u64 ms = 1; ms <= BENCH_SPAN_MS; ++ms) {
+        timer_wheel_advance(&wheel, start + time_from_ms(ms));
+    }
+    result.expire_ms = time_secs(time_elapsed(begin, time_now())) * 1000.0;
+
+    timer_wheel_done(&wheel);
+    KORE_FREE(handles);
+    return result;
+}
+
+//------------------------------------------------------------------------------
+// Binary heap with lazy cancellation, the usual alternative
+
+typedef struct {
+    u64 deadline;
+    u32 id;
+} BenchHeapItem;
+
+internal void bench_heap_push(BenchHeapItem* heap,
+                              usize*         count,
+                              BenchHeapItem  item)
+{
+    usize i = (*count)++;
+    while (i > 0 && heap[(i - 1) / 2].deadline > item.deadline) {
+        heap[i] = heap[(i - 1) / 2];
+        i       = (i - 1) / 2;
+    }
+    heap[i] = item;
+}
+
+internal BenchHeapItem bench_heap_pop(BenchHeapItem* heap, usize* count)
+{
+    BenchHeapItem top  = heap[0];
+    BenchHeapItem last = heap[--*count];
+    usize         i    = 0;
+    for (;;) {
+        usize child = i * 2 + 1;
+        if (child >= *count) {
+            break;
+        }
+        if (child + 1 < *count &&
+            heap[child + 1].deadline < heap[child].deadline) {
+            child++;
+        }
+        if (heap[child].deadline >= last.deadline) {
+            break;
+        }
+        heap[i] = heap[child];
+        i       = child;
+    }
+    heap[i] = last;
+    return top;
+}
+
+internal BenchResult bench_heap(const u64* deadlines_ms)
+{
+    BenchResult    result    = {0};
+    BenchHeapItem* heap      = KORE_ALLOC(sizeof(BenchHeapItem) * BENCH_TIMERS);
+    bool*          cancelled = KORE_ALLOC(sizeof(bool) * BENCH_TIMERS);
+    usize          count     = 0;
+    memset(cancelled, 0, sizeof(bool) * BENCH_TIMERS);
+
+    TimePoint begin = time_now();
+    for (usize i = 0; i < BENCH_TIMERS; ++i) {
+        bench_heap_push(
+            heap, &count, (BenchHeapItem){deadlines_ms[i], (u32)i});
+    }
+    result.schedule_ns =
+        (f64)time_duration_to_ns(time_elapsed(begin, time_now())) /
+        BENCH_TIMERS;
+
+    usize cancels = 0;
+    begin         = time_now();
+    for (usize i = 0; i < BENCH_TIMERS; ++i) {
+        if (i % 100 < BENCH_CANCEL_PERCENT) {
+            cancelled[i] = true;
+            cancels++;
+        }
+    }
+    result.cancel_ns =
+        (f64)time_duration_to_ns(time_elapsed(begin, time_now())) / cancels;
+
+    begin = time_now();
+    for (u64 ms = 1; ms <= BENCH_SPAN_MS; ++ms) {
+        while (count && heap[0].deadline <= ms) {
+            BenchHeapItem item = bench_heap_pop(heap, &count);
+            if (!cancelled[item.id]) {
+                bench_count(&result.fired);
+            }
+        }
+    }
+    result.expire_ms = time_secs(time_elapsed(begin, time_now())) * 1000.0;
+
+    KORE_FREE(cancelled);
+    KORE_FREE(heap);
+    return result;
+}
+
+//------------------------------------------------------------------------------
+
+int run(int argc, char** argv)
+{
+    UNUSED(argc);
+    UNUSED(argv);
+
+    u64* deadlines_ms = KORE_ALLOC(sizeof(u64) * BENCH_TIMERS);
+    random_seed(47);
+    for (usize i = 0; i < BENCH_TIMERS; ++i) {
+        deadlines_ms[i] = random_range_u64(1000, BENCH_SPAN_MS);
+    }
+
+    prn("%d timers over %ds, %d%% cancelled",
+        BENCH_TIMERS,
+        BENCH_SPAN_MS / 1000,
+        BENCH_CANCEL_PERCENT);
+    prn(ANSI_BOLD "%-8s %14s %14s %14s %10s" ANSI_RESET,
+        "",
+        "Schedule ns",
+        "Cancel ns",
+        "Expire ms",
+        "Fired");
+
+    BenchResult wheel = bench_wheel(deadlines_ms);
+    prn("%-8s %14.1f %14.1f %14.1f %10zu",
+        "Wheel",
+        wheel.schedule_ns,
+        wheel.cancel_ns,
+        wheel.expire_ms,
+        wheel.fired);
+    BenchResult heap = bench_heap(deadlines_ms);
+    prn("%-8s %14.1f %14.1f %14.1f %10zu",
+        "Heap",
+        heap.schedule_ns,
+        heap.cancel_ns,
+        heap.expire_ms,
+        heap.fired);
+
+    KORE_FREE(deadlines_ms);
+    return 0;
+}
@@ -12,6 +12,15 @@
 #    include <sys/mman.h>
 #endif
 
+#if OS_LINUX
+#    include <linux/mempolicy.h>
+#    include <sys/syscall.h>
+#endif
+
+Mutex g_kore_arena_registry_mutex;
+
+global_variable Arena* g_arena_registry = NULL;
+
 //------------------------------------------------------------------------------
 
 typedef struct {
@@ -39,6 +48,250 @@ internal ArenaMemoryInfo get_arena_memory_info(void)
 #    endif
 }
 
+//------------------------------------------------------------------------------
+// Page options
+
+// Faults in freshly committed pages according to the arena's prefault mode.
+internal void _arena_prefault(Arena* arena, u8* start, usize size)
+{
+    switch (arena->prefault) {
+    case ARENA_PREFAULT_NONE:
+        return;
+
+    case ARENA_PREFAULT_POPULATE:
+#    if OS_LINUX && defined(MADV_POPULATE_WRITE)
+        if (madvise(start, size, MADV_POPULATE_WRITE) == 0) {
+            return;
+        }
+#    endif
+        // Fall back to touching each page.
+        [[fallthrough]];
+
+    case ARENA_PREFAULT_TOUCH:
+        // The pages are freshly committed and zero, so writing zero is safe.
+        for (usize offset = 0; offset < size;
+             offset += arena->alloc_granularity) {
+            ((volatile u8*)start)[offset] = 0;
+        }
+        return;
+    }
+}
+
+// Advises the OS to back a range with transparent huge pages.
+internal void _arena_advise_huge(Arena* arena, u8* start, usize size)
+{
+#    if OS_LINUX && defined(MADV_HUGEPAGE)
+    if (arena->pages == ARENA_PAGES_TRANSPARENT) {
+        madvise(start, size, MADV_HUGEPAGE);
+    }
+#    else
+    UNUSED(arena);
+    UNUSED(start);
+    UNUSED(size);
+#    endif
+}
+
+// Sets the NUMA policy of a range to prefer the arena's node.  Pages already
+// faulted in are moved; later faults follow the policy.  Failure (a kernel
+// without NUMA, or a missing node) leaves placement to first touch.
+internal void _arena_bind_node(Arena* arena, u8* start, usize size)
+{
+#    if OS_LINUX
+    u32 node = arena->numa_node - 1;
+    if (arena->numa_node == 0 || node >= TOPOLOGY_MAX_NODES) {
+        return;
+    }
+    // The kernel drops the last bit of maxnode, so pass one more than the
+    // mask holds, as libnuma does.
+    unsigned long mask = 1ul << node;
+    syscall(SYS_mbind,
+            start,
+            size,
+            MPOL_PREFERRED,
+            &mask,
+            sizeof(mask) * 8 + 1,
+            MPOL_MF_MOVE);
+#    else
+    UNUSED(arena);
+    UNUSED(start);
+    UNUSED(size);
+#    endif
+}
+
+#    if OS_POSIX
+
+// Reserves address space for the arena, honouring the page mode.  Explicit
+// huge pages are reserved up front by the kernel, so they fall back to
+// transparent huge pages if the pool cannot cover the whole range.
+internal u8* _arena_reserve(Arena* arena)
+{
+#        if OS_LINUX && defined(MAP_HUGETLB)
+    if (arena->pages == ARENA_PAGES_HUGETLB) {
+        usize size   = ALIGN_UP(arena->reserved_size, ARENA_HUGE_PAGE_SIZE);
+        u8*   memory = (u8*)mmap(nullptr,
+                               size,
+                               PROT_NONE,
+                               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                               -1,
+                               0);
+        if (memory != MAP_FAILED) {
+            arena->reserved_size     = size;
+            arena->alloc_granularity = ARENA_HUGE_PAGE_SIZE;
+            arena->grow_rate         = 1;
+            return memory;
+        }
+    }
+#        endif
+
+    if (arena->pages == ARENA_PAGES_NORMAL) {
+        u8* memory = (u8*)mmap(nullptr,
+                               arena->reserved_size,
+                               PROT_NONE,
+                               MAP_PRIVATE | MAP_ANONYMOUS,
+                               -1,
+                               0);
+        return memory == MAP_FAILED ? NULL : memory;
+    }
+
+    // Transparent huge pages need the range aligned to the huge page size and
+    // commits made in whole huge pages, so over-reserve and trim.
+    arena->pages         = ARENA_PAGES_TRANSPARENT;
+    usize huge           = ARENA_HUGE_PAGE_SIZE;
+    arena->reserved_size = ALIGN_UP(arena->reserved_size, huge);
+    arena->grow_rate =
+        ALIGN_UP(arena->grow_rate * arena->alloc_granularity, huge) /
+        arena->alloc_granularity;
+
+    usize size = arena->reserved_size + huge;
+    u8*   base = (u8*)mmap(
+        nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+
+    u8* memory = ALIGN_PTR_UP(u8, base, huge);
+    u8* end    = memory + arena->reserved_size;
+    if (memory > base) {
+        munmap(base, (usize)(memory - base));
+    }
+    if (base + size > end) {
+        munmap(end, (usize)(base + size - end));
+    }
+
+    _arena_advise_huge(arena, memory, arena->reserved_size);
+    return memory;
+}
+
+#    endif // OS_POSIX
+
+//------------------------------------------------------------------------------
+// Chained blocks
+
+// Each block's header lives at the end of its mapping so that the usable
+// memory starts on a page boundary.
+typedef struct ArenaBlock {
+    struct ArenaBlock* prev;     // Previous block in the chain
+    u8*                data;     // Start of the block's usable memory
+    usize              base;     // Cursor position of data[0]
+    usize              capacity; // Usable bytes in the block
+    usize              mapped;   // Bytes mapped, including the header
+} ArenaBlock;
+
+internal ArenaBlock* _arena_map_block(Arena* arena, usize min_capacity)
+{
+    usize block_size = arena->alloc_granularity * arena->grow_rate;
+    usize mapped     = ALIGN_UP(MAX(min_capacity + sizeof(ArenaBlock),
+                                    block_size),
+                                arena->alloc_granularity);
+    bool  populated  = false;
+
+    TimePoint start = time_now();
+
+#    if OS_WINDOWS
+    u8* data = (u8*)VirtualAlloc(
+        nullptr, mapped, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#    elif OS_POSIX
+    u8* data = NULL;
+    if (arena->pages == ARENA_PAGES_TRANSPARENT) {
+        // As in _arena_reserve(), over-map and trim so that the block covers
+        // whole aligned huge pages; THP rarely backs an unaligned mapping.
+        // Populating has to wait until the block has been advised.
+        usize huge = ARENA_HUGE_PAGE_SIZE;
+        mapped     = ALIGN_UP(mapped, huge);
+        usize size = mapped + huge;
+        u8*   base = (u8*)mmap(nullptr,
+                             size,
+                             PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS,
+                             -1,
+                             0);
+        if (base != MAP_FAILED) {
+            data    = ALIGN_PTR_UP(u8, base, huge);
+            u8* end = data + mapped;
+            if (data > base) {
+                munmap(base, (usize)(data - base));
+            }
+            if (base + size > end) {
+                munmap(end, (usize)(base + size - end));
+            }
+        }
+    } else {
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#        if OS_LINUX
+        if (arena->prefault == ARENA_PREFAULT_POPULATE) {
+            flags |= MAP_POPULATE;
+            populated = true;
+        }
+#        endif
+        data = (u8*)mmap(nullptr, mapped, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (data == MAP_FAILED) {
+            data = NULL;
+        }
+    }
+#    else
+#        error "Arena block mapping not implemented for this OS."
+#    endif // OS_WINDOWS
+    mem_check(data);
+
+    _arena_advise_huge(arena, data, mapped);
+    _arena_bind_node(arena, data, mapped);
+    if (!populated) {
+        _arena_prefault(arena, data, mapped);
+    }
+
+    arena->commit_count++;
+    arena->commit_time += time_elapsed(start, time_now());
+
+    ArenaBlock* block = (ArenaBlock*)(data + mapped - sizeof(ArenaBlock));
+    block->prev       = NULL;
+    block->data       = data;
+    block->base       = 0;
+    block->capacity   = mapped - sizeof(ArenaBlock);
+    block->mapped     = mapped;
+    return block;
+}
+
+internal void _arena_unmap_block(ArenaBlock* block)
+{
+#    if OS_WINDOWS
+    VirtualFree(block->data, 0, MEM_RELEASE);
+#    elif OS_POSIX
+    munmap(block->data, block->mapped);
+#    else
+#        error "Arena block unmapping not implemented for this OS."
+#    endif // OS_WINDOWS
+}
+
+internal void _arena_use_block(Arena* arena, ArenaBlock* block)
+{
+    arena->block          = block;
+    arena->memory         = block->data;
+    arena->block_base     = block->base;
+    arena->committed_size = block->base + block->capacity;
+}
+
+//------------------------------------------------------------------------------
+
 void _arena_init(Arena* arena, ArenaDefaultParams params)
 {
     ArenaMemoryInfo mem_info = get_arena_memory_info();
@@ -57,117 +310,408 @@ void _arena_init(Arena* arena, ArenaDefaultParams params)
     ASSERT(params.reserved_size >= initial_alloc_size,
            "Arena reserved size must be at least %zu bytes",
            initial_alloc_size);
+    ASSERT(!(params.chained && params.concurrent),
+           "Chained arenas cannot be concurrent.");
 
+    arena->cursor            = 0;
+    arena->reserved_size     = params.reserved_size;
+    arena->alloc_granularity = mem_info.alloc_granularity;
+    arena->grow_rate         = params.grow_rate;
+    arena->concurrent        = params.concurrent;
+    arena->chained           = params.chained;
+    arena->prefault          = params.prefault;
+    arena->pages             = params.pages;
+    arena->numa_node         = params.numa_node;
+    arena->block_base        = 0;
+    arena->block             = NULL;
+    arena->spare_block       = NULL;
+    arena->peak_cursor       = 0;
+    arena->decommit_after   = params.decommit_after;
+    arena->decommit_rewinds = 0;
+    arena->window_peak      = 0;
+    arena->decommit_count   = 0;
+    arena->decommitted_size = 0;
+    arena->name             = params.name;
+    arena->commit_count     = 0;
+    arena->commit_time      = 0;
+    arena->registry_next    = NULL;
+
+    if (arena->chained) {
+        // The reserved size only limits the total size; nothing is reserved.
+        // Blocks are too small for explicit huge pages, so ask for THP.
+        if (arena->pages == ARENA_PAGES_HUGETLB) {
+            arena->pages = ARENA_PAGES_TRANSPARENT;
+        }
+        if (arena->pages == ARENA_PAGES_TRANSPARENT) {
+            arena->grow_rate = ALIGN_UP(initial_alloc_size,
+                                        ARENA_HUGE_PAGE_SIZE) /
+                               arena->alloc_granularity;
+        }
+        _arena_use_block(arena, _arena_map_block(arena, 0));
+    } else {
 #    if OS_WINDOWS
-    // Reserve the full range.
-    u8* memory = (u8*)VirtualAlloc(nullptr,
-                                   params.reserved_size,
-                                   MEM_RESERVE | MEM_COMMIT,
-                                   PAGE_READWRITE);
+        // Large pages need privileges and cannot be committed lazily.
+        arena->pages = ARENA_PAGES_NORMAL;
+
+        // Reserve the full range.
+        u8* memory = (u8*)VirtualAlloc(nullptr,
+                                       params.reserved_size,
+                                       MEM_RESERVE | MEM_COMMIT,
+                                       PAGE_READWRITE);
 
-    // Allocate the first block.
-    mem_check(
-        VirtualAlloc(memory, initial_alloc_size, MEM_COMMIT, PAGE_READWRITE));
+        // Allocate the first block.
+        TimePoint commit_start = time_now();
+        mem_check(VirtualAlloc(
+            memory, initial_alloc_size, MEM_COMMIT, PAGE_READWRITE));
+        _arena_prefault(arena, memory, initial_alloc_size);
+        TimeDuration commit_time = time_elapsed(commit_start, time_now());
 
 #    elif OS_POSIX
-    // Reserve the full range.
-    u8* memory = (u8*)mmap(nullptr,
-                           params.reserved_size,
-                           PROT_NONE,
-                           MAP_PRIVATE | MAP_ANONYMOUS,
-                           -1,
-                           0);
-    mem_check(memory);
-
-    // Allocate the first block.
-    if (mprotect(memory, initial_alloc_size, PROT_READ | PROT_WRITE) != 0) {
-        perror("mprotect");
-        exit(1);
-    }
+        // Reserve the full range.  This may change the granularity and grow
+        // rate to suit huge pages.
+        u8* memory = _arena_reserve(arena);
+        mem_check(memory);
+        _arena_bind_node(arena, memory, arena->reserved_size);
+        initial_alloc_size = arena->alloc_granularity * arena->grow_rate;
+
+        // Allocate the first block.
+        TimePoint commit_start = time_now();
+        if (mprotect(memory, initial_alloc_size, PROT_READ | PROT_WRITE) !=
+            0) {
+            perror("mprotect");
+            exit(1);
+        }
+        _arena_prefault(arena, memory, initial_alloc_size);
+        TimeDuration commit_time = time_elapsed(commit_start, time_now());
 #    else
 #        error "Arena creation not implemented for this OS."
 #    endif // OS_WINDOWS
 
-    arena->memory            = memory;
-    arena->cursor            = 0;
-    arena->committed_size    = initial_alloc_size;
-    arena->reserved_size     = params.reserved_size;
-    arena->alloc_granularity = mem_info.alloc_granularity;
-    arena->grow_rate         = params.grow_rate;
+        arena->memory         = memory;
+        arena->committed_size = initial_alloc_size;
+        arena->commit_count   = 1;
+        arena->commit_time    = commit_time;
+    }
+
+    // Pages kept warm by the decommit policy, in whole commit units.
+    arena->decommit_keep =
+        ALIGN_UP(MAX(params.decommit_keep_pages * mem_info.alloc_granularity,
+                     arena->alloc_granularity * arena->grow_rate),
+                 arena->alloc_granularity);
+
+    if (arena->concurrent) {
+        mutex_init(&arena->commit_mutex, .name = "arena_commit");
+    }
+
+    if (arena->name) {
+        mutex_lock(&g_kore_arena_registry_mutex);
+        arena->registry_next = g_arena_registry;
+        g_arena_registry     = arena;
+        mutex_unlock(&g_kore_arena_registry_mutex);
+    }
 }
 
 void arena_done(Arena* arena)
 {
+    if (arena->name) {
+        mutex_lock(&g_kore_arena_registry_mutex);
+        Arena** link = &g_arena_registry;
+        while (*link && *link != arena) {
+            link = &(*link)->registry_next;
+        }
+        if (*link) {
+            *link = arena->registry_next;
+        }
+        mutex_unlock(&g_kore_arena_registry_mutex);
+    }
+
+    if (arena->concurrent) {
+        mutex_done(&arena->commit_mutex);
+    }
+
+    if (arena->chained) {
+        ArenaBlock* block = arena->block;
+        while (block) {
+            ArenaBlock* prev = block->prev;
+            _arena_unmap_block(block);
+            block = prev;
+        }
+        if (arena->spare_block) {
+            _arena_unmap_block(arena->spare_block);
+        }
+    } else {
 #    if OS_WINDOWS
-    VirtualFree(arena->memory, 0, MEM_RELEASE);
+        VirtualFree(arena->memory, 0, MEM_RELEASE);
 #    elif OS_POSIX
-    munmap(arena->memory, arena->reserved_size);
+        munmap(arena->memory, arena->reserved_size);
 #    else
 #        error "Arena destruction not implemented for this OS."
 #    endif // OS_WINDOWS
+    }
 
     memset(arena, 0, sizeof(Arena));
 }
 
-internal void _arena_ensure_room(Arena* arena, usize size)
+//------------------------------------------------------------------------------
+
+internal void _arena_check_overflow(Arena* arena,
+                                    usize  cursor,
+                                    usize  new_cursor)
 {
-    usize new_cursor = arena->cursor + size;
     if (new_cursor > arena->reserved_size) {
         eprn("Arena overflow: requested %zu bytes, but only %zu bytes "
              "available.",
              new_cursor,
-             arena->reserved_size - arena->cursor);
+             arena->reserved_size - MIN(cursor, arena->reserved_size));
         exit(1);
     }
+}
 
-    if (new_cursor > arena->committed_size) {
-        // Need to commit more memory.
-        usize commit_size =
-            ALIGN_UP(new_cursor - arena->committed_size,
-                     arena->alloc_granularity * arena->grow_rate);
+// Commits enough pages after `committed` to cover `new_cursor` and returns the
+// new committed size.
+internal usize _arena_commit(Arena* arena, usize committed, usize new_cursor)
+{
+    usize commit_size = ALIGN_UP(new_cursor - committed,
+                                 arena->alloc_granularity * arena->grow_rate);
+    commit_size       = MIN(commit_size, arena->reserved_size - committed);
+
+    TimePoint start = time_now();
 
 #    if OS_WINDOWS
-        mem_check(VirtualAlloc(arena->memory + arena->committed_size,
-                               commit_size,
-                               MEM_COMMIT,
-                               PAGE_READWRITE));
+    mem_check(VirtualAlloc(
+        arena->memory + committed, commit_size, MEM_COMMIT, PAGE_READWRITE));
 #    elif OS_POSIX
-        if (mprotect(arena->memory + arena->committed_size,
-                     commit_size,
-                     PROT_READ | PROT_WRITE) != 0) {
-            perror("mprotect");
-            exit(1);
-        }
+    if (mprotect(arena->memory + committed,
+                 commit_size,
+                 PROT_READ | PROT_WRITE) != 0) {
+        perror("mprotect");
+        exit(1);
+    }
 #    else
 #        error "Arena memory commit not implemented for this OS."
 #    endif // OS_WINDOWS
 
-        arena->committed_size += commit_size;
+    _arena_prefault(arena, arena->memory + committed, commit_size);
+
+    arena->commit_count++;
+    arena->commit_time += time_elapsed(start, time_now());
+
+    return committed + commit_size;
+}
+
+// Moves a chained arena on to a new block with room for `size` bytes, reusing
+// the spare block if it is large enough.
+internal void _arena_chain_block(Arena* arena, usize size)
+{
+    usize base = ALIGN_UP(arena->committed_size, arena->alloc_granularity);
+    _arena_check_overflow(arena, arena->cursor, base + size);
+
+    ArenaBlock* block  = arena->spare_block;
+    arena->spare_block = NULL;
+    if (block && block->capacity < size) {
+        arena->decommit_count++;
+        arena->decommitted_size += block->mapped;
+        _arena_unmap_block(block);
+        block = NULL;
+    }
+    if (!block) {
+        block = _arena_map_block(arena, size);
+    }
+
+    block->prev = arena->block;
+    block->base = base;
+    _arena_use_block(arena, block);
+    arena->cursor = base;
+}
+
+// Releases every block that starts after `cursor`.  The lowest released block
+// is kept as a spare so that a workload that keeps crossing the same boundary
+// does not map and unmap on every pass.
+internal void _arena_release_blocks(Arena* arena, usize cursor)
+{
+    ArenaBlock* block = arena->block;
+    if (cursor >= block->base) {
+        return;
+    }
+
+    while (cursor < block->base) {
+        ArenaBlock* prev = block->prev;
+        if (arena->spare_block) {
+            arena->decommit_count++;
+            arena->decommitted_size += arena->spare_block->mapped;
+            _arena_unmap_block(arena->spare_block);
+        }
+        arena->spare_block = block;
+        block              = prev;
     }
+
+    _arena_use_block(arena, block);
+}
+
+internal void _arena_ensure_room(Arena* arena, usize size)
+{
+    usize new_cursor = arena->cursor + size;
+    _arena_check_overflow(arena, arena->cursor, new_cursor);
+
+    if (new_cursor > arena->committed_size) {
+        if (arena->chained) {
+            _arena_chain_block(arena, size);
+        } else {
+            // Need to commit more memory.
+            arena->committed_size =
+                _arena_commit(arena, arena->committed_size, new_cursor);
+        }
+    }
+}
+
+// Makes sure a concurrent arena is committed up to `end`.
+internal void _arena_ensure_committed_concurrent(Arena* arena, usize end)
+{
+    if (end > atomic_load_usize(&arena->committed_size, MEMORY_ACQUIRE)) {
+        // Rare path: another thread may have committed while we waited.
+        mutex_lock(&arena->commit_mutex);
+        usize committed = arena->committed_size;
+        if (end > committed) {
+            atomic_store_usize(&arena->committed_size,
+                               _arena_commit(arena, committed, end),
+                               MEMORY_RELEASE);
+        }
+        mutex_unlock(&arena->commit_mutex);
+    }
+}
+
+// Lock-free bump allocation for concurrent arenas.  Alignment is handled by
+// over-allocating so that the cursor only ever moves with a single fetch-add.
+internal void* _arena_alloc_concurrent(Arena* arena, usize size, usize align)
+{
+    usize padding = align > 1 ? align - 1 : 0;
+    usize start   =
+        atomic_fetch_add_usize(&arena->cursor, size + padding, MEMORY_RELAXED);
+    usize offset  = align > 1 ? ALIGN_UP(start, align) : start;
+    usize end     = offset + size;
+
+    _arena_check_overflow(arena, start, start + size + padding);
+    _arena_ensure_committed_concurrent(arena, end);
+
+    return arena->memory + offset;
 }
 
 void* arena_alloc(Arena* arena, usize size)
 {
+    if (arena->concurrent) {
+        return _arena_alloc_concurrent(arena, size, 1);
+    }
+
     _arena_ensure_room(arena, size);
 
-    void* ptr = arena->memory + arena->cursor;
+    void* ptr = arena->memory + (arena->cursor - arena->block_base);
     arena->cursor += size;
     return ptr;
 }
 
 void arena_align(Arena* arena, usize align)
 {
+    // Aligning a shared cursor is meaningless, as another thread can allocate
+    // between the align and the alloc.
+    ASSERT(!arena->concurrent, "Use arena_alloc_align() on concurrent arenas.");
+    ASSERT(!arena->chained || align <= arena->alloc_granularity,
+           "Chained arenas cannot align beyond the page size.");
+
     usize aligned_cursor = ALIGN_UP(arena->cursor, align);
+    if (arena->chained && aligned_cursor > arena->committed_size) {
+        // The padding runs off the block.  The next block starts page
+        // aligned, so point the cursor at its start and let the next
+        // allocation map it at the size it needs, rather than mapping one now
+        // to hold nothing but padding.
+        aligned_cursor =
+            ALIGN_UP(arena->committed_size, arena->alloc_granularity);
+        _arena_check_overflow(arena, arena->cursor, aligned_cursor);
+        arena->cursor = aligned_cursor;
+        return;
+    }
+
     _arena_ensure_room(arena, aligned_cursor - arena->cursor);
     arena->cursor = aligned_cursor;
 }
 
 void* arena_alloc_align(Arena* arena, usize size, usize align)
 {
+    if (arena->concurrent) {
+        return _arena_alloc_concurrent(arena, size, align);
+    }
+
     arena_align(arena, align);
     return arena_alloc(arena, size);
 }
 
+// Moves the cursor from `old_end` to `new_end` if the allocation ending at
+// `old_end` is still the last one.  Growing never moves a chained arena on to
+// a new block.
+internal bool _arena_resize_last(Arena* arena, usize old_end, usize new_end)
+{
+    if (arena->concurrent) {
+        if (new_end > old_end) {
+            _arena_check_overflow(arena, old_end, new_end);
+        }
+        if (!atomic_cas_usize(
+                &arena->cursor, &old_end, new_end, MEMORY_RELAXED)) {
+            return false;
+        }
+        _arena_ensure_committed_concurrent(arena, new_end);
+        return true;
+    }
+
+    if (arena->cursor != old_end) {
+        return false;
+    }
+
+    if (new_end > old_end) {
+        if (arena->chained && new_end > arena->committed_size) {
+            return false;
+        }
+        _arena_ensure_room(arena, new_end - old_end);
+    } else {
+        arena->peak_cursor = MAX(arena->peak_cursor, old_end);
+    }
+
+    arena->cursor = new_end;
+    return true;
+}
+
+// Cursor position just past an allocation of `size` bytes at `ptr`.
+internal usize _arena_end_of(Arena* arena, void* ptr, usize size)
+{
+    return arena->block_base + (usize)((u8*)ptr - arena->memory) + size;
+}
+
+void* arena_realloc(Arena* arena, void* ptr, usize old_size, usize new_size)
+{
+    if (!ptr) {
+        return arena_alloc_align(arena, new_size, alignof(max_align_t));
+    }
+
+    usize old_end = _arena_end_of(arena, ptr, old_size);
+    if (_arena_resize_last(arena, old_end, old_end - old_size + new_size)) {
+        return ptr;
+    }
+
+    if (new_size <= old_size) {
+        // Not the last allocation, but shrinking in place is still valid.
+        return ptr;
+    }
+
+    void* new_ptr = arena_alloc_align(arena, new_size, alignof(max_align_t));
+    memcpy(new_ptr, ptr, old_size);
+    return new_ptr;
+}
+
+bool arena_shrink_last(Arena* arena, void* ptr, usize old_size, usize new_size)
+{
+    ASSERT(new_size <= old_size, "arena_shrink_last cannot grow.");
+    usize old_end = _arena_end_of(arena, ptr, old_size);
+    return _arena_resize_last(arena, old_end, old_end - old_size + new_size);
+}
+
 u8* arena_formatv(Arena* arena, cstr fmt, va_list args)
 {
     // Get the size of the formatted string.
@@ -181,7 +725,9 @@ u8* arena_formatv(Arena* arena, cstr fmt, va_list args)
 
     // Format the string into the buffer.
     vsnprintf((char*)buffer, (usize)size + 1, fmt, args);
-    arena->cursor--; // Remove null terminator from arena allocation
+
+    // Remove null terminator from arena allocation
+    arena_shrink_last(arena, buffer, (usize)size + 1, (usize)size);
 
     return buffer;
 }
@@ -201,19 +747,236 @@ void arena_null_terminate(Arena* arena)
     *ptr    = '\0';
 }
 
-u64 arena_store(Arena* arena) { return (u64)arena->cursor; }
+u64 arena_store(Arena* arena)
+{
+    if (arena->concurrent) {
+        return (u64)atomic_load_usize(&arena->cursor, MEMORY_ACQUIRE);
+    }
+    return (u64)arena->cursor;
+}
+
+// Returns committed pages from `new_committed` upwards to the OS.
+internal void _arena_decommit(Arena* arena, usize new_committed)
+{
+    u8*   start = arena->memory + new_committed;
+    usize size  = arena->committed_size - new_committed;
+
+#    if OS_WINDOWS
+    VirtualFree(start, size, MEM_DECOMMIT);
+#    elif OS_POSIX
+    // Drop the physical pages and make the range inaccessible again so that
+    // any stale pointer into it faults rather than silently re-committing.
+    madvise(start, size, MADV_DONTNEED);
+    if (mprotect(start, size, PROT_NONE) != 0) {
+        perror("mprotect");
+        exit(1);
+    }
+#    else
+#        error "Arena memory decommit not implemented for this OS."
+#    endif // OS_WINDOWS
+
+    arena->committed_size = new_committed;
+    arena->decommit_count++;
+    arena->decommitted_size += size;
+}
+
+// Called whenever the cursor moves backwards.  Tracks the high-water marks and
+// applies the decommit policy.
+internal void _arena_rewind(Arena* arena, usize new_cursor)
+{
+    usize old_cursor   = arena->cursor;
+    arena->cursor      = new_cursor;
+    arena->peak_cursor = MAX(arena->peak_cursor, old_cursor);
+
+    if (arena->chained) {
+        _arena_release_blocks(arena, new_cursor);
+        return;
+    }
+
+    if (arena->decommit_after == 0) {
+        return;
+    }
+
+    arena->window_peak = MAX(arena->window_peak, old_cursor);
+    if (++arena->decommit_rewinds < arena->decommit_after) {
+        return;
+    }
+
+    usize keep = MAX(arena->decommit_keep,
+                     ALIGN_UP(MAX(arena->window_peak, new_cursor),
+                              arena->alloc_granularity));
+    if (arena->committed_size > keep) {
+        _arena_decommit(arena, keep);
+    }
+
+    arena->decommit_rewinds = 0;
+    arena->window_peak      = 0;
+}
 
 void arena_restore(Arena* arena, u64 mark)
 {
     ASSERT(mark <= arena->cursor, "Invalid arena restore point.");
-    arena->cursor = (usize)mark;
+    _arena_rewind(arena, (usize)mark);
 }
 
-void arena_reset(Arena* arena) { arena->cursor = 0; }
+void arena_reset(Arena* arena) { _arena_rewind(arena, 0); }
 
 u32 arena_offset(Arena* arena, void* p)
 {
-    return (u32)((u8*)p - arena->memory);
+    usize offset = (usize)((u8*)p - arena->memory);
+#    if CONFIG_DEBUG
+    ASSERT(offset <= UINT32_MAX,
+           "Arena offset %zu does not fit in 32 bits; use arena_ref64.",
+           offset);
+#    endif // CONFIG_DEBUG
+    return (u32)offset;
+}
+
+u64 _arena_ref(Arena* arena, const void* p, u64 limit)
+{
+    u64 offset = (u64)((const u8*)p - arena->memory);
+#    if CONFIG_DEBUG
+    ASSERT(!arena->chained, "Chained arenas cannot be referenced into.");
+    ASSERT((const u8*)p >= arena->memory && offset < arena_store(arena),
+           "Pointer %p is outside the arena's used memory.",
+           p);
+    ASSERT(offset <= limit,
+           "Arena offset %llu does not fit in the reference.",
+           (unsigned long long)offset);
+#    else
+    UNUSED(limit);
+#    endif // CONFIG_DEBUG
+    return offset;
+}
+
+void* _arena_ref_resolve(Arena* arena, u64 offset)
+{
+#    if CONFIG_DEBUG
+    ASSERT(!arena->chained, "Chained arenas cannot be referenced into.");
+    ASSERT(offset < arena_store(arena),
+           "Reference %llu is beyond the arena's used memory.",
+           (unsigned long long)offset);
+#    endif // CONFIG_DEBUG
+    return arena->memory + offset;
+}
+
+ArenaStats arena_stats(Arena* arena)
+{
+    usize cursor    = (usize)arena_store(arena);
+    usize committed = arena->committed_size;
+    usize reserved  = arena->reserved_size;
+
+    if (arena->chained) {
+        // Only what has been mapped counts; nothing is reserved up front.
+        committed = arena->spare_block ? arena->spare_block->mapped : 0;
+        for (ArenaBlock* block = arena->block; block; block = block->prev) {
+            committed += block->mapped;
+        }
+        reserved = committed;
+    }
+
+    return (ArenaStats){
+        .used           = cursor,
+        .peak           = MAX(arena->peak_cursor, cursor),
+        .committed      = committed,
+        .reserved       = reserved,
+        .decommit_count = arena->decommit_count,
+        .decommitted    = arena->decommitted_size,
+        .commit_count   = arena->commit_count,
+        .commit_time    = arena->commit_time,
+    };
+}
+
+//------------------------------------------------------------------------------
+// Arena registry
+
+usize arena_registry_count(void)
+{
+    usize count = 0;
+    mutex_lock(&g_kore_arena_registry_mutex);
+    for (Arena* arena = g_arena_registry; arena; arena = arena->registry_next) {
+        count++;
+    }
+    mutex_unlock(&g_kore_arena_registry_mutex);
+    return count;
+}
+
+void arena_registry_print(void)
+{
+    mutex_lock(&g_kore_arena_registry_mutex);
+
+    prn(ANSI_BOLD "%-20s %14s %14s %14s %14s %8s %12s %10s" ANSI_RESET,
+        "Arena",
+        "Reserved",
+        "Committed",
+        "Used",
+        "Peak",
+        "Commits",
+        "Commit (us)",
+        "Decommits");
+
+    for (Arena* arena = g_arena_registry; arena; arena = arena->registry_next) {
+        ArenaStats stats = arena_stats(arena);
+        prn("%-20s %14zu %14zu %14zu %14zu %8zu %12llu %10zu",
+            arena->name,
+            stats.reserved,
+            stats.committed,
+            stats.used,
+            stats.peak,
+            stats.commit_count,
+            (unsigned long long)time_duration_to_us(stats.commit_time),
+            stats.decommit_count);
+    }
+
+    mutex_unlock(&g_kore_arena_registry_mutex);
+}
+
+internal void _arena_json_string(StringBuilder* sb, cstr text)
+{
+    sb_append_char(sb, '"');
+    for (cstr p = text; *p; ++p) {
+        if (*p == '"' || *p == '\\') {
+            sb_append_char(sb, '\\');
+        }
+        sb_append_char(sb, *p);
+    }
+    sb_append_char(sb, '"');
+}
+
+u8* arena_registry_json(Arena* arena)
+{
+    StringBuilder sb;
+    sb_init(&sb, arena);
+    sb_append_char(&sb, '[');
+
+    mutex_lock(&g_kore_arena_registry_mutex);
+    for (Arena* entry = g_arena_registry; entry; entry = entry->registry_next) {
+        // Sample before writing so that the output arena reports consistently.
+        ArenaStats stats = arena_stats(entry);
+
+        if (entry != g_arena_registry) {
+            sb_append_char(&sb, ',');
+        }
+        sb_append_cstr(&sb, "{\"name\":");
+        _arena_json_string(&sb, entry->name);
+        sb_format(&sb,
+                  ",\"reserved\":%zu,\"committed\":%zu,\"used\":%zu"
+                  ",\"peak\":%zu,\"commit_count\":%zu,\"commit_ns\":%llu"
+                  ",\"decommit_count\":%zu,\"decommitted\":%zu}",
+                  stats.reserved,
+                  stats.committed,
+                  stats.used,
+                  stats.peak,
+                  stats.commit_count,
+                  (unsigned long long)time_duration_to_ns(stats.commit_time),
+                  stats.decommit_count,
+                  stats.decommitted);
+    }
+    mutex_unlock(&g_kore_arena_registry_mutex);
+
+    sb_append_char(&sb, ']');
+    sb_append_null(&sb);
+    return sb.data;
 }
 
 //------------------------------------------------------------------------------
@@ -238,8 +1001,17 @@ void arena_session_undo(ArenaSession* session)
 
 void* arena_session_alloc(ArenaSession* session, usize count)
 {
-    void* ptr = arena_alloc_align(
-        session->arena, count * session->element_size, session->alignment);
+    Arena* arena = session->arena;
+    void*  ptr   = arena_alloc_align(
+        arena, count * session->element_size, session->alignment);
+
+    if (arena->chained && session->start < arena->block_base) {
+        // The arena moved to a new block; only an empty session can follow.
+        ASSERT(session->count == 0,
+               "Arena session outgrew a chained arena block.");
+        session->start = arena->block_base;
+    }
+
     session->count += count;
     return ptr;
 }
@@ -248,5 +1020,64 @@ usize arena_session_count(ArenaSession* session) { return session->count; }
 
 void* arena_session_address(ArenaSession* session)
 {
-    return session->arena->memory + session->start;
+    Arena* arena = session->arena;
+    return arena->memory + (session->start - arena->block_base);
+}
+
+//------------------------------------------------------------------------------
+// Scratch arenas
+
+thread_local global_variable Arena g_scratch_arenas[ARENA_SCRATCH_COUNT];
+
+// Set swapped in by _scratch_use(), or NULL for the thread's own.
+thread_local global_variable Arena* g_scratch_set      = NULL;
+thread_local global_variable usize  g_scratch_reserved = 0;
+
+void _scratch_use(Arena* arenas, usize reserved_size)
+{
+    g_scratch_set      = arenas;
+    g_scratch_reserved = reserved_size;
+}
+
+ArenaScratch _scratch_begin(Arena** conflicts, usize count)
+{
+    Arena* arenas = g_scratch_set ? g_scratch_set : g_scratch_arenas;
+    for (usize i = 0; i < ARENA_SCRATCH_COUNT; ++i) {
+        Arena* arena       = &arenas[i];
+        bool   conflicting = false;
+        for (usize j = 0; j < count; ++j) {
+            if (conflicts[j] == arena) {
+                conflicting = true;
+                break;
+            }
+        }
+
+        if (!conflicting) {
+            if (!arena->memory) {
+                arena_init(arena,
+                           .reserved_size = g_scratch_reserved,
+                           .numa_node     = thread_pinned_node());
+            }
+            return (ArenaScratch){.arena = arena, .mark = arena_store(arena)};
+        }
+    }
+
+    ASSERT(false,
+           "No free scratch arena: more than %d conflicts.",
+           ARENA_SCRATCH_COUNT - 1);
+    return (ArenaScratch){0};
+}
+
+void scratch_end(ArenaScratch scratch)
+{
+    arena_restore(scratch.arena, scratch.mark);
+}
+
+void scratch_done(void)
+{
+    for (usize i = 0; i < ARENA_SCRATCH_COUNT; ++i) {
+        if (g_scratch_arenas[i].memory) {
+            arena_done(&g_scratch_arenas[i]);
+        }
+    }
 }
@@ -0,0 +1,46 @@
+//------------------------------------------------------------------------------
+// Sharded counters
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+
+#include <core/core.h>
+
+//------------------------------------------------------------------------------
+
+global_variable u32 g_counter_next_shard = 0;
+
+// Shard used by this thread, plus 1 (0 until the thread first adds).
+thread_local global_variable u32 g_counter_shard = 0;
+
+internal u32 _counter_shard(void)
+{
+    if (g_counter_shard == 0) {
+        u32 shard =
+            atomic_fetch_add_u32(&g_counter_next_shard, 1, MEMORY_RELAXED);
+        g_counter_shard = shard % SHARDED_COUNTER_SHARDS + 1;
+    }
+    return g_counter_shard - 1;
+}
+
+void sharded_counter_add(ShardedCounter* counter, u64 amount)
+{
+    atomic_fetch_add_u64(
+        &counter->shards[_counter_shard()].value, amount, MEMORY_RELAXED);
+}
+
+u64 sharded_counter_read(ShardedCounter* counter)
+{
+    u64 total = 0;
+    for (usize i = 0; i < SHARDED_COUNTER_SHARDS; ++i) {
+        total += atomic_load_u64(&counter->shards[i].value, MEMORY_RELAXED);
+    }
+    return total;
+}
+
+void sharded_counter_reset(ShardedCounter* counter)
+{
+    for (usize i = 0; i < SHARDED_COUNTER_SHARDS; ++i) {
+        atomic_store_u64(&counter->shards[i].value, 0, MEMORY_RELAXED);
+    }
+}
@@ -0,0 +1,372 @@
+//------------------------------------------------------------------------------
+// Blocking bounded channels
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+
+#include <core/core.h>
+
+//------------------------------------------------------------------------------
+// Deadlines
+
+internal TimePoint _channel_deadline(TimeDuration timeout)
+{
+    return timeout == CHANNEL_FOREVER ? CHANNEL_FOREVER
+                                      : time_add_duration(time_now(), timeout);
+}
+
+internal bool _channel_expired(TimePoint deadline)
+{
+    return deadline != CHANNEL_FOREVER && time_now() >= deadline;
+}
+
+//------------------------------------------------------------------------------
+// Waiter lists
+//
+// Lists are only touched with the channel's lock held.  A waker unlinks the
+// waiter before setting its futex word, and a waiter always takes the lock
+// again before returning, so a waiter on the stack outlives every access.
+
+internal void _channel_link(ChannelWaiter** list, ChannelWaiter* waiter)
+{
+    // Append so that waiters are woken in arrival order.
+    ChannelWaiter** link = list;
+    ChannelWaiter*  prev = NULL;
+    while (*link) {
+        prev = *link;
+        link = &(*link)->next;
+    }
+    waiter->next   = NULL;
+    waiter->prev   = prev;
+    waiter->linked = true;
+    *link          = waiter;
+}
+
+internal void _channel_unlink(ChannelWaiter** list, ChannelWaiter* waiter)
+{
+    if (waiter->prev) {
+        waiter->prev->next = waiter->next;
+    } else {
+        *list = waiter->next;
+    }
+    if (waiter->next) {
+        waiter->next->prev = waiter->prev;
+    }
+    waiter->linked = false;
+}
+
+// Wakes up to `count` plain waiters and every select waiter, which may be
+// about to take an element from another channel instead.
+internal void _channel_wake(ChannelWaiter** list, usize count)
+{
+    ChannelWaiter* waiter = *list;
+    while (waiter) {
+        ChannelWaiter* next = waiter->next;
+        if (waiter->select || count > 0) {
+            count -= !waiter->select;
+            _channel_unlink(list, waiter);
+            atomic_store_u32(waiter->woken, 1, MEMORY_RELEASE);
+            if (waiter->fiber) {
+                fiber_unpark(waiter->fiber);
+            } else {
+                futex_wake_one(waiter->woken);
+            }
+        }
+        waiter = next;
+    }
+}
+
+// Sleeps until `*woken` is set or the deadline passes.  A fiber parks instead,
+// leaving the thread free to run other fibers.
+internal void _channel_sleep(u32* woken, TimePoint deadline)
+{
+    bool in_fiber = fiber_current() != NULL;
+    while (!atomic_load_u32(woken, MEMORY_ACQUIRE)) {
+        if (in_fiber) {
+            if (!fiber_park_until(deadline)) {
+                break;
+            }
+            continue;
+        }
+        if (deadline == CHANNEL_FOREVER) {
+            futex_wait(woken, 0);
+            continue;
+        }
+        TimePoint now = time_now();
+        if (now >= deadline) {
+            break;
+        }
+        futex_wait_timeout(woken, 0, time_elapsed(now, deadline));
+    }
+}
+
+// Waits on one of the channel's lists, dropping the lock while asleep.
+internal void _channel_wait(Channel*        channel,
+                            ChannelWaiter** list,
+                            TimePoint       deadline)
+{
+    u32           woken  = 0;
+    ChannelWaiter waiter = {.woken = &woken, .fiber = fiber_current()};
+    _channel_link(list, &waiter);
+
+    adaptive_mutex_unlock(&channel->lock);
+    _channel_sleep(&woken, deadline);
+    adaptive_mutex_lock(&channel->lock);
+
+    if (waiter.linked) {
+        _channel_unlink(list, &waiter);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Ring transfer, with the lock held
+
+internal usize _channel_put(Channel* channel, const u8* elements, usize count)
+{
+    count = MIN(count, channel->capacity - channel->count);
+    if (count == 0) {
+        return 0;
+    }
+
+    usize size  = channel->element_size;
+    usize tail  = (channel->head + channel->count) % channel->capacity;
+    usize first = MIN(count, channel->capacity - tail);
+    memcpy(channel->buffer + tail * size, elements, first * size);
+    memcpy(channel->buffer, elements + first * size, (count - first) * size);
+    channel->count += count;
+
+    _channel_wake(&channel->receivers, count);
+    return count;
+}
+
+internal usize _channel_take(Channel* channel, u8* elements, usize count)
+{
+    count = MIN(count, channel->count);
+    if (count == 0) {
+        return 0;
+    }
+
+    usize size  = channel->element_size;
+    usize first = MIN(count, channel->capacity - channel->head);
+    memcpy(elements, channel->buffer + channel->head * size, first * size);
+    memcpy(elements + first * size, channel->buffer, (count - first) * size);
+    channel->head = (channel->head + count) % channel->capacity;
+    channel->count -= count;
+
+    _channel_wake(&channel->senders, count);
+    return count;
+}
+
+//------------------------------------------------------------------------------
+
+void channel_init(Channel* channel,
+                  Arena*   arena,
+                  usize    capacity,
+                  usize    element_size)
+{
+    memset(channel, 0, sizeof(*channel));
+    adaptive_mutex_init(&channel->lock, .name = "channel");
+    channel->capacity     = MAX(capacity, 1);
+    channel->element_size = element_size;
+    channel->buffer = arena_alloc(arena, channel->capacity * element_size);
+}
+
+void channel_done(Channel* channel)
+{
+    ASSERT(!channel->receivers && !channel->senders,
+           "Channel destroyed with threads waiting on it.");
+    adaptive_mutex_done(&channel->lock);
+}
+
+void channel_close(Channel* channel)
+{
+    adaptive_mutex_lock(&channel->lock);
+    channel->closed = true;
+    _channel_wake(&channel->receivers, SIZE_MAX);
+    _channel_wake(&channel->senders, SIZE_MAX);
+    adaptive_mutex_unlock(&channel->lock);
+}
+
+//------------------------------------------------------------------------------
+// Sending
+
+internal usize _channel_send_until(Channel*    channel,
+                                   const void* elements,
+                                   usize       count,
+                                   usize       size,
+                                   TimePoint   deadline)
+{
+    ASSERT(size == channel->element_size, "Element size mismatch.");
+
+    const u8* data = elements;
+    usize     sent = 0;
+    adaptive_mutex_lock(&channel->lock);
+    while (!channel->closed) {
+        sent += _channel_put(channel, data + sent * size, count - sent);
+        if (sent == count || _channel_expired(deadline)) {
+            break;
+        }
+        _channel_wait(channel, &channel->senders, deadline);
+    }
+    adaptive_mutex_unlock(&channel->lock);
+    return sent;
+}
+
+bool _channel_send(Channel* channel, const void* element, usize size)
+{
+    usize sent =
+        _channel_send_until(channel, element, 1, size, CHANNEL_FOREVER);
+    return sent == 1;
+}
+
+bool _channel_try_send(Channel* channel, const void* element, usize size)
+{
+    return _channel_send_until(channel, element, 1, size, 0) == 1;
+}
+
+usize _channel_send_batch(Channel*    channel,
+                          const void* elements,
+                          usize       count,
+                          usize       size)
+{
+    return _channel_send_until(
+        channel, elements, count, size, CHANNEL_FOREVER);
+}
+
+//------------------------------------------------------------------------------
+// Receiving
+
+internal ChannelResult _channel_recv_until(Channel*  channel,
+                                           void*     elements,
+                                           usize     count,
+                                           usize     size,
+                                           usize*    received,
+                                           TimePoint deadline)
+{
+    ASSERT(size == channel->element_size, "Element size mismatch.");
+
+    ChannelResult result;
+    adaptive_mutex_lock(&channel->lock);
+    for (;;) {
+        *received = _channel_take(channel, elements, count);
+        if (*received) {
+            result = CHANNEL_OK;
+            break;
+        }
+        if (channel->closed) {
+            result = CHANNEL_CLOSED;
+            break;
+        }
+        if (_channel_expired(deadline)) {
+            result = CHANNEL_TIMEOUT;
+            break;
+        }
+        _channel_wait(channel, &channel->receivers, deadline);
+    }
+    adaptive_mutex_unlock(&channel->lock);
+    return result;
+}
+
+bool _channel_recv(Channel* channel, void* element, usize size)
+{
+    usize         received;
+    ChannelResult result = _channel_recv_until(
+        channel, element, 1, size, &received, CHANNEL_FOREVER);
+    return result == CHANNEL_OK;
+}
+
+bool _channel_try_recv(Channel* channel, void* element, usize size)
+{
+    usize         received;
+    ChannelResult result =
+        _channel_recv_until(channel, element, 1, size, &received, 0);
+    return result == CHANNEL_OK;
+}
+
+ChannelResult _channel_recv_timeout(Channel*     channel,
+                                    void*        element,
+                                    usize        size,
+                                    TimeDuration timeout)
+{
+    usize received;
+    return _channel_recv_until(
+        channel, element, 1, size, &received, _channel_deadline(timeout));
+}
+
+usize _channel_recv_batch(Channel* channel,
+                          void*    elements,
+                          usize    count,
+                          usize    size)
+{
+    usize received;
+    _channel_recv_until(
+        channel, elements, count, size, &received, CHANNEL_FOREVER);
+    return received;
+}
+
+//------------------------------------------------------------------------------
+// Select
+
+internal void _channel_select_unlink(Channel**      channels,
+                                     ChannelWaiter* links,
+                                     usize          count)
+{
+    for (usize i = 0; i < count; ++i) {
+        adaptive_mutex_lock(&channels[i]->lock);
+        if (links[i].linked) {
+            _channel_unlink(&channels[i]->receivers, &links[i]);
+        }
+        adaptive_mutex_unlock(&channels[i]->lock);
+    }
+}
+
+ChannelResult channel_select(Channel**    channels,
+                             usize        count,
+                             void*        element,
+                             usize*       index,
+                             TimeDuration timeout)
+{
+    ASSERT(count <= CHANNEL_SELECT_MAX, "Too many channels to select.");
+
+    TimePoint     deadline = _channel_deadline(timeout);
+    Fiber*        fiber    = fiber_current();
+    ChannelWaiter links[CHANNEL_SELECT_MAX];
+    for (;;) {
+        // Poll each channel in turn, and wait on every open one that is empty
+        // so that a send to any of them wakes us.
+        u32   woken  = 0;
+        usize closed = 0;
+        for (usize i = 0; i < count; ++i) {
+            Channel* channel = channels[i];
+            links[i] = (ChannelWaiter){
+                .woken = &woken, .fiber = fiber, .select = true};
+
+            adaptive_mutex_lock(&channel->lock);
+            if (_channel_take(channel, element, 1)) {
+                adaptive_mutex_unlock(&channel->lock);
+                _channel_select_unlink(channels, links, i);
+                *index = i;
+                return CHANNEL_OK;
+            }
+            if (channel->closed) {
+                closed++;
+            } else {
+                _channel_link(&channel->receivers, &links[i]);
+            }
+            adaptive_mutex_unlock(&channel->lock);
+        }
+
+        bool expired = closed == count || _channel_expired(deadline);
+        if (!expired) {
+            _channel_sleep(&woken, deadline);
+        }
+        _channel_select_unlink(channels, links, count);
+
+        if (closed == count) {
+            return CHANNEL_CLOSED;
+        }
+        if (expired) {
+            return CHANNEL_TIMEOUT;
+        }
+    }
+}
@@ -26,10 +26,22 @@
 // [Library]            Library initialisation and shutdown
 // [Memory]             Memory management functions
 // [Array]              Dynamic array implementation
+// [Atomic]             Atomics, cache-line layout and sharded counters
 // [Mutex]              Simple locking for resource protection
-// [Output]             Basic output to stdout and stderr
+// [Output]             Buffered per-thread output to stdout and stderr
 // [Arena]              Memory management via arenas and paging
+// [Pool]               Fixed-size object pools carved from arenas
+// [Heap]               General-purpose TLSF allocator in a reserved range
+// [Thread]             Threads and a fixed-size thread pool
+// [Job]                Work-stealing job system with dependencies
+// [Parallel]           Data-parallel for, reduce, scan, sort and partition
+// [Queue]              Lock-free bounded SPSC and MPMC queues
+// [Epoch]              Epoch-based reclamation for lock-free structures
+// [Snapshot]           Seqlocks and RCU-style publishing for read-mostly data
 // [Time]               Various cross-platform functions for handling time
+// [Timer]              Hierarchical timer wheel for large numbers of deadlines
+// [Fiber]              Stackful fibers with guard-paged stacks and a scheduler
+// [Channel]            Blocking bounded channels with timeouts and select
 // [Random]             Some simple routines for random number generation
 // [Data]               Simple file-mapped routines
 // [String]             String views and builder
@@ -354,18 +366,391 @@ void* array_maybe_grow(void* array,
 
 #define array_leak(a) mem_leak(__array_info(a))
 
+//------------------------------------------------------------------------------[Atomic]
+
+// Typed wrappers over C23 <stdatomic.h> with an explicit memory order on every
+// call.  They operate on plain integers and pointers, so structures keep their
+// ordinary field types and zero-initialisation, and only the accesses that race
+// need to go through these.  MSVC needs /experimental:c11atomics.
+//
+//      u32 state = 0;
+//      if (atomic_cas_u32(&state, &expected, 1, MEMORY_ACQUIRE)) { ... }
+//
+// The compare-and-swap is strong; on failure it writes the current value to
+// `*expected`.  Its failure order is the strongest one allowed for `order`.
+
+#include <stdatomic.h>
+
+typedef memory_order MemoryOrder;
+
+#define MEMORY_RELAXED memory_order_relaxed
+#define MEMORY_ACQUIRE memory_order_acquire
+#define MEMORY_RELEASE memory_order_release
+#define MEMORY_ACQ_REL memory_order_acq_rel
+#define MEMORY_SEQ_CST memory_order_seq_cst
+
+#define _ATOMIC_FAILURE_ORDER(order)                                           \
+    ((order) == MEMORY_RELEASE   ? MEMORY_RELAXED                              \
+     : (order) == MEMORY_ACQ_REL ? MEMORY_ACQUIRE                              \
+                                 : (order))
+
+#define DEF_ATOMIC(T, name)                                                    \
+    static inline T atomic_load_##name(T* value, MemoryOrder order)            \
+    {                                                                          \
+        return atomic_load_explicit((_Atomic(T)*)value, order);                \
+    }                                                                          \
+    static inline void atomic_store_##name(                                    \
+        T* value, T new_value, MemoryOrder order)                              \
+    {                                                                          \
+        atomic_store_explicit((_Atomic(T)*)value, new_value, order);           \
+    }                                                                          \
+    static inline T atomic_exchange_##name(                                    \
+        T* value, T new_value, MemoryOrder order)                              \
+    {                                                                          \
+        return atomic_exchange_explicit((_Atomic(T)*)value, new_value, order); \
+    }                                                                          \
+    static inline bool atomic_cas_##name(                                      \
+        T* value, T* expected, T desired, MemoryOrder order)                   \
+    {                                                                          \
+        return atomic_compare_exchange_strong_explicit(                        \
+            (_Atomic(T)*)value,                                                \
+            expected,                                                          \
+            desired,                                                           \
+            order,                                                             \
+            _ATOMIC_FAILURE_ORDER(order));                                     \
+    }
+
+#define DEF_ATOMIC_ARITHMETIC(T, name)                                         \
+    DEF_ATOMIC(T, name)                                                        \
+    static inline T atomic_fetch_add_##name(                                   \
+        T* value, T amount, MemoryOrder order)                                 \
+    {                                                                          \
+        return atomic_fetch_add_explicit((_Atomic(T)*)value, amount, order);   \
+    }                                                                          \
+    static inline T atomic_fetch_sub_##name(                                   \
+        T* value, T amount, MemoryOrder order)                                 \
+    {                                                                          \
+        return atomic_fetch_sub_explicit((_Atomic(T)*)value, amount, order);   \
+    }
+
+DEF_ATOMIC_ARITHMETIC(u32, u32)
+DEF_ATOMIC_ARITHMETIC(u64, u64)
+DEF_ATOMIC_ARITHMETIC(i64, i64)
+DEF_ATOMIC_ARITHMETIC(usize, usize)
+DEF_ATOMIC(bool, bool)
+DEF_ATOMIC(void*, ptr)
+
+static inline void atomic_fence(MemoryOrder order)
+{
+    atomic_thread_fence(order);
+}
+
+// CPU_RELAX() tells the core it is in a spin-wait loop, which saves power and
+// frees execution resources for a sibling hyperthread.
+#if COMPILER_MSVC
+#    define CPU_RELAX() YieldProcessor()
+#elif ARCH_X86 || ARCH_X86_64
+#    define CPU_RELAX() __builtin_ia32_pause()
+#elif ARCH_ARM || ARCH_ARM64
+#    define CPU_RELAX() __asm__ volatile("yield")
+#else
+#    define CPU_RELAX() ((void)0)
+#endif
+
+//
+// Cache-line layout
+//
+// Data written by different threads should not share a cache line, or each
+// write invalidates the line in every other core (false sharing).
+// ALIGNAS_CACHE_LINE starts a field or variable on a new line; it raises the
+// alignment of the enclosing type, so only use it for statics, locals and
+// memory from arena_alloc_align().  CACHE_LINE_PAD() fills out the rest of a
+// line after `used` bytes of fields instead, which works wherever the
+// structure lives but only separates fields within it.
+//
+
+#define CACHE_LINE 64
+
+#if COMPILER_MSVC
+#    define ALIGNAS_CACHE_LINE __declspec(align(CACHE_LINE))
+#else
+#    define ALIGNAS_CACHE_LINE alignas(CACHE_LINE)
+#endif
+
+#define CACHE_LINE_PAD(name, used) u8 name[CACHE_LINE - (used)]
+
+//
+// Sharded counters
+//
+// A counter that many threads add to, such as a statistic, turns into a
+// cache-line ping-pong if it is a single word.  A ShardedCounter spreads the
+// adds over one cache line per shard, with threads assigned to shards round
+// robin.  Reading sums the shards, so it is slower and only exact once the
+// writers have stopped.
+//
+
+#define SHARDED_COUNTER_SHARDS 16
+
+typedef struct {
+    ALIGNAS_CACHE_LINE u64 value;
+} CounterShard;
+
+typedef struct {
+    CounterShard shards[SHARDED_COUNTER_SHARDS];
+} ShardedCounter;
+
+void sharded_counter_add(ShardedCounter* counter, u64 amount);
+u64  sharded_counter_read(ShardedCounter* counter);
+void sharded_counter_reset(ShardedCounter* counter);
+
+//------------------------------------------------------------------------------[Mutex]
+
+#if OS_POSIX
+#    include <pthread.h>
+#endif // OS_POSIX
+
+//
+// Lock profiling
+//
+// Mutexes and adaptive mutexes given a `.name` at init (or a static `.name`
+// initialiser) can report how hot they are.  While profiling is enabled, each
+// lock records acquisitions, how many had to wait, total and longest waits and
+// total and longest holds.  Locks with the same name share one profile, so
+// every channel's lock shows up as a single "channel" row.  Unnamed locks, and
+// all locks while profiling is off, pay only for a pointer test.
+//
+//      lock_profile_enable(true);
+//      ... run the workload ...
+//      lock_profile_print(10); // Ten worst by total wait time
+//
+
+#define LOCK_PROFILE_MAX 256
+
+typedef struct {
+    cstr name;         // Name given at init
+    u64  acquisitions; // Times the lock was taken
+    u64  contended;    // Acquisitions that found the lock held
+    u64  wait_time;    // Total time spent waiting (TimeDuration)
+    u64  max_wait;     // Longest single wait (TimeDuration)
+    u64  hold_time;    // Total time the lock was held (TimeDuration)
+    u64  max_hold;     // Longest single hold (TimeDuration)
+} LockProfile;
+
+void lock_profile_enable(bool enabled);
+bool lock_profile_enabled(void);
+
+// Clears the counters of every profile, keeping the names.
+void lock_profile_reset(void);
+
+// Copies up to `max` profiles, worst first: by total wait time, then by
+// contended acquisitions, then by acquisitions.  Returns how many were copied.
+usize lock_profile_snapshot(LockProfile* profiles, usize max);
+
+// Prints the `max` worst offenders as a table.
+void lock_profile_print(usize max);
+
+//
+// Mutex
+//
+
+typedef struct {
+#if OS_WINDOWS
+    CRITICAL_SECTION handle;
+#elif OS_POSIX
+    pthread_mutex_t handle;
+#else
+#    error "Mutex not implemented for this OS."
+#endif
+    cstr         name;      // Profile name, or NULL to never profile
+    LockProfile* profile;   // Bound to `name` on the first profiled lock
+    u64          locked_at; // TimePoint a profiled holder locked at, or 0
+} Mutex;
+
+typedef struct {
+    cstr name; // Groups the mutex's lock profile; NULL to opt out
+} MutexDefaultParams;
+
+void _mutex_init(Mutex* mutex, MutexDefaultParams params);
+
+#define mutex_init(mutex, ...)                                                 \
+    _mutex_init((mutex), (MutexDefaultParams){__VA_ARGS__})
+
+void mutex_done(Mutex* mutex);
+void mutex_lock(Mutex* mutex);
+void mutex_unlock(Mutex* mutex);
+
+// Condition variables wake threads waiting on a predicate protected by a mutex.
+// Waits can wake spuriously, so always re-check the predicate in a loop.
+#if OS_WINDOWS
+typedef CONDITION_VARIABLE CondVar;
+#elif OS_POSIX
+typedef pthread_cond_t CondVar;
+#else
+#    error "CondVar not implemented for this OS."
+#endif
+
+void condvar_init(CondVar* condvar);
+void condvar_done(CondVar* condvar);
+void condvar_wait(CondVar* condvar, Mutex* mutex);
+void condvar_signal(CondVar* condvar);
+void condvar_broadcast(CondVar* condvar);
+
+//
+// Futex
+//
+// Sleeps while a 32-bit word holds an expected value, without a kernel object
+// per word.  futex_wait() returns when woken, spuriously, or immediately if
+// `*address != expected`, so callers must loop on their own condition.  Uses
+// futex(2) on Linux and WaitOnAddress on Windows; other platforms yield the
+// CPU instead of sleeping.  futex_wait_timeout() also returns once `timeout`
+// (a TimeDuration, declared below) has passed; callers check their own
+// deadline to tell the cases apart.
+//
+
+void futex_wait(u32* address, u32 expected);
+void futex_wait_timeout(u32* address, u32 expected, u64 timeout);
+void futex_wake_one(u32* address);
+void futex_wake_all(u32* address);
+
+//
+// Lightweight locks
+//
+// All of these are zero-initialised and never allocate, so a zeroed static is
+// ready to use; *_init() is still provided for symmetry.
+//
+// AdaptiveMutex spins for a while before sleeping on a futex, and tunes how
+// long it spins from how long the lock was recently held.  Unlocking only
+// enters the kernel when a thread is sleeping.
+//
+// Spinlock is a ticket lock: waiters are served in arrival order and never
+// sleep (they only yield if the queue stops moving), so only use it for
+// critical sections of a few instructions.
+//
+// RwLock allows many readers or one writer and prefers readers: a reader only
+// waits for a writer that holds the lock, never for one that is waiting, so
+// read-mostly tables stay fast but a steady stream of readers can starve
+// writers.
+//
+
+#define ADAPTIVE_MUTEX_MAX_SPINS 1000
+
+typedef struct {
+    u32          state;     // 0 unlocked, 1 locked, 2 locked with sleepers
+    u32          spins;     // Running estimate of the spins needed to acquire
+    cstr         name;      // Profile name, or NULL to never profile
+    LockProfile* profile;   // Bound to `name` on the first profiled lock
+    u64          locked_at; // TimePoint a profiled holder locked at, or 0
+} AdaptiveMutex;
+
+typedef struct {
+    cstr name; // Groups the mutex's lock profile; NULL to opt out
+} AdaptiveMutexDefaultParams;
+
+void _adaptive_mutex_init(AdaptiveMutex*             mutex,
+                          AdaptiveMutexDefaultParams params);
+
+#define adaptive_mutex_init(mutex, ...)                                        \
+    _adaptive_mutex_init((mutex), (AdaptiveMutexDefaultParams){__VA_ARGS__})
+
+void adaptive_mutex_done(AdaptiveMutex* mutex);
+void adaptive_mutex_lock(AdaptiveMutex* mutex);
+void adaptive_mutex_unlock(AdaptiveMutex* mutex);
+
+typedef struct {
+    u32 next;    // Next ticket to hand out
+    u32 serving; // Ticket allowed into the critical section
+} Spinlock;
+
+void spinlock_init(Spinlock* lock);
+void spinlock_done(Spinlock* lock);
+void spinlock_lock(Spinlock* lock);
+void spinlock_unlock(Spinlock* lock);
+
+typedef struct {
+    u32 state;    // Reader count, or RWLOCK_WRITER when write-locked
+    u32 sleepers; // Threads sleeping on `state`
+} RwLock;
+
+#define RWLOCK_WRITER 0x80000000u
+
+void rwlock_init(RwLock* lock);
+void rwlock_done(RwLock* lock);
+void rwlock_read_lock(RwLock* lock);
+void rwlock_read_unlock(RwLock* lock);
+void rwlock_write_lock(RwLock* lock);
+void rwlock_write_unlock(RwLock* lock);
+
 //------------------------------------------------------------------------------[Arena]
 
 #define ARENA_DEFAULT_NUM_PAGES_GROW 16
+#define ARENA_HUGE_PAGE_SIZE MB(2)
+
+// How committed pages are faulted in.  By default the first write to each page
+// takes a page fault; prefaulting moves that cost to the commit.
+typedef enum {
+    ARENA_PREFAULT_NONE,     // Fault pages in on first touch
+    ARENA_PREFAULT_TOUCH,    // Write to every committed page
+    ARENA_PREFAULT_POPULATE, // Ask the OS to populate (MAP_POPULATE et al)
+} ArenaPrefault;
+
+// Page size used to back the arena.  Huge pages are a request: if the OS
+// cannot provide them the arena silently uses normal pages.
+typedef enum {
+    ARENA_PAGES_NORMAL,      // Normal OS pages
+    ARENA_PAGES_TRANSPARENT, // Transparent huge pages (madvise)
+    ARENA_PAGES_HUGETLB,     // Explicit huge pages, falling back to transparent
+} ArenaPages;
 
 // OS-based arena with reserved memory pages
-typedef struct {
-    u8*   memory;         // Base pointer to arena - never changes
+//
+// A concurrent arena (initialised with `.concurrent = true`) can be shared by
+// many threads calling arena_alloc() and arena_alloc_align().  The cursor is
+// bumped with an atomic fetch-add and pages are committed under a lock that is
+// only taken when an allocation crosses the committed boundary.  Marks
+// (arena_store/arena_restore/arena_reset) and sessions may only be used at
+// quiescent points, when no other thread is allocating.
+//
+// A chained arena (initialised with `.chained = true`) reserves no address
+// space up front.  It maps blocks of `grow_rate` pages (or larger for big
+// allocations) on demand and links them together, for hosts with strict
+// overcommit limits.  Cursors and marks are positions across all blocks, so
+// arena_alloc(), marks and rewinds behave as usual, but only allocations
+// within a block are contiguous.  `memory` is the current block and
+// arena_offset() is relative to it; sessions and string builders must not
+// outgrow a block.  Chained arenas cannot be concurrent.
+typedef struct Arena {
+    u8*   memory;         // Base pointer to arena (current block if chained)
     usize cursor;         // Current allocation cursor
     usize committed_size; // Number of bytes currently committed
     usize reserved_size;  // Total number of bytes reserved (maximum capacity)
     usize alloc_granularity; // OS allocation granularity (page size)
     usize grow_rate;         // Number of pages to grow by when expanding
+    bool  concurrent;        // Allocation is thread-safe
+    Mutex commit_mutex;      // Serialises commits in concurrent mode
+    ArenaPrefault prefault;  // How committed pages are faulted in
+    ArenaPages    pages;     // Page size backing the arena (after fallback)
+    u32           numa_node; // ARENA_NODE() the pages prefer, 0 if unbound
+
+    // Chained mode
+    bool               chained;     // Grows by chaining mapped blocks
+    usize              block_base;  // Cursor position of memory[0]
+    struct ArenaBlock* block;       // Current block
+    struct ArenaBlock* spare_block; // Last released block, kept for reuse
+
+    // Decommit policy and counters
+    usize peak_cursor;      // Highest cursor reached before the last rewind
+    usize decommit_keep;    // Bytes always kept committed (warm)
+    u32   decommit_after;   // Rewinds before excess is decommitted (0 = never)
+    u32   decommit_rewinds; // Rewinds seen in the current decommit window
+    usize window_peak;      // Highest cursor seen in the current window
+    usize decommit_count;   // Number of decommits performed
+    usize decommitted_size; // Total bytes returned to the OS
+
+    // Instrumentation
+    cstr          name;          // Registry name (NULL if not registered)
+    usize         commit_count;  // Number of commit calls made to the OS
+    u64           commit_time;   // Time spent committing (TimeDuration)
+    struct Arena* registry_next; // Next arena in the global registry
 } Arena;
 
 // Used to build arrays within an arena
@@ -381,11 +766,31 @@ typedef struct {
 // Arena Lifetime
 //
 
+// Decommit policy: when `decommit_after` is non-zero, every arena_restore()
+// and arena_reset() counts as a rewind.  After that many rewinds, committed
+// pages beyond both the highest cursor seen during those rewinds and
+// `decommit_keep_pages` are returned to the OS.  Spikes are released while an
+// arena that regularly reaches the same size keeps its pages warm.
+//
+// NUMA binding: `.numa_node = ARENA_NODE(n)` asks the OS to place the arena's
+// pages on node `n` (mbind with MPOL_PREFERRED on Linux, so a full node spills
+// rather than failing).  Elsewhere, and by default, pages land on the node of
+// the thread that first touches them.
 typedef struct {
     usize reserved_size;
     usize grow_rate;
+    bool  concurrent;
+    bool  chained;
+    ArenaPrefault prefault;
+    ArenaPages    pages;
+    usize decommit_keep_pages;
+    u32   decommit_after;
+    u32   numa_node; // ARENA_NODE(n) to prefer node n, 0 for the OS default
+    cstr  name;      // Registers the arena in the global registry when set
 } ArenaDefaultParams;
 
+#define ARENA_NODE(node) ((u32)(node) + 1)
+
 void _arena_init(Arena* arena, ArenaDefaultParams params);
 
 #define arena_init(arena, ...)                                                 \
@@ -401,6 +806,15 @@ void* arena_alloc(Arena* arena, usize size);
 void  arena_align(Arena* arena, usize align);
 void* arena_alloc_align(Arena* arena, usize size, usize align);
 
+// Resizes an allocation.  If `ptr` is the most recent allocation it is grown
+// or shrunk in place; otherwise growing copies to a new allocation aligned to
+// max_align_t.  A NULL `ptr` allocates.
+void* arena_realloc(Arena* arena, void* ptr, usize old_size, usize new_size);
+
+// Gives back the tail of the most recent allocation.  Returns false, leaving
+// the arena untouched, if `ptr` is no longer the most recent allocation.
+bool arena_shrink_last(Arena* arena, void* ptr, usize old_size, usize new_size);
+
 u8*  arena_formatv(Arena* arena, cstr fmt, va_list args);
 u8*  arena_format(Arena* arena, cstr fmt, ...);
 void arena_null_terminate(Arena* arena);
@@ -419,6 +833,82 @@ void  arena_reset(Arena* arena);
 
 u32 arena_offset(Arena* arena, void* p);
 
+//
+// Arena references
+//
+// References are offsets from an arena's base, so they stay valid if the arena
+// is snapshotted and mapped elsewhere.  Ref32 links are half the size of a
+// pointer and cover the first 4 GB; Ref64 links cover any arena.  Chained
+// arenas are not contiguous and cannot be referenced into.
+//
+// Each target type gets its own reference types from DEF_REF(T), where T is a
+// type name, so a Ref32(Node) cannot be stored in a Ref32(Edge), made from an
+// Edge* or resolved as one: all of these fail to compile.  A Ref32 has no room
+// to carry its target, so resolving names it.  Debug builds check that a
+// reference lies within the arena's used memory and fits its width.
+//
+//      DEF_REF(Node);
+//      typedef struct { u32 value; Ref32(Node) next; } Node;
+//      node->next = arena_ref32(&arena, Node, next);
+//      Node* next = arena_ref_get(&arena, Node, node->next);
+//
+
+#define DEF_REF(T)                                                             \
+    typedef struct {                                                           \
+        u32 offset;                                                            \
+    } Ref32_##T;                                                               \
+    typedef struct {                                                           \
+        u64 offset;                                                            \
+    } Ref64_##T
+
+#define Ref32(T) Ref32_##T
+#define Ref64(T) Ref64_##T
+
+u64   _arena_ref(Arena* arena, const void* p, u64 limit);
+void* _arena_ref_resolve(Arena* arena, u64 offset);
+
+// Makes a reference to `p`, which must be a T*.
+#define arena_ref32(arena, T, p)                                               \
+    ((Ref32(T)){(u32)_arena_ref((arena), _ref_target(T, p), UINT32_MAX)})
+#define arena_ref64(arena, T, p)                                               \
+    ((Ref64(T)){_arena_ref((arena), _ref_target(T, p), UINT64_MAX)})
+
+// Resolves a reference to a T against a base such as `arena->memory` or a
+// snapshot's `memory`.
+#define ref_get(base, T, ref) ((T*)((u8*)(base) + _ref_offset(T, ref)))
+#define arena_ref_get(arena, T, ref)                                           \
+    ((T*)_arena_ref_resolve((arena), _ref_offset(T, ref)))
+
+#define _ref_target(T, p) _Generic((p), T*: (p), const T*: (p))
+#define _ref_offset(T, ref)                                                    \
+    _Generic((ref), Ref32(T): (u64)(ref).offset, Ref64(T): (u64)(ref).offset)
+
+typedef struct {
+    usize used;           // Bytes allocated (current cursor)
+    usize peak;           // Highest cursor ever reached
+    usize committed;      // Bytes currently committed
+    usize reserved;       // Bytes of address space reserved
+    usize decommit_count; // Number of decommits performed
+    usize decommitted;    // Total bytes returned to the OS
+    usize commit_count;   // Number of commit calls made to the OS
+    u64   commit_time;    // Time spent committing (TimeDuration)
+} ArenaStats;
+
+ArenaStats arena_stats(Arena* arena);
+
+//
+// Arena registry
+//
+// Arenas initialised with a `.name` are tracked in a global registry until
+// arena_done().  The registry can be printed as a table or written as JSON to
+// right-size `reserved_size` and `grow_rate` from real usage.  Figures for
+// arenas in use by other threads are a snapshot and may be slightly stale.
+//
+
+usize arena_registry_count(void);
+void  arena_registry_print(void);
+u8*   arena_registry_json(Arena* arena); // Null-terminated, allocated in arena
+
 //
 // Arena sessions
 //
@@ -433,24 +923,791 @@ void* arena_session_alloc(ArenaSession* session, usize count);
 usize arena_session_count(ArenaSession* session);
 void* arena_session_address(ArenaSession* session);
 
-//------------------------------------------------------------------------------[Mutex]
+//
+// Arena scratch
+//
+// Each thread owns a small pool of scratch arenas for temporaries.  Pass any
+// arenas that the caller is allocating its results into as conflicts and a
+// scratch arena that is none of them is returned, so temporaries never alias
+// the output.  scratch_end() rolls the arena back to where it was when
+// scratch_begin() was called.  scratch_done() releases the calling thread's
+// scratch arenas and should be called before a thread exits.  Each fiber has
+// a set of its own, so scratch memory may be held while a fiber is switched
+// out.
+//
+//      ArenaScratch scratch = scratch_begin(out_arena);
+//      ... allocate from scratch.arena ...
+//      scratch_end(scratch);
+//
+
+#define ARENA_SCRATCH_COUNT 2
+
+typedef struct {
+    Arena* arena; // Scratch arena to allocate temporaries from
+    u64    mark;  // Position to restore in scratch_end()
+} ArenaScratch;
+
+ArenaScratch _scratch_begin(Arena** conflicts, usize count);
+void         scratch_end(ArenaScratch scratch);
+void         scratch_done(void);
+
+// Makes `arenas`, ARENA_SCRATCH_COUNT of them zeroed until first used, the
+// calling thread's scratch arenas, each reserving `reserved_size` bytes (0 for
+// the default).  NULL restores the thread's own.  Used by fiber schedulers.
+void _scratch_use(Arena* arenas, usize reserved_size);
+
+#define scratch_begin(...)                                                     \
+    _scratch_begin((Arena*[]){NULL, __VA_ARGS__},                              \
+                   sizeof((Arena*[]){NULL, __VA_ARGS__}) / sizeof(Arena*))
+
+//------------------------------------------------------------------------------[Pool]
+
+// Fixed-size slots carved from an arena and recycled through an intrusive free
+// list.  Slots are bump-allocated from arena chunks, so fresh slots are
+// adjacent in memory, and freed slots are reused most-recent first.  In debug
+// builds freed slots are poisoned and checked on reuse to catch writes after
+// free.  Resetting or restoring the arena below the pool's chunks requires a
+// pool_reset().
+typedef struct {
+    Arena* arena;      // Arena that slots are carved from
+    usize  slot_size;  // Size of each slot in bytes
+    usize  alignment;  // Alignment of each slot
+    void*  free_list;  // Singly linked list of freed slots
+    u8*    chunk_next; // Next unused slot in the current chunk
+    u8*    chunk_end;  // End of the current chunk
+    usize  count;      // Number of live slots
+} Pool;
+
+#define POOL_POISON_BYTE 0xdd
+
+void  pool_init(Pool* pool, Arena* arena, usize slot_size, usize alignment);
+void  pool_reset(Pool* pool);
+void* pool_alloc(Pool* pool);
+void  pool_free(Pool* pool, void* ptr);
+
+#define pool_init_typed(pool, arena, type)                                     \
+    pool_init((pool), (arena), sizeof(type), alignof(type))
+
+#define pool_new(pool, type) ((type*)pool_alloc(pool))
+
+//------------------------------------------------------------------------------[Heap]
+
+// Two-level segregated fit (TLSF) allocator for variable-sized blocks that are
+// freed in any order.  Free blocks are binned by a power-of-two first level
+// split into HEAP_SL_COUNT linear second-level ranges, and two bitmaps find a
+// large enough bin with a couple of bit scans, so heap_alloc() and heap_free()
+// run in bounded time regardless of how many blocks exist.  Neighbouring free
+// blocks are merged immediately.
+//
+// The heap owns an arena that reserves its address range and commits pages
+// lazily as the heap grows; use `.prefault` and `.pages` to move page faults
+// out of the hot path.  Allocations are HEAP_ALIGNMENT aligned and carry one
+// word of overhead.  heap_alloc() returns NULL once the reserved range is
+// exhausted.  A heap is not thread-safe.
+#define HEAP_ALIGNMENT 8
+#define HEAP_SL_LOG2 5
+#define HEAP_SL_COUNT (1 << HEAP_SL_LOG2)
+#define HEAP_FL_SHIFT (HEAP_SL_LOG2 + 3)
+#define HEAP_FL_MAX 40
+#define HEAP_FL_COUNT (HEAP_FL_MAX - HEAP_FL_SHIFT + 1)
+
+typedef struct {
+    Arena             arena;     // Reserved range the heap grows into
+    u64               fl_bitmap; // First-level bins with free blocks
+    u32               sl_bitmap[HEAP_FL_COUNT]; // Second-level bins
+    struct HeapBlock* free[HEAP_FL_COUNT][HEAP_SL_COUNT]; // Free lists
+    struct HeapBlock* sentinel; // Zero-sized block at the end of the heap
+    usize             used;     // Bytes in allocated blocks
+    usize             peak;     // Highest value of `used`
+    usize             count;    // Number of live allocations
+} Heap;
+
+typedef struct {
+    usize reserved_size;
+    usize grow_rate;
+    ArenaPrefault prefault;
+    ArenaPages    pages;
+    cstr          name; // Registers the heap's arena in the arena registry
+} HeapDefaultParams;
+
+void _heap_init(Heap* heap, HeapDefaultParams params);
+
+#define heap_init(heap, ...)                                                   \
+    _heap_init((heap), (HeapDefaultParams){__VA_ARGS__})
+
+void heap_done(Heap* heap);
 
+void* heap_alloc(Heap* heap, usize size);
+void  heap_free(Heap* heap, void* ptr);
+usize heap_size(void* ptr); // Usable size of an allocation
+
+#define heap_new(heap, type) ((type*)heap_alloc((heap), sizeof(type)))
+
+// Fragmentation is 1 - largest_free / free: 0 when all free space is one
+// block, approaching 1 as it is scattered into small pieces.  heap_stats()
+// walks every block and is meant for diagnostics rather than the hot path.
+typedef struct {
+    usize used;          // Bytes in allocated blocks
+    usize peak;          // Highest value of `used`
+    usize free;          // Bytes in free blocks
+    usize largest_free;  // Size of the largest free block
+    usize count;         // Number of live allocations
+    usize free_blocks;   // Number of free blocks
+    usize committed;     // Bytes committed by the heap's arena
+    usize reserved;      // Bytes of address space reserved
+    f64   fragmentation; // 0 (contiguous) to 1 (fragmented)
+} HeapStats;
+
+HeapStats heap_stats(Heap* heap);
+
+//------------------------------------------------------------------------------[Thread]
+
+typedef void (*ThreadFunc)(void* context);
+
+// A thread runs a function with a context pointer.  A thread must be either
+// joined or detached exactly once.  Threads release their scratch arenas when
+// their function returns.
+typedef struct {
 #if OS_WINDOWS
-typedef CRITICAL_SECTION Mutex;
+    HANDLE handle;
 #elif OS_POSIX
-#    include <pthread.h>
-typedef pthread_mutex_t Mutex;
+    pthread_t handle;
 #else
-#    error "Mutex not implemented for this OS."
+#    error "Thread not implemented for this OS."
 #endif
+} Thread;
 
-void mutex_init(Mutex* mutex);
-void mutex_done(Mutex* mutex);
-void mutex_lock(Mutex* mutex);
-void mutex_unlock(Mutex* mutex);
+typedef struct {
+    usize stack_size; // 0 uses the OS default
+    cstr  name;       // Shown in debuggers and profilers (may be truncated)
+    u32   cpu;        // THREAD_CPU(n) pins the thread to CPU n, 0 leaves it
+} ThreadDefaultParams;
+
+#define THREAD_CPU(cpu) ((u32)(cpu) + 1)
+
+bool _thread_create(Thread*             thread,
+                    ThreadFunc          func,
+                    void*               context,
+                    ThreadDefaultParams params);
+
+#define thread_create(thread, func, context, ...)                              \
+    _thread_create(                                                            \
+        (thread), (func), (context), (ThreadDefaultParams){__VA_ARGS__})
+
+void thread_join(Thread* thread);
+void thread_detach(Thread* thread);
+
+void  thread_set_name(cstr name); // Names the calling thread
+usize thread_cpu_count(void);     // Number of logical CPUs online
+
+//
+// Thread pool
+//
+// A fixed set of worker threads that run queued tasks in FIFO order.  The
+// queue has a fixed capacity and thread_pool_submit() blocks while it is full.
+// thread_pool_done() runs every task already queued before joining the
+// workers.  main() initialises a global pool, available through
+// thread_pool_global(), and shuts it down when run() returns.
+//
+
+#define THREAD_POOL_DEFAULT_CAPACITY 1024
+
+typedef struct {
+    ThreadFunc func;    // Function to run
+    void*      context; // Argument passed to `func`
+} ThreadTask;
+
+typedef struct {
+    Thread*     threads;      // Worker threads
+    usize       thread_count; // Number of worker threads
+    ThreadTask* tasks;        // Ring buffer of queued tasks
+    usize       capacity;     // Maximum number of queued tasks
+    usize       head;         // Index of the oldest queued task
+    usize       queued;       // Number of queued tasks
+    usize       running;      // Number of tasks being run by workers
+    bool        stopping;     // Workers exit once the queue is empty
+    Mutex       mutex;        // Protects the queue and counters
+    CondVar     task_ready;   // Signalled when a task is queued or stopping
+    CondVar     task_space;   // Signalled when the queue has room
+    CondVar     idle;         // Signalled when all tasks have finished
+} ThreadPool;
+
+typedef struct {
+    usize thread_count;   // 0 starts one worker per CPU
+    usize queue_capacity; // 0 uses THREAD_POOL_DEFAULT_CAPACITY
+    usize stack_size;     // 0 uses the OS default
+    cstr  name;           // Worker name prefix ("worker" if NULL)
+    bool  pin_workers;    // Pin worker i to cpu_spread(i)
+} ThreadPoolDefaultParams;
+
+void _thread_pool_init(ThreadPool* pool, ThreadPoolDefaultParams params);
+
+#define thread_pool_init(pool, ...)                                            \
+    _thread_pool_init((pool), (ThreadPoolDefaultParams){__VA_ARGS__})
+
+void thread_pool_done(ThreadPool* pool);
+
+void thread_pool_submit(ThreadPool* pool, ThreadFunc func, void* context);
+void thread_pool_wait(ThreadPool* pool); // Waits until all tasks have finished
+
+ThreadPool* thread_pool_global(void);
+
+//
+// CPU topology and affinity
+//
+// The online CPUs the process may run on and their NUMA nodes, read once from
+// sysfs and the process's affinity mask on Linux.  Elsewhere every CPU is
+// reported on node 0 with a core of its own.  cpu_spread() orders CPUs for
+// worker placement: consecutive indices alternate between nodes and use every
+// physical core before any hyperthread sibling, so the first N workers get the
+// most bandwidth and cache.
+//
+// Pinning returns false where the OS does not support it (macOS) or refuses
+// the CPU.  A thread created with a CPU it cannot be pinned to runs unpinned
+// and says so on stderr.  A pinned thread's scratch arenas prefer its node, so
+// pinned pool and job workers keep their temporaries local.
+//
+
+#define TOPOLOGY_MAX_CPUS 1024
+#define TOPOLOGY_MAX_NODES 64
+
+typedef struct {
+    u32 id;      // OS CPU number
+    u32 node;    // NUMA node
+    u32 core;    // Core id within the package
+    u32 package; // Physical package (socket)
+} CpuInfo;
+
+typedef struct {
+    CpuInfo cpus[TOPOLOGY_MAX_CPUS];       // Usable CPUs, by increasing id
+    usize   cpu_count;                     // Entries in `cpus`
+    usize   node_count;                    // Highest node with CPUs, plus 1
+    u32     node_cpus[TOPOLOGY_MAX_NODES]; // Usable CPUs on each node
+    u32     spread[TOPOLOGY_MAX_CPUS];     // CPU ids in placement order
+    u8      cpu_node[TOPOLOGY_MAX_CPUS];   // Node of each CPU id
+} CpuTopology;
+
+const CpuTopology* cpu_topology(void);
+
+u32 cpu_spread(usize index); // CPU id for the index-th worker (wraps around)
+
+bool thread_pin_cpu(u32 cpu);   // Pins the calling thread to one CPU
+bool thread_pin_node(u32 node); // Pins the calling thread to a node's CPUs
+u32  thread_current_cpu(void);  // CPU the calling thread is running on
+u32  thread_current_node(void); // Node the calling thread is running on
+
+// ARENA_NODE() of the node the calling thread is pinned within, or 0 if it is
+// not pinned or its CPUs span nodes.
+u32 thread_pinned_node(void);
+
+//------------------------------------------------------------------------------[Job]
+
+// Fine-grained jobs scheduled over a set of workers.  Each worker owns a
+// Chase-Lev deque: it pushes and pops jobs at the bottom while idle workers
+// steal the oldest jobs from the top, so recursively split work stays local
+// and large pieces are the ones that migrate.  The thread that calls
+// job_system_init() is worker 0 and only runs jobs inside job_wait(); the
+// remaining workers are threads owned by the system.  Other threads may submit
+// and wait too, but they go through a shared queue.  job_system_done() runs
+// every job that is ready, including any those jobs submit, before it stops
+// the workers, so no counter is left waiting on a dropped job.
+//
+// Jobs are not allocated by the system: the caller owns each Job and must keep
+// it alive until it has finished.  A job becomes ready once it has been
+// submitted and every job it depends on has finished.  Waiting on a counter
+// runs other jobs until every job submitted with that counter has finished.
+//
+//      JobCounter counter = {0};
+//      Job        a, b;
+//      job_init(&a, load_mesh, mesh);
+//      job_init(&b, build_bvh, mesh);
+//      job_depend(&b, &a);                 // b runs after a
+//      job_submit(&jobs, &b, &counter);
+//      job_submit(&jobs, &a, &counter);
+//      job_wait(&jobs, &counter);
+//
+
+#define JOB_MAX_DEPENDENTS 4
+#define JOB_DEQUE_CAPACITY 4096 // Jobs beyond this run inline on submit
+
+typedef void (*JobFunc)(void* context);
+
+typedef struct {
+    usize value; // Number of submitted jobs that have not finished
+} JobCounter;
+
+typedef struct Job {
+    JobFunc     func;            // Function to run
+    void*       context;         // Argument passed to `func`
+    usize       pending;         // Unfinished parents, plus 1 until submitted
+    JobCounter* counter;         // Decremented when the job finishes
+    struct Job* dependents[JOB_MAX_DEPENDENTS]; // Jobs waiting on this one
+    u32         dependent_count; // Number of entries in `dependents`
+    struct Job* next;            // Link in the shared queue
+} Job;
+
+// `top` and `bottom` are kept on separate cache lines so that thieves do not
+// slow down the owner.
+typedef struct {
+    i64 top; // Next job to steal (shared by thieves)
+    CACHE_LINE_PAD(top_padding, sizeof(i64));
+    i64   bottom; // Next free slot (written by the owner only)
+    Job** jobs;   // Ring buffer of JOB_DEQUE_CAPACITY jobs
+    CACHE_LINE_PAD(bottom_padding, sizeof(i64) + sizeof(Job**));
+} JobDeque;
+
+typedef struct {
+    struct JobSystem* system; // System that owns the worker
+    JobDeque          deque;  // Jobs pushed by this worker
+    Thread            thread; // Worker thread (unused for worker 0)
+    u64               seed;   // State for choosing steal victims
+    usize             index;  // Index in the system's worker array
+} JobWorker;
+
+typedef struct JobSystem {
+    JobWorker* workers;      // Worker 0 is the thread that created the system
+    usize      worker_count; // Number of workers including worker 0
+    Mutex      queue_mutex;  // Protects the shared queue
+    Job*       queue_head;   // Jobs submitted from non-worker threads
+    Job*       queue_tail;   // Last job in the shared queue
+    usize      queued;       // Number of jobs in the shared queue
+    Mutex      sleep_mutex;  // Protects sleeping workers
+    CondVar    wake;         // Signalled when work arrives or stopping
+    usize      sleeping;     // Number of sleeping workers
+    usize      unfinished;   // Jobs scheduled but not yet finished
+    bool       stopping;     // Workers exit when set
+} JobSystem;
+
+typedef struct {
+    usize worker_count; // 0 uses one worker per CPU (including the caller)
+    usize stack_size;   // 0 uses the OS default
+    cstr  name;         // Worker name prefix ("job" if NULL)
+    bool  pin_workers;  // Pin worker i (not the caller) to cpu_spread(i)
+} JobSystemDefaultParams;
+
+void _job_system_init(JobSystem* system, JobSystemDefaultParams params);
+
+#define job_system_init(system, ...)                                           \
+    _job_system_init((system), (JobSystemDefaultParams){__VA_ARGS__})
+
+void job_system_done(JobSystem* system);
+
+void job_init(Job* job, JobFunc func, void* context);
+
+// Makes `job` wait for `parent` to finish.  Both jobs must be set up before
+// `parent` is submitted.
+void job_depend(Job* job, Job* parent);
+
+void job_submit(JobSystem* system, Job* job, JobCounter* counter);
+void job_wait(JobSystem* system, JobCounter* counter);
+
+//------------------------------------------------------------------------------[Parallel]
+
+// Data-parallel algorithms that run on a JobSystem.  A range of `count`
+// elements is cut into chunks of at least `grain` elements (0 picks
+// PARALLEL_DEFAULT_GRAIN), and into at most PARALLEL_CHUNKS_PER_WORKER chunks
+// per worker, so small ranges run inline and large ones balance well without
+// flooding the deques.  The caller helps run the chunks and every function
+// returns once the whole range is done.  They may be called from inside jobs.
+//
+// Ranges are passed as (base, count, element_size).  PARALLEL_ARRAY() and
+// PARALLEL_SLICE() expand an Array(T) or a DEF_SLICE value into those three
+// arguments:
+//
+//      parallel_sort(&jobs, PARALLEL_ARRAY(records), compare_records, NULL);
+//      parallel_radix_sort(&jobs, PARALLEL_SLICE(ids), 0, sizeof(u32));
+//
+// parallel_reduce() and parallel_scan() combine chunks in order, so the
+// operation need only be associative, not commutative.  Temporary buffers come
+// from the calling thread's scratch arenas.
+
+#define PARALLEL_DEFAULT_GRAIN 4096
+#define PARALLEL_CHUNKS_PER_WORKER 4
+
+#define PARALLEL_ARRAY(a) (a), array_count(a), sizeof(*(a))
+#define PARALLEL_SLICE(s) (s).data, (s).count, sizeof(*(s).data)
+
+// Processes elements [begin, end).
+typedef void (*ParallelForFunc)(void* context, usize begin, usize end);
+
+// Folds elements [begin, end) into `accumulator`.
+typedef void (*ParallelReduceFunc)(void* context,
+                                   usize begin,
+                                   usize end,
+                                   void* accumulator);
+
+// Sets `accumulator` to `accumulator` combined with `value`.
+typedef void (*ParallelCombineFunc)(void*       context,
+                                    void*       accumulator,
+                                    const void* value);
+
+// Returns <0, 0 or >0 as `a` sorts before, with or after `b`.
+typedef int (*ParallelCompareFunc)(void*       context,
+                                   const void* a,
+                                   const void* b);
+
+typedef bool (*ParallelPredicateFunc)(void* context, const void* element);
+
+void parallel_for(JobSystem*      system,
+                  usize           count,
+                  usize           grain,
+                  ParallelForFunc func,
+                  void*           context);
+
+// `result` holds the identity on entry; each chunk starts from a copy of it.
+// On return it holds the combined result of every chunk.
+void parallel_reduce(JobSystem*          system,
+                     usize               count,
+                     usize               grain,
+                     ParallelReduceFunc  reduce,
+                     ParallelCombineFunc combine,
+                     void*               context,
+                     void*               result,
+                     usize               result_size);
+
+// Writes running totals of `input` to `output`, which may be the same buffer.
+// An inclusive scan includes each element in its own total; an exclusive scan
+// starts from `identity`.
+void parallel_scan(JobSystem*          system,
+                   const void*         input,
+                   usize               count,
+                   usize               element_size,
+                   void*               output,
+                   usize               grain,
+                   ParallelCombineFunc combine,
+                   void*               context,
+                   const void*         identity,
+                   bool                inclusive);
+
+// Stable merge sort: chunks are sorted in parallel, then merged pairwise with
+// each merge split across workers.
+void parallel_sort(JobSystem*          system,
+                   void*               base,
+                   usize               count,
+                   usize               element_size,
+                   ParallelCompareFunc compare,
+                   void*               context);
+
+// Stable LSD radix sort on an unsigned little-endian key of 1 to 8 bytes at
+// `key_offset` within each element.  Passes over digits that every key shares
+// are skipped.
+void parallel_radix_sort(JobSystem* system,
+                         void*      base,
+                         usize      count,
+                         usize      element_size,
+                         usize      key_offset,
+                         usize      key_size);
+
+// Copies `input` to `output` with the elements that satisfy `predicate` first,
+// keeping the order within each group.  Returns how many satisfied it.
+usize parallel_partition(JobSystem*            system,
+                         const void*           input,
+                         usize                 count,
+                         usize                 element_size,
+                         void*                 output,
+                         ParallelPredicateFunc predicate,
+                         void*                 context);
+
+//------------------------------------------------------------------------------[Queue]
+
+// Bounded queues of fixed-size elements that are copied in and out.  Storage
+// is carved from an arena at init and the capacity is rounded up to a power of
+// two.  The try functions never block; the plain push and pop spin, yielding
+// the CPU while the queue stays full or empty.  Batch functions move up to
+// `count` elements at once and return how many were moved.
+//
+// SpscQueue is a ring for exactly one producer and one consumer thread.  Each
+// side caches the other's index, so it only touches the shared cache line when
+// the cached value says the ring looks full or empty.
+//
+// MpmcQueue allows any number of producers and consumers (Dmitry Vyukov's
+// bounded queue).  Every cell carries a sequence number that says whether it
+// is ready to write or read, so a push or pop costs one CAS on the shared
+// position and no locks.
+
+typedef struct {
+    // Producer's cache line
+    u64 head;        // Next slot to write
+    u64 cached_tail; // Producer's last view of `tail`
+    CACHE_LINE_PAD(head_padding, 2 * sizeof(u64));
+
+    // Consumer's cache line
+    u64 tail;        // Next slot to read
+    u64 cached_head; // Consumer's last view of `head`
+    CACHE_LINE_PAD(tail_padding, 2 * sizeof(u64));
+
+    u8*   buffer;       // capacity * element_size bytes
+    usize capacity;     // Number of slots (power of two)
+    usize element_size; // Size of each element in bytes
+} SpscQueue;
+
+void  spsc_init(SpscQueue* queue,
+                Arena*     arena,
+                usize      capacity,
+                usize      element_size);
+bool  spsc_try_push(SpscQueue* queue, const void* element);
+bool  spsc_try_pop(SpscQueue* queue, void* element);
+void  spsc_push(SpscQueue* queue, const void* element);
+void  spsc_pop(SpscQueue* queue, void* element);
+usize spsc_push_batch(SpscQueue* queue, const void* elements, usize count);
+usize spsc_pop_batch(SpscQueue* queue, void* elements, usize count);
+
+typedef struct {
+    u64 enqueue_pos; // Next position to push
+    CACHE_LINE_PAD(enqueue_padding, sizeof(u64));
+    u64 dequeue_pos; // Next position to pop
+    CACHE_LINE_PAD(dequeue_padding, sizeof(u64));
+
+    u8*   cells;        // Sequence numbers followed by element data
+    usize cell_size;    // Size of each cell in bytes
+    usize capacity;     // Number of cells (power of two)
+    usize element_size; // Size of each element in bytes
+} MpmcQueue;
+
+void  mpmc_init(MpmcQueue* queue,
+                Arena*     arena,
+                usize      capacity,
+                usize      element_size);
+bool  mpmc_try_push(MpmcQueue* queue, const void* element);
+bool  mpmc_try_pop(MpmcQueue* queue, void* element);
+void  mpmc_push(MpmcQueue* queue, const void* element);
+void  mpmc_pop(MpmcQueue* queue, void* element);
+usize mpmc_push_batch(MpmcQueue* queue, const void* elements, usize count);
+usize mpmc_pop_batch(MpmcQueue* queue, void* elements, usize count);
+
+//------------------------------------------------------------------------------[Epoch]
+
+// Epoch-based reclamation lets readers of lock-free structures run without
+// locks or reference counts, while writers still free what they unlink.
+// Readers bracket each access with epoch_enter() and epoch_exit().  A writer
+// unlinks a node and then retires it, and the node is freed only once every
+// thread that could still be reading it has left its critical section.
+//
+// The domain has a global epoch that advances once every thread inside a
+// critical section has observed the current one.  Retired objects go into one
+// of three limbo lists tagged with the epoch they were retired in, and are
+// freed two epochs later.  A thread that stays inside a critical section holds
+// up reclamation for everyone, so keep critical sections short.
+//
+// Each thread registers with the domain and gets an EpochThread to pass to the
+// other calls.  Objects are freed by the thread that retired them, during
+// epoch_retire() once enough are pending, epoch_collect() or
+// epoch_unregister(), so free functions that are not thread-safe (mem_free,
+// pools owned by the retiring thread) are fine.
+//
+//      epoch_enter(me);
+//      Node* node = atomic_load_ptr(&head, MEMORY_ACQUIRE);
+//      ... read node ...
+//      epoch_exit(me);
+//
+//      Node* old = atomic_exchange_ptr(&head, fresh, MEMORY_ACQ_REL);
+//      epoch_retire_mem(me, old);
+//
+
+#define EPOCH_LIMBO_COUNT 3
+#define EPOCH_LIMBO_CHUNK 40 // Retired objects per limbo chunk
+#define EPOCH_DEFAULT_COLLECT_THRESHOLD 64
+
+typedef void (*EpochFreeFunc)(void* context, void* ptr);
+
+typedef struct {
+    void*         ptr;     // Object to free
+    EpochFreeFunc func;    // Called as func(context, ptr)
+    void*         context; // Passed to `func`
+} EpochRetired;
+
+typedef struct EpochLimboChunk {
+    struct EpochLimboChunk* next;
+    usize                   count;
+    EpochRetired            items[EPOCH_LIMBO_CHUNK];
+} EpochLimboChunk;
+
+typedef struct {
+    EpochLimboChunk* head;  // Most recent chunk first
+    u64              epoch; // Epoch the objects were retired in
+    usize            count; // Objects waiting in this list
+} EpochLimbo;
+
+// `state` is read by every collecting thread, so it sits on a line of its own.
+typedef struct EpochThread {
+    u64 state; // (observed epoch << 1) | 1 while inside, 0 outside
+    CACHE_LINE_PAD(state_padding, sizeof(u64));
+    struct EpochDomain* domain;  // Domain the thread is registered with
+    struct EpochThread* next;    // Next record in the domain (never unlinked)
+    bool                in_use;  // Registered to a live thread
+    u32                 depth;   // Nesting depth of epoch_enter()
+    usize               retires; // Retires since the last collection
+    Pool                chunks;  // Limbo chunks, carved from the domain arena
+    EpochLimbo          limbo[EPOCH_LIMBO_COUNT];
+} EpochThread;
+
+typedef struct EpochDomain {
+    u64 epoch; // Global epoch
+    CACHE_LINE_PAD(epoch_padding, sizeof(u64));
+    EpochThread* threads;           // Every record ever registered
+    Mutex        register_mutex;    // Serialises registration
+    Arena        arena;             // Concurrent arena for records and chunks
+    usize        collect_threshold; // Retires between automatic collections
+} EpochDomain;
+
+typedef struct {
+    usize collect_threshold; // 0 uses EPOCH_DEFAULT_COLLECT_THRESHOLD
+} EpochDomainDefaultParams;
+
+void _epoch_domain_init(EpochDomain* domain, EpochDomainDefaultParams params);
+
+#define epoch_domain_init(domain, ...)                                         \
+    _epoch_domain_init((domain), (EpochDomainDefaultParams){__VA_ARGS__})
+
+// Every thread must have unregistered first.
+void epoch_domain_done(EpochDomain* domain);
+
+// Registers the calling thread.  Records of unregistered threads are reused.
+EpochThread* epoch_register(EpochDomain* domain);
+
+// Waits for everything the thread retired to be freed, then releases the
+// record.  Must be called outside a critical section.
+void epoch_unregister(EpochThread* thread);
+
+// Critical sections nest; only the outermost pair publishes anything.
+void epoch_enter(EpochThread* thread);
+void epoch_exit(EpochThread* thread);
+
+// Frees `ptr` with func(context, ptr) once no reader can still hold it.  May
+// be called inside or outside a critical section, after `ptr` is unlinked.
+void epoch_retire(EpochThread*  thread,
+                  void*         ptr,
+                  EpochFreeFunc func,
+                  void*         context);
+
+void epoch_free_mem(void* context, void* ptr);  // mem_free(ptr)
+void epoch_free_pool(void* context, void* ptr); // pool_free(context, ptr)
+
+#define epoch_retire_mem(thread, ptr)                                          \
+    epoch_retire((thread), (ptr), epoch_free_mem, NULL)
+#define epoch_retire_pool(thread, pool, ptr)                                   \
+    epoch_retire((thread), (ptr), epoch_free_pool, (pool))
+
+// Tries to advance the global epoch and frees whatever this thread retired
+// that is now safe.  Returns the number of objects freed.
+usize epoch_collect(EpochThread* thread);
+
+// Number of objects this thread has retired but not yet freed.
+usize epoch_pending(EpochThread* thread);
+
+//------------------------------------------------------------------------------[Snapshot]
+
+// Two ways to share read-mostly data (configuration, routing tables) so that
+// readers never write to a cache line another thread reads.
+//
+// A SeqLock suits small plain structs that can be copied out.  Writers bump a
+// sequence number to odd, update the data and bump it back to even.  Readers
+// copy the data between two loads of the sequence and retry if it moved, so
+// a read is two loads and a copy.  Readers spin while a write is in progress,
+// so writes must be short and rare.
+//
+//      Limits limits;
+//      seqlock_read(&g_limits_lock, &limits, &g_limits, sizeof(limits));
+//
+// A Snapshot publishes a pointer to an immutable object.  Readers pin the
+// current object with snapshot_read_begin(), which costs one epoch_enter()
+// and one load, and can use it until snapshot_read_end().  Writers build a new
+// object and publish it; the old one is freed through the epoch domain once
+// no reader can still hold it.  Readers and writers need an EpochThread from
+// the snapshot's domain.
+//
+//      const Routes* routes = snapshot_read_begin(&g_routes, me);
+//      ... look up routes ...
+//      snapshot_read_end(&g_routes, me);
+//
+//      Routes* fresh = routes_copy(snapshot_current(&g_routes));
+//      routes_add(fresh, ...);
+//      snapshot_publish(&g_routes, me, fresh);
+//
+
+typedef struct {
+    u32 sequence; // Odd while a writer is inside
+} SeqLock;
+
+void seqlock_init(SeqLock* lock);
+
+// Returns the sequence to pass to seqlock_read_retry(), waiting out any write
+// in progress.
+u32 seqlock_read_begin(SeqLock* lock);
+
+// True if a write overlapped the read that began with `start`, so whatever
+// was read must be discarded.
+bool seqlock_read_retry(SeqLock* lock, u32 start);
+
+// Writers exclude each other, but never wait for readers.
+void seqlock_write_lock(SeqLock* lock);
+void seqlock_write_unlock(SeqLock* lock);
+
+// Copies `size` bytes between `data` and `out` or `in` as one consistent read
+// or write.
+void seqlock_read(SeqLock* lock, void* out, const void* data, usize size);
+void seqlock_write(SeqLock* lock, void* data, const void* in, usize size);
+
+typedef struct {
+    void*         current;      // Latest published object
+    EpochDomain*  domain;       // Domain that defers frees
+    EpochFreeFunc free_func;    // Frees objects that have been replaced
+    void*         free_context; // Passed to `free_func`
+} Snapshot;
+
+typedef struct {
+    EpochDomain*  domain;       // Required
+    void*         initial;      // First published object, may be NULL
+    EpochFreeFunc free_func;    // NULL uses epoch_free_mem
+    void*         free_context; // Passed to `free_func`
+} SnapshotDefaultParams;
+
+void _snapshot_init(Snapshot* snapshot, SnapshotDefaultParams params);
+
+#define snapshot_init(snapshot, ...)                                           \
+    _snapshot_init((snapshot), (SnapshotDefaultParams){__VA_ARGS__})
+
+// Frees the current object at once, so no reader may still be inside.
+void snapshot_done(Snapshot* snapshot);
+
+// Pins the current object until snapshot_read_end().  Reads nest, and the
+// object must not be modified.
+const void* snapshot_read_begin(Snapshot* snapshot, EpochThread* thread);
+void        snapshot_read_end(Snapshot* snapshot, EpochThread* thread);
+
+// Replaces the current object with `fresh` and retires the old one.  Writers
+// that derive `fresh` from snapshot_current() must serialise themselves.
+void snapshot_publish(Snapshot* snapshot, EpochThread* thread, void* fresh);
+
+// The current object, for writers building its replacement.
+void* snapshot_current(Snapshot* snapshot);
 
 //------------------------------------------------------------------------------[Output]
 
+// Output is buffered per thread, so printing is a format and a copy with no
+// lock.  Buffers are written out a whole number of lines at a time, in one
+// system call under the output lock, so lines from different threads never
+// mix; only a line longer than the buffer is split.
+//
+// A thread's buffers are written out by its stream's flush policy, when they
+// fill, by pr_flush(), when the thread ends (however it was created) and at
+// exit, which also writes out threads that are still running.  Printing to
+// stderr first writes out the same thread's stdout, to keep them in order.
+
+#define OUTPUT_BUFFER_SIZE KB(4)
+
+typedef enum {
+    OUTPUT_FLUSH_AUTO,  // Lines on a terminal, full otherwise (stdout default)
+    OUTPUT_FLUSH_LINES, // After every print that ends a line (stderr default)
+    OUTPUT_FLUSH_FULL,  // Only when the buffer fills or is flushed
+} OutputFlush;
+
+void pr_set_flush(OutputFlush flush);
+void epr_set_flush(OutputFlush flush);
+
+// Writes out the calling thread's buffered stdout and stderr.
+void pr_flush(void);
+
 void prv(const char* format, va_list args);
 void pr(const char* format, ...);
 void prn(const char* format, ...);
@@ -557,6 +1814,359 @@ TimeDuration time_from_ms(u64 milliseconds);
 TimeDuration time_from_us(u64 microseconds);
 TimeDuration time_from_ns(u64 nanoseconds);
 
+//------------------------------------------------------------------------------[Timer]
+
+// A hierarchical timer wheel keeps millions of pending deadlines with O(1)
+// schedule, reschedule and cancel.  Time is cut into ticks (1ms by default)
+// counted from the wheel's start.  Level 0 has one slot per tick for the next
+// 64 ticks, and each level above has slots 64 times wider.  A timer goes into
+// the lowest level that reaches its deadline and moves down a level each time
+// the wheel reaches the start of its slot, so every timer is touched at most
+// once per level.  Bitmaps of occupied slots let timer_wheel_advance() skip
+// empty ticks, so a wheel can sleep for hours and catch up in one call.
+//
+// Timers fire from timer_wheel_advance() on the first tick at or after their
+// deadline, never early.  Each due tick is detached as a batch and its
+// callbacks run one after another; callbacks may schedule and cancel timers,
+// and timers they schedule fire no earlier than the next tick.  Timers are
+// carved from a pool in the wheel's own arena, so churn never reaches malloc.
+//
+// A wheel belongs to one thread.  Handles stay safe to use after their timer
+// has fired or been cancelled: they simply stop matching.
+//
+//      TimerWheel wheel;
+//      timer_wheel_init(&wheel);
+//      TimerHandle timeout = timer_schedule(
+//          &wheel, time_add_duration(time_now(), time_from_secs(5)),
+//          on_timeout, connection);
+//      ...
+//      int wait_ms = timer_wheel_timeout_ms(&wheel, time_now());
+//      epoll_wait(epoll, events, count, wait_ms);
+//      timer_wheel_advance(&wheel, time_now());
+//
+
+#define TIMER_WHEEL_LEVELS 6
+#define TIMER_WHEEL_SLOT_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_NEVER ((TimePoint)~0ull)
+
+typedef void (*TimerFunc)(void* context);
+
+typedef struct Timer {
+    struct Timer*  next;       // Next timer in the same slot
+    struct Timer** pprev;      // Link that points at this timer
+    u64            expires;    // Tick the timer is due on
+    u64            generation; // Matches live handles only
+    TimerFunc      func;       // Called as func(context)
+    void*          context;    // Passed to `func`
+    u32            bucket;     // Slot index, or the firing batch
+} Timer;
+
+// Returned by timer_schedule().  A zeroed handle refers to no timer.
+typedef struct {
+    Timer* timer;
+    u64    generation;
+} TimerHandle;
+
+typedef struct {
+    Timer*       slots[TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS];
+    u64          occupied[TIMER_WHEEL_LEVELS]; // Bit per non-empty slot
+    Timer*       firing;     // Batch whose callbacks are running
+    u64          now;        // Last tick processed
+    TimePoint    origin;     // Time of tick 0
+    TimeDuration tick;       // Length of a tick
+    u64          generation; // Last generation handed out
+    usize        count;      // Pending timers
+    Arena        arena;      // Backing store for `timers`
+    Pool         timers;     // Timer records
+} TimerWheel;
+
+typedef struct {
+    TimeDuration tick;  // 0 uses 1ms
+    TimePoint    start; // 0 uses time_now()
+} TimerWheelDefaultParams;
+
+void _timer_wheel_init(TimerWheel* wheel, TimerWheelDefaultParams params);
+
+#define timer_wheel_init(wheel, ...)                                           \
+    _timer_wheel_init((wheel), (TimerWheelDefaultParams){__VA_ARGS__})
+
+// Pending timers are dropped without firing.
+void timer_wheel_done(TimerWheel* wheel);
+
+// Calls func(context) once `deadline` has passed.  Deadlines already in the
+// past fire on the next tick.
+TimerHandle timer_schedule(TimerWheel* wheel,
+                           TimePoint   deadline,
+                           TimerFunc   func,
+                           void*       context);
+
+// Moves a pending timer to a new deadline, keeping its handle.  Returns false
+// if the timer has already fired or been cancelled.
+bool timer_reschedule(TimerWheel* wheel,
+                      TimerHandle handle,
+                      TimePoint   deadline);
+
+// Returns false if the timer has already fired or been cancelled.
+bool timer_cancel(TimerWheel* wheel, TimerHandle handle);
+bool timer_pending(TimerWheel* wheel, TimerHandle handle);
+
+// Fires every timer due at `now` and returns how many fired.
+usize timer_wheel_advance(TimerWheel* wheel, TimePoint now);
+
+// Time by which timer_wheel_advance() must next be called, or TIMER_NEVER if
+// nothing is pending.  This can be earlier than the first deadline, when a
+// slot needs moving down a level, so callers loop on advance and query.
+TimePoint timer_wheel_next_deadline(TimerWheel* wheel);
+
+// The same as a poll()/epoll_wait() timeout in milliseconds, rounded up: -1
+// when nothing is pending and 0 when a tick is already due.
+int timer_wheel_timeout_ms(TimerWheel* wheel, TimePoint now);
+
+//------------------------------------------------------------------------------[Fiber]
+
+// Stackful fibers: cooperative tasks that each run on their own small stack
+// and switch in tens of nanoseconds, so thousands can be in flight per thread.
+// A FiberScheduler runs its fibers on the one thread that calls
+// fiber_scheduler_run(), which returns once every fiber has finished.
+//
+// A fiber gives up the thread by yielding or by parking.  Parked fibers are
+// resumed by fiber_unpark(), which may be called from any thread, or when a
+// deadline passes.  Channels park the calling fiber instead of blocking the
+// thread, so fibers can block on channels freely.  Other blocking calls
+// (mutexes, I/O, job_wait) still block the whole thread.
+//
+// Each stack is a separate mapping with a guard page below it, so an overflow
+// faults instead of corrupting a neighbour.  That costs two OS mappings per
+// live fiber, so Linux's default vm.max_map_count allows roughly 30000 at once.
+// Finished stacks are kept on a free list for reuse.  Fibers switch with a few
+// instructions of assembly on x86_64 and ARM64, with OS fibers on Windows and
+// with ucontext elsewhere.
+//
+// Fibers on a thread would otherwise share its scratch arenas, and one that
+// held scratch memory across a yield, a park or a channel call could see
+// another rewind and reuse it.  So each fiber gets scratch arenas of its own,
+// swapped in while it runs.  They reserve `scratch_size` bytes each, smaller
+// than a thread's so that many fibers fit in the address space, and are only
+// mapped once the fiber calls scratch_begin().  They are rewound when the
+// fiber finishes and kept with its stack for reuse.
+//
+//      FiberScheduler scheduler;
+//      fiber_scheduler_init(&scheduler, .stack_size = KB(32));
+//      fiber_spawn(&scheduler, producer, &channel);
+//      fiber_spawn(&scheduler, consumer, &channel);
+//      fiber_scheduler_run(&scheduler);
+//      fiber_scheduler_done(&scheduler);
+//
+
+#define FIBER_DEFAULT_STACK_SIZE KB(64)
+#define FIBER_DEFAULT_FREE_STACKS 256
+#define FIBER_DEFAULT_SCRATCH_SIZE MB(256)
+#define FIBER_FOREVER ((TimePoint)~0ull)
+
+#define FIBER_SWITCH_ASM (OS_POSIX && (ARCH_X86_64 || ARCH_ARM64))
+
+typedef void (*FiberFunc)(void* context);
+
+// Saved stack pointer, OS fiber handle or ucontext, depending on the platform.
+typedef struct {
+    void* handle;
+} FiberContext;
+
+typedef enum {
+    FIBER_READY,   // In the ready queue
+    FIBER_RUNNING, // Running on the scheduler's thread
+    FIBER_PARKED,  // Waiting for fiber_unpark() or a deadline
+    FIBER_DONE,    // Finished; its stack is about to be recycled
+} FiberState;
+
+typedef struct Fiber {
+    FiberContext           registers; // Saved while switched out
+    struct FiberScheduler* scheduler; // Scheduler that runs the fiber
+    FiberFunc              func;      // Function to run
+    void*                  context;   // Argument passed to `func`
+    FiberState             state;     // Protected by the scheduler's lock
+    bool                   notified;  // Unparked while not parked
+    bool                   timed_out; // Last park ended at its deadline
+    TimePoint              deadline;  // Wake time while in `sleepers`
+    struct Fiber*          next;      // Ready queue, sleepers or free list
+    struct Fiber*          prev;      // Sleepers list
+    u8*                    mapping;   // Stack mapping, including guard page
+    usize                  mapping_size; // Bytes in `mapping`
+    // Scratch arenas of its own, swapped in while it runs and set up when it
+    // first asks for one.
+    Arena                  scratch[ARENA_SCRATCH_COUNT];
+} Fiber;
+
+typedef struct FiberScheduler {
+    AdaptiveMutex lock;          // Protects everything below except `current`
+    FiberContext  registers;     // The scheduler thread's own context
+    Fiber*        current;       // Fiber running now (scheduler thread only)
+    Fiber*        ready_head;    // Fibers waiting to run, in FIFO order
+    Fiber*        ready_tail;    // Last fiber in the ready queue
+    Fiber*        sleepers;      // Parked fibers with a deadline
+    TimePoint     next_deadline; // Earliest deadline in `sleepers`
+    Fiber*        free_stacks;   // Finished fibers whose stacks can be reused
+    usize         free_count;    // Number of fibers in `free_stacks`
+    usize         max_free;      // Most stacks kept in `free_stacks`
+    usize         live;          // Spawned fibers that have not finished
+    usize         stack_size;    // Usable stack bytes per fiber
+    usize         scratch_size;  // Bytes reserved per fiber scratch arena
+    u32           signal;        // Futex word bumped when a fiber is readied
+    bool          idle;          // Scheduler thread is sleeping on `signal`
+    bool          running;       // fiber_scheduler_run() is active
+} FiberScheduler;
+
+typedef struct {
+    usize stack_size;      // 0 uses FIBER_DEFAULT_STACK_SIZE
+    usize max_free_stacks; // 0 uses FIBER_DEFAULT_FREE_STACKS
+    usize scratch_size;    // 0 uses FIBER_DEFAULT_SCRATCH_SIZE
+} FiberSchedulerDefaultParams;
+
+void _fiber_scheduler_init(FiberScheduler*             scheduler,
+                           FiberSchedulerDefaultParams params);
+
+#define fiber_scheduler_init(scheduler, ...)                                   \
+    _fiber_scheduler_init((scheduler),                                         \
+                          (FiberSchedulerDefaultParams){__VA_ARGS__})
+
+void fiber_scheduler_done(FiberScheduler* scheduler);
+
+// Runs fibers on the calling thread until none are left.
+void fiber_scheduler_run(FiberScheduler* scheduler);
+
+// Creates a ready fiber.  May be called from any thread, but fibers spawned
+// from outside the scheduler must be spawned before it runs out of fibers.
+// The returned pointer is only valid until the fiber finishes.
+Fiber* fiber_spawn(FiberScheduler* scheduler, FiberFunc func, void* context);
+
+// Returns the fiber running on this thread, or NULL outside a fiber.
+Fiber* fiber_current(void);
+
+// Lets the other ready fibers run before continuing.
+void fiber_yield(void);
+
+// Suspends the current fiber until it is unparked or `deadline` passes, and
+// returns false on timeout.  An unpark that arrives while the fiber is running
+// makes the next park return at once, so wakeups are never lost, but parks can
+// return early: callers must re-check their own condition.
+bool fiber_park_until(TimePoint deadline);
+void fiber_park(void);
+void fiber_unpark(Fiber* fiber);
+
+//------------------------------------------------------------------------------[Channel]
+
+// Bounded channels for pipeline stages that should sleep rather than spin.  A
+// channel is a ring of fixed-size elements behind an AdaptiveMutex.  Blocked
+// threads sleep on a futex word of their own and are only woken when the
+// state they wait for changes, so a send to a channel with no waiting receiver
+// never enters the kernel.  Batch functions move as many elements as fit under
+// one lock and one wakeup.
+//
+// Once closed, sends fail and receives drain the remaining elements before
+// reporting CHANNEL_CLOSED.
+//
+// The send and receive macros take typed pointers and assert that the pointee
+// matches the channel's element size:
+//
+//      Channel c;
+//      channel_init(&c, arena, 64, sizeof(Message));
+//      channel_send(&c, &message);
+//      while (channel_recv(&c, &message)) { ... }
+//
+// channel_select() receives from whichever of several channels has an element
+// first, earlier channels winning ties.
+//
+// A fiber that blocks on a channel parks rather than sleeping its thread.
+
+#define CHANNEL_FOREVER ((TimeDuration)~0ull)
+#define CHANNEL_SELECT_MAX 16
+
+typedef enum {
+    CHANNEL_OK,
+    CHANNEL_TIMEOUT,
+    CHANNEL_CLOSED,
+} ChannelResult;
+
+typedef struct ChannelWaiter {
+    struct ChannelWaiter* next;
+    struct ChannelWaiter* prev;
+    u32*                  woken;  // Futex word, set to 1 to wake the thread
+    Fiber*                fiber;  // Parked fiber to unpark, if not a thread
+    bool                  select; // Woken by every send, not just one
+    bool                  linked; // Still in the channel's list
+} ChannelWaiter;
+
+typedef struct {
+    AdaptiveMutex  lock;
+    u8*            buffer;       // capacity * element_size bytes
+    usize          capacity;     // Number of slots
+    usize          element_size; // Size of each element in bytes
+    usize          head;         // Slot of the next element to receive
+    usize          count;        // Elements in the channel
+    bool           closed;
+    ChannelWaiter* receivers; // Threads waiting for an element
+    ChannelWaiter* senders;   // Threads waiting for a free slot
+} Channel;
+
+void channel_init(Channel* channel,
+                  Arena*   arena,
+                  usize    capacity,
+                  usize    element_size);
+void channel_done(Channel* channel);
+void channel_close(Channel* channel);
+
+#define channel_send(c, element)                                               \
+    _channel_send((c), (element), sizeof(*(element)))
+#define channel_try_send(c, element)                                           \
+    _channel_try_send((c), (element), sizeof(*(element)))
+#define channel_send_batch(c, elements, count)                                 \
+    _channel_send_batch((c), (elements), (count), sizeof(*(elements)))
+#define channel_recv(c, element)                                               \
+    _channel_recv((c), (element), sizeof(*(element)))
+#define channel_try_recv(c, element)                                           \
+    _channel_try_recv((c), (element), sizeof(*(element)))
+#define channel_recv_timeout(c, element, timeout)                              \
+    _channel_recv_timeout((c), (element), sizeof(*(element)), (timeout))
+#define channel_recv_batch(c, elements, count)                                 \
+    _channel_recv_batch((c), (elements), (count), sizeof(*(elements)))
+
+// Blocks while the channel is full.  Returns false if it is closed.
+bool _channel_send(Channel* channel, const void* element, usize size);
+bool _channel_try_send(Channel* channel, const void* element, usize size);
+
+// Blocks until all `count` elements are sent, returning fewer if the channel
+// is closed first.
+usize _channel_send_batch(Channel*    channel,
+                          const void* elements,
+                          usize       count,
+                          usize       size);
+
+// Blocks while the channel is empty.  Returns false once it is closed and
+// drained.
+bool _channel_recv(Channel* channel, void* element, usize size);
+bool _channel_try_recv(Channel* channel, void* element, usize size);
+ChannelResult _channel_recv_timeout(Channel*     channel,
+                                    void*        element,
+                                    usize        size,
+                                    TimeDuration timeout);
+
+// Blocks until at least one element is available and receives up to `count`.
+// Returns 0 once the channel is closed and drained.
+usize _channel_recv_batch(Channel* channel,
+                          void*    elements,
+                          usize    count,
+                          usize    size);
+
+// Receives one element from the first of `channels` to have one, writing the
+// channel's index to `*index`.  `element` must be large enough for any of the
+// channels.  Returns CHANNEL_CLOSED once every channel is closed and drained.
+ChannelResult channel_select(Channel**    channels,
+                             usize        count,
+                             void*        element,
+                             usize*       index,
+                             TimeDuration timeout);
+
 //------------------------------------------------------------------------------[Random]
 
 void random_seed(u64 seed);
@@ -571,15 +2181,59 @@ typedef struct {
     usize size;
 
 #if OS_WINDOWS
-// Windows-specific file-mapping state
+    // Windows-specific file-mapping state
+    HANDLE file;
+    HANDLE mapping;
 #elif OS_POSIX
 // POSIX-specific file-mapping state
 #endif
 } Data;
 
+// Maps a whole file into memory read-only.
 bool data_load(cstr path, Data* data);
+
+// Maps a whole file copy-on-write: writes are private to the process and never
+// reach the file.
+bool data_load_cow(cstr path, Data* data);
+
 void data_unload(Data* data);
 
+//------------------------------------------------------------------------------
+// Arena snapshots
+//
+// The used region of an arena can be written to a file and mapped back later
+// without copying or fixing up.  Data inside must not hold absolute pointers:
+// use references from the arena base (Ref32/Ref64) or self-relative pointers.
+// Chained arenas are not contiguous and cannot be snapshotted.
+
+#define ARENA_SNAPSHOT_MAGIC 0x31504e534e524b41ull // "AKRNSNP1"
+#define ARENA_SNAPSHOT_HEADER_SIZE 64
+
+typedef struct {
+    Data  file;   // Mapping of the whole snapshot file
+    u8*   memory; // Equivalent of the arena's memory pointer
+    usize size;   // Number of bytes of arena data
+} ArenaSnapshot;
+
+bool arena_snapshot_save(Arena* arena, cstr path);
+bool arena_snapshot_load(ArenaSnapshot* snapshot, cstr path, bool writable);
+void arena_snapshot_unload(ArenaSnapshot* snapshot);
+
+//------------------------------------------------------------------------------
+// Self-relative pointers
+//
+// A self-relative pointer stores the distance from the field itself to the
+// target, so a structure that only links to memory in the same mapping stays
+// valid wherever the mapping lands.  Zero is NULL.
+
+typedef i64 SelfPtr;
+
+#define self_ptr_set(field, target)                                            \
+    (*(field) = (target) ? (SelfPtr)((u8*)(target) - (u8*)(field)) : 0)
+
+#define self_ptr_get(type, field)                                              \
+    (*(field) ? (type*)((u8*)(field) + *(field)) : (type*)NULL)
+
 //------------------------------------------------------------------------------[String]
 
 DEF_SLICE(u8) string;
@@ -0,0 +1,195 @@
+//------------------------------------------------------------------------------
+// Data implementation
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+
+#include <core/core.h>
+
+#include <stdio.h>
+
+#if OS_POSIX
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#endif
+
+//------------------------------------------------------------------------------
+
+#if OS_WINDOWS
+
+internal bool _data_map(cstr path, Data* data, bool copy_on_write)
+{
+    memset(data, 0, sizeof(Data));
+
+    data->file = CreateFileA(path,
+                             GENERIC_READ,
+                             FILE_SHARE_READ,
+                             NULL,
+                             OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL,
+                             NULL);
+    if (data->file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(data->file, &size)) {
+        CloseHandle(data->file);
+        return false;
+    }
+    data->size = (usize)size.QuadPart;
+    if (data->size == 0) {
+        return true;
+    }
+
+    data->mapping = CreateFileMappingA(data->file,
+                                       NULL,
+                                       copy_on_write ? PAGE_WRITECOPY
+                                                     : PAGE_READONLY,
+                                       0,
+                                       0,
+                                       NULL);
+    if (!data->mapping) {
+        CloseHandle(data->file);
+        return false;
+    }
+
+    data->data = (u8*)MapViewOfFile(
+        data->mapping, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+    if (!data->data) {
+        CloseHandle(data->mapping);
+        CloseHandle(data->file);
+        return false;
+    }
+
+    return true;
+}
+
+void data_unload(Data* data)
+{
+    if (data->data) {
+        UnmapViewOfFile(data->data);
+    }
+    if (data->mapping) {
+        CloseHandle(data->mapping);
+    }
+    if (data->file && data->file != INVALID_HANDLE_VALUE) {
+        CloseHandle(data->file);
+    }
+    memset(data, 0, sizeof(Data));
+}
+
+#elif OS_POSIX
+
+internal bool _data_map(cstr path, Data* data, bool copy_on_write)
+{
+    memset(data, 0, sizeof(Data));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return false;
+    }
+
+    data->size = (usize)info.st_size;
+    if (data->size == 0) {
+        close(fd);
+        return true;
+    }
+
+    int   prot   = copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* memory = mmap(nullptr, data->size, prot, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps the file alive.
+
+    if (memory == MAP_FAILED) {
+        data->size = 0;
+        return false;
+    }
+
+    data->data = (u8*)memory;
+    return true;
+}
+
+void data_unload(Data* data)
+{
+    if (data->data) {
+        munmap(data->data, data->size);
+    }
+    memset(data, 0, sizeof(Data));
+}
+
+#else
+#    error "Data mapping not implemented for this OS."
+#endif // OS_WINDOWS
+
+bool data_load(cstr path, Data* data) { return _data_map(path, data, false); }
+
+bool data_load_cow(cstr path, Data* data)
+{
+    return _data_map(path, data, true);
+}
+
+//------------------------------------------------------------------------------
+// Arena snapshots
+
+typedef struct {
+    u64 magic; // ARENA_SNAPSHOT_MAGIC
+    u64 size;  // Bytes of arena data following the header
+    u8  reserved[ARENA_SNAPSHOT_HEADER_SIZE - 16];
+} ArenaSnapshotHeader;
+
+bool arena_snapshot_save(Arena* arena, cstr path)
+{
+    ASSERT(!arena->chained, "Chained arenas cannot be snapshotted.");
+
+    ArenaSnapshotHeader header = {
+        .magic = ARENA_SNAPSHOT_MAGIC,
+        .size  = arena_store(arena),
+    };
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(arena->memory, 1, (usize)header.size, file) ==
+                  (usize)header.size;
+    ok = (fclose(file) == 0) && ok;
+    return ok;
+}
+
+bool arena_snapshot_load(ArenaSnapshot* snapshot, cstr path, bool writable)
+{
+    memset(snapshot, 0, sizeof(ArenaSnapshot));
+
+    bool loaded = writable ? data_load_cow(path, &snapshot->file)
+                           : data_load(path, &snapshot->file);
+    if (!loaded) {
+        return false;
+    }
+
+    ArenaSnapshotHeader* header = (ArenaSnapshotHeader*)snapshot->file.data;
+    if (snapshot->file.size < sizeof(ArenaSnapshotHeader) ||
+        header->magic != ARENA_SNAPSHOT_MAGIC ||
+        header->size > snapshot->file.size - sizeof(ArenaSnapshotHeader)) {
+        data_unload(&snapshot->file);
+        return false;
+    }
+
+    snapshot->memory = snapshot->file.data + sizeof(ArenaSnapshotHeader);
+    snapshot->size   = (usize)header->size;
+    return true;
+}
+
+void arena_snapshot_unload(ArenaSnapshot* snapshot)
+{
+    data_unload(&snapshot->file);
+    memset(snapshot, 0, sizeof(ArenaSnapshot));
+}
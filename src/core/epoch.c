@@ -0,0 +1,217 @@
+//------------------------------------------------------------------------------
+// Epoch-based reclamation
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+
+#include <core/core.h>
+
+#if OS_POSIX
+#    include <sched.h>
+#endif // OS_POSIX
+
+//------------------------------------------------------------------------------
+// Limbo lists, touched only by the owning thread
+
+internal void _epoch_limbo_push(EpochThread* thread,
+                                EpochLimbo*  limbo,
+                                EpochRetired retired)
+{
+    EpochLimboChunk* chunk = limbo->head;
+    if (!chunk || chunk->count == EPOCH_LIMBO_CHUNK) {
+        chunk        = pool_new(&thread->chunks, EpochLimboChunk);
+        chunk->next  = limbo->head;
+        chunk->count = 0;
+        limbo->head  = chunk;
+    }
+    chunk->items[chunk->count++] = retired;
+    limbo->count++;
+}
+
+internal usize _epoch_limbo_free(EpochThread* thread, EpochLimbo* limbo)
+{
+    usize freed = limbo->count;
+    while (limbo->head) {
+        EpochLimboChunk* chunk = limbo->head;
+        for (usize i = 0; i < chunk->count; ++i) {
+            EpochRetired* retired = &chunk->items[i];
+            retired->func(retired->context, retired->ptr);
+        }
+        limbo->head = chunk->next;
+        pool_free(&thread->chunks, chunk);
+    }
+    limbo->count = 0;
+    return freed;
+}
+
+// Frees every limbo list retired at least two epochs before `epoch`.
+internal usize _epoch_reclaim(EpochThread* thread, u64 epoch)
+{
+    usize freed = 0;
+    for (usize i = 0; i < EPOCH_LIMBO_COUNT; ++i) {
+        EpochLimbo* limbo = &thread->limbo[i];
+        if (limbo->count && limbo->epoch + 2 <= epoch) {
+            freed += _epoch_limbo_free(thread, limbo);
+        }
+    }
+    return freed;
+}
+
+//------------------------------------------------------------------------------
+
+// Advances the global epoch if every thread inside a critical section has seen
+// it.  Returns the global epoch afterwards.
+internal u64 _epoch_try_advance(EpochDomain* domain)
+{
+    atomic_fence(MEMORY_SEQ_CST);
+    u64 epoch = atomic_load_u64(&domain->epoch, MEMORY_ACQUIRE);
+
+    EpochThread* thread =
+        atomic_load_ptr((void**)&domain->threads, MEMORY_ACQUIRE);
+    for (; thread; thread = thread->next) {
+        u64 state = atomic_load_u64(&thread->state, MEMORY_ACQUIRE);
+        if ((state & 1) && (state >> 1) != epoch) {
+            return epoch;
+        }
+    }
+
+    // Losing the race means another thread advanced it for us.
+    u64 expected = epoch;
+    atomic_cas_u64(&domain->epoch, &expected, epoch + 1, MEMORY_ACQ_REL);
+    return expected == epoch ? epoch + 1 : expected;
+}
+
+void _epoch_domain_init(EpochDomain* domain, EpochDomainDefaultParams params)
+{
+    memset(domain, 0, sizeof(*domain));
+    mutex_init(&domain->register_mutex, .name = "epoch_register");
+    arena_init(&domain->arena, .reserved_size = GB(1), .concurrent = true);
+    domain->collect_threshold = params.collect_threshold
+                                    ? params.collect_threshold
+                                    : EPOCH_DEFAULT_COLLECT_THRESHOLD;
+}
+
+void epoch_domain_done(EpochDomain* domain)
+{
+    for (EpochThread* thread = domain->threads; thread;
+         thread              = thread->next) {
+        ASSERT(!thread->in_use, "Epoch domain destroyed with threads.");
+    }
+    arena_done(&domain->arena);
+    mutex_done(&domain->register_mutex);
+}
+
+EpochThread* epoch_register(EpochDomain* domain)
+{
+    mutex_lock(&domain->register_mutex);
+
+    EpochThread* thread = domain->threads;
+    while (thread && thread->in_use) {
+        thread = thread->next;
+    }
+    if (!thread) {
+        thread =
+            arena_alloc_align(&domain->arena, sizeof(*thread), CACHE_LINE);
+        memset(thread, 0, sizeof(*thread));
+        thread->domain = domain;
+        pool_init_typed(&thread->chunks, &domain->arena, EpochLimboChunk);
+
+        // Collectors walk the list without the mutex.
+        thread->next = domain->threads;
+        atomic_store_ptr((void**)&domain->threads, thread, MEMORY_RELEASE);
+    }
+    thread->in_use = true;
+
+    mutex_unlock(&domain->register_mutex);
+    return thread;
+}
+
+void epoch_unregister(EpochThread* thread)
+{
+    ASSERT(thread->depth == 0, "Unregistering inside a critical section.");
+
+    // Each advance needs every reader to move on, so yield while waiting.
+    while (epoch_pending(thread)) {
+        if (!epoch_collect(thread)) {
+#if OS_WINDOWS
+            SwitchToThread();
+#else
+            sched_yield();
+#endif // OS_WINDOWS
+        }
+    }
+
+    mutex_lock(&thread->domain->register_mutex);
+    thread->in_use  = false;
+    thread->retires = 0;
+    mutex_unlock(&thread->domain->register_mutex);
+}
+
+//------------------------------------------------------------------------------
+
+void epoch_enter(EpochThread* thread)
+{
+    if (thread->depth++ > 0) {
+        return;
+    }
+    u64 epoch = atomic_load_u64(&thread->domain->epoch, MEMORY_RELAXED);
+    atomic_store_u64(&thread->state, (epoch << 1) | 1, MEMORY_RELAXED);
+
+    // The announcement must be visible before any shared pointer is read.
+    atomic_fence(MEMORY_SEQ_CST);
+}
+
+void epoch_exit(EpochThread* thread)
+{
+    ASSERT(thread->depth > 0, "epoch_exit() without epoch_enter().");
+    if (--thread->depth == 0) {
+        atomic_store_u64(&thread->state, 0, MEMORY_RELEASE);
+    }
+}
+
+void epoch_retire(EpochThread*  thread,
+                  void*         ptr,
+                  EpochFreeFunc func,
+                  void*         context)
+{
+    // Read the epoch after the unlink that preceded this call.
+    atomic_fence(MEMORY_SEQ_CST);
+    u64 epoch = atomic_load_u64(&thread->domain->epoch, MEMORY_ACQUIRE);
+
+    // The list for this epoch last held objects from three epochs ago, which
+    // are already safe.
+    EpochLimbo* limbo = &thread->limbo[epoch % EPOCH_LIMBO_COUNT];
+    if (limbo->count && limbo->epoch != epoch) {
+        _epoch_limbo_free(thread, limbo);
+    }
+    limbo->epoch = epoch;
+    _epoch_limbo_push(thread, limbo, (EpochRetired){ptr, func, context});
+
+    if (++thread->retires >= thread->domain->collect_threshold) {
+        epoch_collect(thread);
+    }
+}
+
+usize epoch_collect(EpochThread* thread)
+{
+    thread->retires = 0;
+    u64 epoch       = _epoch_try_advance(thread->domain);
+    return _epoch_reclaim(thread, epoch);
+}
+
+usize epoch_pending(EpochThread* thread)
+{
+    usize pending = 0;
+    for (usize i = 0; i < EPOCH_LIMBO_COUNT; ++i) {
+        pending += thread->limbo[i].count;
+    }
+    return pending;
+}
+
+void epoch_free_mem(void* context, void* ptr)
+{
+    UNUSED(context);
+    mem_free(ptr, __FILE__, __LINE__);
+}
+
+void epoch_free_pool(void* context, void* ptr) { pool_free(context, ptr); }
@@ -0,0 +1,595 @@
+//------------------------------------------------------------------------------
+// Fiber implementation
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+
+#include <core/core.h>
+
+#include <stdio.h>
+
+#if OS_POSIX
+#    include <sys/mman.h>
+#    if !FIBER_SWITCH_ASM
+#        include <ucontext.h>
+#    endif
+#endif // OS_POSIX
+
+// Scheduler running on this thread, if any.  Fibers never move between
+// threads, so this stays valid across switches.
+thread_local global_variable FiberScheduler* g_fiber_scheduler = NULL;
+
+//------------------------------------------------------------------------------
+// Context switching
+//
+// _kore_fiber_switch(from, to) saves the callee-saved registers on the current
+// stack, stores the stack pointer in `from->handle`, loads `to->handle` and
+// restores the registers saved there.  A new fiber's stack is laid out as if
+// it had switched away just before entering _fiber_entry().
+
+internal void _fiber_entry(void);
+
+#if FIBER_SWITCH_ASM
+
+void _kore_fiber_switch(FiberContext* from, FiberContext* to);
+
+#    if OS_MACOS
+#        define FIBER_ASM_FUNCTION(name)                                       \
+            ".globl _" name "\n"                                               \
+            "_" name ":\n"
+#    else
+#        define FIBER_ASM_FUNCTION(name)                                       \
+            ".globl " name "\n"                                                \
+            ".type " name ", %function\n" name ":\n"
+#    endif
+
+#    if ARCH_X86_64
+
+// MXCSR and the x87 control word are callee-saved too.
+__asm__(".text\n"
+        ".p2align 4\n" FIBER_ASM_FUNCTION("_kore_fiber_switch") //
+        "    pushq %rbp\n"
+        "    pushq %rbx\n"
+        "    pushq %r12\n"
+        "    pushq %r13\n"
+        "    pushq %r14\n"
+        "    pushq %r15\n"
+        "    subq $8, %rsp\n"
+        "    stmxcsr (%rsp)\n"
+        "    fnstcw 4(%rsp)\n"
+        "    movq %rsp, (%rdi)\n"
+        "    movq (%rsi), %rsp\n"
+        "    ldmxcsr (%rsp)\n"
+        "    fldcw 4(%rsp)\n"
+        "    addq $8, %rsp\n"
+        "    popq %r15\n"
+        "    popq %r14\n"
+        "    popq %r13\n"
+        "    popq %r12\n"
+        "    popq %rbx\n"
+        "    popq %rbp\n"
+        "    ret\n");
+
+#        define FIBER_FRAME_WORDS 9 // Control words, 6 registers, entry, pad
+
+internal void* _fiber_initial_stack(u8* top)
+{
+    u64* sp = (u64*)top - FIBER_FRAME_WORDS;
+    memset(sp, 0, FIBER_FRAME_WORDS * sizeof(u64));
+    sp[0] = 0x037F00001F80ull; // Default MXCSR and x87 control word
+    sp[7] = (u64)(usize)_fiber_entry;
+    return sp;
+}
+
+#    elif ARCH_ARM64
+
+// x19-x28, the frame pointer, the link register and the low halves of v8-v15.
+__asm__(".text\n"
+        ".p2align 4\n" FIBER_ASM_FUNCTION("_kore_fiber_switch") //
+        "    sub sp, sp, #160\n"
+        "    stp x19, x20, [sp, #0]\n"
+        "    stp x21, x22, [sp, #16]\n"
+        "    stp x23, x24, [sp, #32]\n"
+        "    stp x25, x26, [sp, #48]\n"
+        "    stp x27, x28, [sp, #64]\n"
+        "    stp x29, x30, [sp, #80]\n"
+        "    stp d8, d9, [sp, #96]\n"
+        "    stp d10, d11, [sp, #112]\n"
+        "    stp d12, d13, [sp, #128]\n"
+        "    stp d14, d15, [sp, #144]\n"
+        "    mov x9, sp\n"
+        "    str x9, [x0]\n"
+        "    ldr x9, [x1]\n"
+        "    mov sp, x9\n"
+        "    ldp x19, x20, [sp, #0]\n"
+        "    ldp x21, x22, [sp, #16]\n"
+        "    ldp x23, x24, [sp, #32]\n"
+        "    ldp x25, x26, [sp, #48]\n"
+        "    ldp x27, x28, [sp, #64]\n"
+        "    ldp x29, x30, [sp, #80]\n"
+        "    ldp d8, d9, [sp, #96]\n"
+        "    ldp d10, d11, [sp, #112]\n"
+        "    ldp d12, d13, [sp, #128]\n"
+        "    ldp d14, d15, [sp, #144]\n"
+        "    add sp, sp, #160\n"
+        "    ret\n");
+
+#        define FIBER_FRAME_WORDS 20
+
+internal void* _fiber_initial_stack(u8* top)
+{
+    u64* sp = (u64*)top - FIBER_FRAME_WORDS;
+    memset(sp, 0, FIBER_FRAME_WORDS * sizeof(u64));
+    sp[11] = (u64)(usize)_fiber_entry; // Link register
+    return sp;
+}
+
+#    endif // ARCH_X86_64
+
+#elif OS_POSIX
+
+thread_local global_variable ucontext_t g_fiber_thread_context;
+
+#endif // FIBER_SWITCH_ASM
+
+internal void _fiber_switch(FiberContext* from, FiberContext* to)
+{
+#if OS_WINDOWS
+    UNUSED(from);
+    SwitchToFiber(to->handle);
+#elif FIBER_SWITCH_ASM
+    _kore_fiber_switch(from, to);
+#else
+    swapcontext((ucontext_t*)from->handle, (ucontext_t*)to->handle);
+#endif
+}
+
+#if OS_WINDOWS
+internal VOID WINAPI _fiber_entry_windows(LPVOID parameter)
+{
+    UNUSED(parameter);
+    _fiber_entry();
+}
+#endif // OS_WINDOWS
+
+//------------------------------------------------------------------------------
+// Stacks
+//
+// Each fiber lives in one mapping: a guard page at the bottom, the stack above
+// it and a FiberBlock at the very top.  On Windows the OS owns fiber stacks
+// and the mapping only holds the block.
+
+typedef struct {
+    Fiber fiber;
+#if !OS_WINDOWS && !FIBER_SWITCH_ASM
+    ucontext_t context;
+#endif
+} FiberBlock;
+
+internal usize _fiber_page_size(void)
+{
+    local_persist usize page_size = 0;
+    if (page_size == 0) {
+#if OS_WINDOWS
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        page_size = (usize)info.dwPageSize;
+#else
+        page_size = (usize)sysconf(_SC_PAGESIZE);
+#endif
+    }
+    return page_size;
+}
+
+internal Fiber* _fiber_map(FiberScheduler* scheduler)
+{
+    usize page = _fiber_page_size();
+
+#if OS_WINDOWS
+    UNUSED(scheduler);
+    usize size    = ALIGN_UP(sizeof(FiberBlock), page);
+    u8*   mapping = (u8*)VirtualAlloc(
+        nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    mem_check(mapping);
+#else
+    usize size  = page + ALIGN_UP(scheduler->stack_size + sizeof(FiberBlock),
+                                 page);
+    int   flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#    if defined(MAP_NORESERVE)
+    flags |= MAP_NORESERVE;
+#    endif
+#    if defined(MAP_STACK)
+    flags |= MAP_STACK;
+#    endif
+    u8* mapping =
+        (u8*)mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (mapping == MAP_FAILED) {
+        mapping = NULL;
+    }
+    mem_check(mapping);
+    if (mprotect(mapping, page, PROT_NONE) != 0) {
+        perror("mprotect");
+    }
+#endif // OS_WINDOWS
+
+    FiberBlock* block = (FiberBlock*)(mapping + size - sizeof(FiberBlock));
+    block = (FiberBlock*)((usize)block & ~(usize)(CACHE_LINE - 1));
+    memset(block, 0, sizeof(*block));
+    block->fiber.mapping      = mapping;
+    block->fiber.mapping_size = size;
+    return &block->fiber;
+}
+
+internal void _fiber_unmap(Fiber* fiber)
+{
+    for (usize i = 0; i < ARENA_SCRATCH_COUNT; ++i) {
+        if (fiber->scratch[i].memory) {
+            arena_done(&fiber->scratch[i]);
+        }
+    }
+#if OS_WINDOWS
+    VirtualFree(fiber->mapping, 0, MEM_RELEASE);
+#else
+    munmap(fiber->mapping, fiber->mapping_size);
+#endif
+}
+
+// Sets up a fiber's registers so that switching to it calls _fiber_entry().
+internal void _fiber_prepare(FiberScheduler* scheduler, Fiber* fiber)
+{
+#if OS_WINDOWS
+    fiber->registers.handle =
+        CreateFiber(scheduler->stack_size, _fiber_entry_windows, fiber);
+    mem_check(fiber->registers.handle);
+#else
+    UNUSED(scheduler);
+    u8*   stack = fiber->mapping + _fiber_page_size();
+    usize size  = (usize)((u8*)fiber - stack) & ~(usize)15;
+#    if FIBER_SWITCH_ASM
+    fiber->registers.handle = _fiber_initial_stack(stack + size);
+#    else
+    ucontext_t* context = &((FiberBlock*)fiber)->context;
+    getcontext(context);
+    context->uc_stack.ss_sp   = stack;
+    context->uc_stack.ss_size = size;
+    context->uc_link          = NULL;
+    makecontext(context, _fiber_entry, 0);
+    fiber->registers.handle = context;
+#    endif
+#endif // OS_WINDOWS
+}
+
+//------------------------------------------------------------------------------
+// Queues, with the scheduler's lock held
+
+internal void _fiber_push_ready(FiberScheduler* scheduler, Fiber* fiber)
+{
+    fiber->state = FIBER_READY;
+    fiber->next  = NULL;
+    if (scheduler->ready_tail) {
+        scheduler->ready_tail->next = fiber;
+    } else {
+        scheduler->ready_head = fiber;
+    }
+    scheduler->ready_tail = fiber;
+}
+
+internal Fiber* _fiber_pop_ready(FiberScheduler* scheduler)
+{
+    Fiber* fiber = scheduler->ready_head;
+    if (fiber) {
+        scheduler->ready_head = fiber->next;
+        if (!scheduler->ready_head) {
+            scheduler->ready_tail = NULL;
+        }
+    }
+    return fiber;
+}
+
+// Returns true if the scheduler thread is asleep and must be woken once the
+// lock is released.
+internal bool _fiber_signal(FiberScheduler* scheduler)
+{
+    atomic_fetch_add_u32(&scheduler->signal, 1, MEMORY_RELEASE);
+    return scheduler->idle;
+}
+
+internal void _fiber_sleep(FiberScheduler* scheduler, Fiber* fiber)
+{
+    fiber->prev = NULL;
+    fiber->next = scheduler->sleepers;
+    if (fiber->next) {
+        fiber->next->prev = fiber;
+    }
+    scheduler->sleepers      = fiber;
+    scheduler->next_deadline = MIN(scheduler->next_deadline, fiber->deadline);
+}
+
+internal void _fiber_unsleep(FiberScheduler* scheduler, Fiber* fiber)
+{
+    if (fiber->prev) {
+        fiber->prev->next = fiber->next;
+    } else {
+        scheduler->sleepers = fiber->next;
+    }
+    if (fiber->next) {
+        fiber->next->prev = fiber->prev;
+    }
+    fiber->deadline = FIBER_FOREVER;
+}
+
+// Readies every sleeper whose deadline has passed.  Only called once the
+// earliest deadline is due, so the scan is not paid on every switch.
+internal void _fiber_wake_expired(FiberScheduler* scheduler, TimePoint now)
+{
+    TimePoint next  = FIBER_FOREVER;
+    Fiber*    fiber = scheduler->sleepers;
+    while (fiber) {
+        Fiber* following = fiber->next;
+        if (fiber->deadline <= now) {
+            _fiber_unsleep(scheduler, fiber);
+            fiber->timed_out = true;
+            _fiber_push_ready(scheduler, fiber);
+        } else {
+            next = MIN(next, fiber->deadline);
+        }
+        fiber = following;
+    }
+    scheduler->next_deadline = next;
+}
+
+// Returns a finished fiber's stack to the free list, or to the OS if the list
+// is full.
+internal void _fiber_release(FiberScheduler* scheduler, Fiber* fiber)
+{
+#if OS_WINDOWS
+    DeleteFiber(fiber->registers.handle);
+#endif
+    if (scheduler->free_count < scheduler->max_free) {
+        // Anything the fiber left in its scratch arenas is garbage now.
+        for (usize i = 0; i < ARENA_SCRATCH_COUNT; ++i) {
+            if (fiber->scratch[i].memory) {
+                arena_reset(&fiber->scratch[i]);
+            }
+        }
+        fiber->next            = scheduler->free_stacks;
+        scheduler->free_stacks = fiber;
+        scheduler->free_count++;
+    } else {
+        _fiber_unmap(fiber);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+internal void _fiber_entry(void)
+{
+    Fiber*          fiber     = g_fiber_scheduler->current;
+    FiberScheduler* scheduler = fiber->scheduler;
+    fiber->func(fiber->context);
+
+    adaptive_mutex_lock(&scheduler->lock);
+    fiber->state = FIBER_DONE;
+    adaptive_mutex_unlock(&scheduler->lock);
+
+    _fiber_switch(&fiber->registers, &scheduler->registers);
+    ASSERT(false, "A finished fiber was resumed.");
+}
+
+void _fiber_scheduler_init(FiberScheduler*             scheduler,
+                           FiberSchedulerDefaultParams params)
+{
+    memset(scheduler, 0, sizeof(*scheduler));
+    adaptive_mutex_init(&scheduler->lock, .name = "fiber_scheduler");
+    scheduler->next_deadline = FIBER_FOREVER;
+    scheduler->stack_size    = params.stack_size ? params.stack_size
+                                                 : FIBER_DEFAULT_STACK_SIZE;
+    scheduler->max_free      = params.max_free_stacks
+                                   ? params.max_free_stacks
+                                   : FIBER_DEFAULT_FREE_STACKS;
+    scheduler->scratch_size  = params.scratch_size
+                                   ? params.scratch_size
+                                   : FIBER_DEFAULT_SCRATCH_SIZE;
+}
+
+void fiber_scheduler_done(FiberScheduler* scheduler)
+{
+    ASSERT(scheduler->live == 0, "Fiber scheduler destroyed with live fibers.");
+    while (scheduler->free_stacks) {
+        Fiber* fiber           = scheduler->free_stacks;
+        scheduler->free_stacks = fiber->next;
+        _fiber_unmap(fiber);
+    }
+    scheduler->free_count = 0;
+    adaptive_mutex_done(&scheduler->lock);
+}
+
+// Sleeps until a fiber is readied or the earliest deadline passes.  Called and
+// returns with the lock held.
+internal void _fiber_idle(FiberScheduler* scheduler)
+{
+    u32       signal   = atomic_load_u32(&scheduler->signal, MEMORY_ACQUIRE);
+    TimePoint deadline = scheduler->next_deadline;
+    scheduler->idle    = true;
+    adaptive_mutex_unlock(&scheduler->lock);
+
+    if (deadline == FIBER_FOREVER) {
+        futex_wait(&scheduler->signal, signal);
+    } else {
+        TimePoint now = time_now();
+        if (now < deadline) {
+            futex_wait_timeout(
+                &scheduler->signal, signal, time_elapsed(now, deadline));
+        }
+    }
+
+    adaptive_mutex_lock(&scheduler->lock);
+    scheduler->idle = false;
+}
+
+void fiber_scheduler_run(FiberScheduler* scheduler)
+{
+    ASSERT(!g_fiber_scheduler, "Fiber schedulers cannot be nested.");
+    g_fiber_scheduler = scheduler;
+
+#if OS_WINDOWS
+    bool converted = !IsThreadAFiber();
+    scheduler->registers.handle =
+        converted ? ConvertThreadToFiber(NULL) : GetCurrentFiber();
+#elif !FIBER_SWITCH_ASM
+    scheduler->registers.handle = &g_fiber_thread_context;
+#endif
+
+    adaptive_mutex_lock(&scheduler->lock);
+    ASSERT(!scheduler->running, "Fiber scheduler is already running.");
+    scheduler->running = true;
+
+    while (scheduler->live > 0) {
+        if (scheduler->next_deadline != FIBER_FOREVER) {
+            TimePoint now = time_now();
+            if (now >= scheduler->next_deadline) {
+                _fiber_wake_expired(scheduler, now);
+            }
+        }
+
+        Fiber* fiber = _fiber_pop_ready(scheduler);
+        if (!fiber) {
+            _fiber_idle(scheduler);
+            continue;
+        }
+
+        fiber->state       = FIBER_RUNNING;
+        scheduler->current = fiber;
+        adaptive_mutex_unlock(&scheduler->lock);
+
+        // Every switch goes through here, so this is the one place the
+        // fiber's scratch arenas need swapping in and out.
+        _scratch_use(fiber->scratch, scheduler->scratch_size);
+        _fiber_switch(&scheduler->registers, &fiber->registers);
+        _scratch_use(NULL, 0);
+
+        adaptive_mutex_lock(&scheduler->lock);
+        scheduler->current = NULL;
+        if (fiber->state == FIBER_DONE) {
+            scheduler->live--;
+            _fiber_release(scheduler, fiber);
+        }
+    }
+
+    scheduler->running = false;
+    adaptive_mutex_unlock(&scheduler->lock);
+
+#if OS_WINDOWS
+    if (converted) {
+        ConvertFiberToThread();
+    }
+#endif
+    g_fiber_scheduler = NULL;
+}
+
+//------------------------------------------------------------------------------
+
+Fiber* fiber_spawn(FiberScheduler* scheduler, FiberFunc func, void* context)
+{
+    adaptive_mutex_lock(&scheduler->lock);
+    Fiber* fiber = scheduler->free_stacks;
+    if (fiber) {
+        scheduler->free_stacks = fiber->next;
+        scheduler->free_count--;
+    }
+    adaptive_mutex_unlock(&scheduler->lock);
+
+    if (!fiber) {
+        fiber = _fiber_map(scheduler);
+    }
+    fiber->scheduler = scheduler;
+    fiber->func      = func;
+    fiber->context   = context;
+    fiber->notified  = false;
+    fiber->timed_out = false;
+    fiber->deadline  = FIBER_FOREVER;
+    _fiber_prepare(scheduler, fiber);
+
+    adaptive_mutex_lock(&scheduler->lock);
+    scheduler->live++;
+    _fiber_push_ready(scheduler, fiber);
+    bool wake = _fiber_signal(scheduler);
+    adaptive_mutex_unlock(&scheduler->lock);
+
+    if (wake) {
+        futex_wake_one(&scheduler->signal);
+    }
+    return fiber;
+}
+
+Fiber* fiber_current(void)
+{
+    return g_fiber_scheduler ? g_fiber_scheduler->current : NULL;
+}
+
+void fiber_yield(void)
+{
+    Fiber* fiber = fiber_current();
+    ASSERT(fiber, "fiber_yield() called outside a fiber.");
+    FiberScheduler* scheduler = fiber->scheduler;
+
+    adaptive_mutex_lock(&scheduler->lock);
+    _fiber_push_ready(scheduler, fiber);
+    adaptive_mutex_unlock(&scheduler->lock);
+
+    // The fiber is already queued, but only this thread runs the queue.
+    _fiber_switch(&fiber->registers, &scheduler->registers);
+}
+
+bool fiber_park_until(TimePoint deadline)
+{
+    Fiber* fiber = fiber_current();
+    ASSERT(fiber, "fiber_park() called outside a fiber.");
+    FiberScheduler* scheduler = fiber->scheduler;
+
+    adaptive_mutex_lock(&scheduler->lock);
+    if (fiber->notified) {
+        fiber->notified = false;
+        adaptive_mutex_unlock(&scheduler->lock);
+        return true;
+    }
+    if (deadline != FIBER_FOREVER && time_now() >= deadline) {
+        adaptive_mutex_unlock(&scheduler->lock);
+        return false;
+    }
+
+    fiber->state     = FIBER_PARKED;
+    fiber->timed_out = false;
+    fiber->deadline  = deadline;
+    if (deadline != FIBER_FOREVER) {
+        _fiber_sleep(scheduler, fiber);
+    }
+    adaptive_mutex_unlock(&scheduler->lock);
+
+    _fiber_switch(&fiber->registers, &scheduler->registers);
+    return !fiber->timed_out;
+}
+
+void fiber_park(void) { fiber_park_until(FIBER_FOREVER); }
+
+void fiber_unpark(Fiber* fiber)
+{
+    FiberScheduler* scheduler = fiber->scheduler;
+    bool            wake      = false;
+
+    adaptive_mutex_lock(&scheduler->lock);
+    if (fiber->state == FIBER_PARKED) {
+        if (fiber->deadline != FIBER_FOREVER) {
+            _fiber_unsleep(scheduler, fiber);
+        }
+        _fiber_push_ready(scheduler, fiber);
+        wake = _fiber_signal(scheduler);
+    } else {
+        fiber->notified = true;
+    }
+    adaptive_mutex_unlock(&scheduler->lock);
+
+    if (wake) {
+        futex_wake_one(&scheduler->signal);
+    }
+}
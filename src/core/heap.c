@@ -0,0 +1,424 @@
+//------------------------------------------------------------------------------
+// TLSF heap implementation
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+
+#include <core/core.h>
+
+//------------------------------------------------------------------------------
+// Blocks
+//
+// Each block starts with the size of its payload.  The word before the size
+// holds a pointer to the previous physical block, but it overlaps the last word
+// of that block's payload and is only valid while the previous block is free.
+// Free blocks keep their free list links at the start of the payload.  The two
+// low bits of the size are flags since sizes are multiples of HEAP_ALIGNMENT.
+//
+//      [prev_phys][size|flags][payload ...........][prev_phys][size|flags]...
+//                 ^ block + 8 ^ payload                       ^ next block + 8
+//------------------------------------------------------------------------------
+
+typedef struct HeapBlock {
+    struct HeapBlock* prev_phys; // Previous block (only valid if it is free)
+    usize             size;      // Payload size and flags
+    struct HeapBlock* next_free; // Next block in the free list
+    struct HeapBlock* prev_free; // Previous block in the free list
+} HeapBlock;
+
+#define HEAP_BLOCK_FREE 1ull
+#define HEAP_BLOCK_PREV_FREE 2ull
+#define HEAP_BLOCK_FLAGS (HEAP_BLOCK_FREE | HEAP_BLOCK_PREV_FREE)
+
+#define HEAP_BLOCK_OVERHEAD sizeof(usize)
+#define HEAP_BLOCK_MIN (sizeof(HeapBlock) - sizeof(HeapBlock*))
+#define HEAP_BLOCK_MAX ((1ull << HEAP_FL_MAX) - 1)
+#define HEAP_SMALL_SIZE (1ull << HEAP_FL_SHIFT)
+
+internal usize _heap_block_size(HeapBlock* block)
+{
+    return block->size & ~HEAP_BLOCK_FLAGS;
+}
+
+internal void _heap_block_set_size(HeapBlock* block, usize size)
+{
+    block->size = size | (block->size & HEAP_BLOCK_FLAGS);
+}
+
+internal bool _heap_block_is_free(HeapBlock* block)
+{
+    return (block->size & HEAP_BLOCK_FREE) != 0;
+}
+
+internal bool _heap_block_is_prev_free(HeapBlock* block)
+{
+    return (block->size & HEAP_BLOCK_PREV_FREE) != 0;
+}
+
+internal void _heap_block_set_flag(HeapBlock* block, usize flag, bool set)
+{
+    block->size = set ? block->size | flag : block->size & ~flag;
+}
+
+internal void* _heap_block_payload(HeapBlock* block)
+{
+    return (u8*)block + offsetof(HeapBlock, next_free);
+}
+
+internal HeapBlock* _heap_block_from_payload(void* ptr)
+{
+    return (HeapBlock*)((u8*)ptr - offsetof(HeapBlock, next_free));
+}
+
+internal HeapBlock* _heap_block_next(HeapBlock* block)
+{
+    return (HeapBlock*)((u8*)_heap_block_payload(block) +
+                        _heap_block_size(block) - HEAP_BLOCK_OVERHEAD);
+}
+
+// Points the next physical block back at `block` and returns it.
+internal HeapBlock* _heap_block_link_next(HeapBlock* block)
+{
+    HeapBlock* next = _heap_block_next(block);
+    next->prev_phys = block;
+    return next;
+}
+
+internal void _heap_block_mark_free(HeapBlock* block)
+{
+    HeapBlock* next = _heap_block_link_next(block);
+    _heap_block_set_flag(next, HEAP_BLOCK_PREV_FREE, true);
+    _heap_block_set_flag(block, HEAP_BLOCK_FREE, true);
+}
+
+internal void _heap_block_mark_used(HeapBlock* block)
+{
+    HeapBlock* next = _heap_block_next(block);
+    _heap_block_set_flag(next, HEAP_BLOCK_PREV_FREE, false);
+    _heap_block_set_flag(block, HEAP_BLOCK_FREE, false);
+}
+
+//------------------------------------------------------------------------------
+// Bin mapping
+//------------------------------------------------------------------------------
+
+internal u32 _heap_ffs(u64 bits)
+{
+#if COMPILER_MSVC
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (u32)index;
+#elif COMPILER_GCC || COMPILER_CLANG
+    return (u32)__builtin_ctzll(bits);
+#else
+#    error "Unsupported compiler for bit scans."
+#endif
+}
+
+internal u32 _heap_fls(u64 bits)
+{
+#if COMPILER_MSVC
+    unsigned long index;
+    _BitScanReverse64(&index, bits);
+    return (u32)index;
+#elif COMPILER_GCC || COMPILER_CLANG
+    return 63u - (u32)__builtin_clzll(bits);
+#else
+#    error "Unsupported compiler for bit scans."
+#endif
+}
+
+// Small sizes share the first level and are split linearly; larger sizes use
+// their top bit for the first level and the next HEAP_SL_LOG2 bits for the
+// second.
+internal void _heap_mapping(usize size, u32* fl, u32* sl)
+{
+    if (size < HEAP_SMALL_SIZE) {
+        *fl = 0;
+        *sl = (u32)(size / (HEAP_SMALL_SIZE / HEAP_SL_COUNT));
+    } else {
+        u32 top = _heap_fls(size);
+        *sl     = (u32)(size >> (top - HEAP_SL_LOG2)) ^ HEAP_SL_COUNT;
+        *fl     = top - (HEAP_FL_SHIFT - 1);
+    }
+}
+
+// Rounds `size` up to the start of the next bin so that any block in the bin
+// found by the search is large enough.
+internal usize _heap_round_up(usize size)
+{
+    if (size >= HEAP_SMALL_SIZE) {
+        usize round = (1ull << (_heap_fls(size) - HEAP_SL_LOG2)) - 1;
+        size += round;
+        size &= ~round;
+    }
+    return size;
+}
+
+internal HeapBlock* _heap_find_suitable(Heap* heap, u32* fl, u32* sl)
+{
+    u32 sl_map = heap->sl_bitmap[*fl] & (~0u << *sl);
+    if (!sl_map) {
+        u64 fl_map = heap->fl_bitmap & (~0ull << (*fl + 1));
+        if (!fl_map) {
+            return NULL;
+        }
+        *fl    = _heap_ffs(fl_map);
+        sl_map = heap->sl_bitmap[*fl];
+    }
+    *sl = _heap_ffs(sl_map);
+    return heap->free[*fl][*sl];
+}
+
+//------------------------------------------------------------------------------
+// Free lists
+//------------------------------------------------------------------------------
+
+internal void _heap_insert(Heap* heap, HeapBlock* block)
+{
+    u32 fl, sl;
+    _heap_mapping(_heap_block_size(block), &fl, &sl);
+
+    HeapBlock* head  = heap->free[fl][sl];
+    block->next_free = head;
+    block->prev_free = NULL;
+    if (head) {
+        head->prev_free = block;
+    }
+    heap->free[fl][sl] = block;
+    heap->fl_bitmap |= 1ull << fl;
+    heap->sl_bitmap[fl] |= 1u << sl;
+}
+
+internal void _heap_remove(Heap* heap, HeapBlock* block)
+{
+    u32 fl, sl;
+    _heap_mapping(_heap_block_size(block), &fl, &sl);
+
+    if (block->next_free) {
+        block->next_free->prev_free = block->prev_free;
+    }
+    if (block->prev_free) {
+        block->prev_free->next_free = block->next_free;
+    } else {
+        heap->free[fl][sl] = block->next_free;
+        if (!block->next_free) {
+            heap->sl_bitmap[fl] &= ~(1u << sl);
+            if (!heap->sl_bitmap[fl]) {
+                heap->fl_bitmap &= ~(1ull << fl);
+            }
+        }
+    }
+}
+
+// Merges a free block that is not in a free list with any free neighbours and
+// returns the combined block.
+internal HeapBlock* _heap_merge(Heap* heap, HeapBlock* block)
+{
+    if (_heap_block_is_prev_free(block)) {
+        HeapBlock* prev = block->prev_phys;
+        _heap_remove(heap, prev);
+        _heap_block_set_size(prev,
+                             _heap_block_size(prev) + _heap_block_size(block) +
+                                 HEAP_BLOCK_OVERHEAD);
+        block = prev;
+        _heap_block_link_next(block);
+    }
+
+    HeapBlock* next = _heap_block_next(block);
+    if (_heap_block_is_free(next)) {
+        _heap_remove(heap, next);
+        _heap_block_set_size(block,
+                             _heap_block_size(block) + _heap_block_size(next) +
+                                 HEAP_BLOCK_OVERHEAD);
+        _heap_block_link_next(block);
+    }
+
+    return block;
+}
+
+// Splits the tail off a block that is larger than `size` and returns it to the
+// free lists.
+internal void _heap_trim(Heap* heap, HeapBlock* block, usize size)
+{
+    usize block_size = _heap_block_size(block);
+    if (block_size < size + sizeof(HeapBlock)) {
+        return;
+    }
+
+    HeapBlock* rest = (HeapBlock*)((u8*)_heap_block_payload(block) + size -
+                                   HEAP_BLOCK_OVERHEAD);
+    rest->size      = block_size - size - HEAP_BLOCK_OVERHEAD;
+    _heap_block_set_size(block, size);
+    _heap_block_link_next(block);
+    _heap_block_mark_free(rest);
+    _heap_insert(heap, _heap_merge(heap, rest));
+}
+
+//------------------------------------------------------------------------------
+// Growth
+//------------------------------------------------------------------------------
+
+// Extends the heap so that its last block holds at least `size` bytes.  The old
+// sentinel becomes a free block covering the new memory, merged with a free
+// block before it, and a new sentinel is placed at the end.  The block is
+// returned without being added to a free list.
+internal HeapBlock* _heap_grow(Heap* heap, usize size)
+{
+    // A free block before the sentinel is merged with the new memory, so only
+    // the shortfall needs to be added.
+    usize have = 0;
+    if (_heap_block_is_prev_free(heap->sentinel)) {
+        have = _heap_block_size(heap->sentinel->prev_phys) +
+               HEAP_BLOCK_OVERHEAD;
+    }
+
+    Arena* arena     = &heap->arena;
+    usize  needed    = size + HEAP_BLOCK_OVERHEAD - MIN(have, size);
+    usize  available = arena->reserved_size - arena->cursor;
+    needed           = MAX(needed, sizeof(HeapBlock));
+    if (needed > available) {
+        return NULL;
+    }
+
+    usize step = arena->alloc_granularity * arena->grow_rate;
+    usize grow = MIN(ALIGN_UP(needed, step), available);
+
+    // The arena is only used by the heap so the new memory directly follows
+    // the old sentinel.
+    arena_alloc(arena, grow);
+
+    HeapBlock* block = heap->sentinel;
+    _heap_block_set_size(block, grow - HEAP_BLOCK_OVERHEAD);
+    _heap_block_set_flag(block, HEAP_BLOCK_FREE, true);
+
+    HeapBlock* sentinel = _heap_block_link_next(block);
+    sentinel->size      = HEAP_BLOCK_PREV_FREE;
+    heap->sentinel      = sentinel;
+
+    return _heap_merge(heap, block);
+}
+
+//------------------------------------------------------------------------------
+// Heap lifetime
+//------------------------------------------------------------------------------
+
+void _heap_init(Heap* heap, HeapDefaultParams params)
+{
+    ASSERT(params.reserved_size <= HEAP_BLOCK_MAX,
+           "Heap reserved size must be below %llu bytes.",
+           HEAP_BLOCK_MAX + 1);
+
+    memset(heap, 0, sizeof(*heap));
+    arena_init(&heap->arena,
+               .reserved_size = params.reserved_size,
+               .grow_rate     = params.grow_rate,
+               .prefault      = params.prefault,
+               .pages         = params.pages,
+               .name          = params.name);
+
+    // The heap starts as a lone sentinel; growing turns it into a free block.
+    HeapBlock* sentinel =
+        arena_alloc(&heap->arena, offsetof(HeapBlock, next_free));
+    sentinel->size      = 0;
+    heap->sentinel      = sentinel;
+}
+
+void heap_done(Heap* heap)
+{
+    arena_done(&heap->arena);
+    memset(heap, 0, sizeof(*heap));
+}
+
+//------------------------------------------------------------------------------
+// Allocation
+//------------------------------------------------------------------------------
+
+void* heap_alloc(Heap* heap, usize size)
+{
+    if (size == 0 || size > HEAP_BLOCK_MAX) {
+        return NULL;
+    }
+
+    size = MAX(ALIGN_UP(size, HEAP_ALIGNMENT), HEAP_BLOCK_MIN);
+
+    u32 fl, sl;
+    _heap_mapping(_heap_round_up(size), &fl, &sl);
+
+    HeapBlock* block = NULL;
+    if (fl < HEAP_FL_COUNT) {
+        block = _heap_find_suitable(heap, &fl, &sl);
+    }
+    if (block) {
+        _heap_remove(heap, block);
+    } else {
+        block = _heap_grow(heap, size);
+        if (!block) {
+            return NULL;
+        }
+    }
+
+    _heap_trim(heap, block, size);
+    _heap_block_mark_used(block);
+
+    heap->used += _heap_block_size(block);
+    heap->peak = MAX(heap->peak, heap->used);
+    heap->count++;
+
+    return _heap_block_payload(block);
+}
+
+void heap_free(Heap* heap, void* ptr)
+{
+    if (!ptr) {
+        return;
+    }
+
+    HeapBlock* block = _heap_block_from_payload(ptr);
+    ASSERT(!_heap_block_is_free(block), "Heap block %p freed twice.", ptr);
+    ASSERT(heap->count > 0, "Heap free without a matching allocation.");
+
+    heap->used -= _heap_block_size(block);
+    heap->count--;
+
+    _heap_block_mark_free(block);
+    _heap_insert(heap, _heap_merge(heap, block));
+}
+
+usize heap_size(void* ptr)
+{
+    return _heap_block_size(_heap_block_from_payload(ptr));
+}
+
+//------------------------------------------------------------------------------
+// Statistics
+//------------------------------------------------------------------------------
+
+HeapStats heap_stats(Heap* heap)
+{
+    HeapStats stats = {
+        .used      = heap->used,
+        .peak      = heap->peak,
+        .count     = heap->count,
+        .committed = heap->arena.committed_size,
+        .reserved  = heap->arena.reserved_size,
+    };
+
+    HeapBlock* block = (HeapBlock*)heap->arena.memory;
+    while (block != heap->sentinel) {
+        if (_heap_block_is_free(block)) {
+            usize size         = _heap_block_size(block);
+            stats.free        += size;
+            stats.largest_free = MAX(stats.largest_free, size);
+            stats.free_blocks++;
+        }
+        block = _heap_block_next(block);
+    }
+
+    if (stats.free) {
+        stats.fragmentation =
+            1.0 - (f64)stats.largest_free / (f64)stats.free;
+    }
+
+    return stats;
+}
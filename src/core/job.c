@@ -0,0 +1,385 @@
+//------------------------------------------------------------------------------
+// Work-stealing job system
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+
+#include <core/core.h>
+
+#include <stdio.h>
+
+#define JOB_DEQUE_MASK (JOB_DEQUE_CAPACITY - 1)
+#define JOB_SPIN_COUNT 256 // Failed searches before an idle worker sleeps
+
+// Worker run by the calling thread, if it belongs to a job system.
+thread_local global_variable JobWorker* g_job_worker = NULL;
+
+//------------------------------------------------------------------------------
+
+internal bool _job_is_stopping(JobSystem* system)
+{
+    return atomic_load_bool(&system->stopping, MEMORY_ACQUIRE);
+}
+
+//------------------------------------------------------------------------------
+// Chase-Lev deque
+//
+// The owner pushes and pops at `bottom`; thieves take from `top`.  The only
+// contention is over the last job, which the owner and thieves race for with a
+// CAS on `top`.  The buffer does not grow: a full deque makes the owner run the
+// job inline instead.
+
+internal bool _job_deque_push(JobDeque* deque, Job* job)
+{
+    i64 bottom = atomic_load_i64(&deque->bottom, MEMORY_RELAXED);
+    i64 top    = atomic_load_i64(&deque->top, MEMORY_ACQUIRE);
+    if (bottom - top >= JOB_DEQUE_CAPACITY) {
+        return false;
+    }
+
+    Job** slot = &deque->jobs[bottom & JOB_DEQUE_MASK];
+    atomic_store_ptr((void**)slot, job, MEMORY_RELAXED);
+    atomic_store_i64(&deque->bottom, bottom + 1, MEMORY_RELEASE);
+    return true;
+}
+
+internal Job* _job_deque_pop(JobDeque* deque)
+{
+    i64 bottom = atomic_load_i64(&deque->bottom, MEMORY_RELAXED) - 1;
+    atomic_store_i64(&deque->bottom, bottom, MEMORY_RELAXED);
+    atomic_fence(MEMORY_SEQ_CST);
+    i64 top = atomic_load_i64(&deque->top, MEMORY_RELAXED);
+
+    if (top > bottom) {
+        atomic_store_i64(&deque->bottom, bottom + 1, MEMORY_RELAXED);
+        return NULL;
+    }
+
+    Job** slot = &deque->jobs[bottom & JOB_DEQUE_MASK];
+    Job*  job  = atomic_load_ptr((void**)slot, MEMORY_RELAXED);
+    if (top == bottom) {
+        // Last job: race any thieves for it.
+        if (!atomic_cas_i64(&deque->top, &top, top + 1, MEMORY_SEQ_CST)) {
+            job = NULL;
+        }
+        atomic_store_i64(&deque->bottom, bottom + 1, MEMORY_RELAXED);
+    }
+    return job;
+}
+
+internal Job* _job_deque_steal(JobDeque* deque)
+{
+    i64 top = atomic_load_i64(&deque->top, MEMORY_ACQUIRE);
+    atomic_fence(MEMORY_SEQ_CST);
+    i64 bottom = atomic_load_i64(&deque->bottom, MEMORY_ACQUIRE);
+    if (top >= bottom) {
+        return NULL;
+    }
+
+    Job** slot = &deque->jobs[top & JOB_DEQUE_MASK];
+    Job*  job  = atomic_load_ptr((void**)slot, MEMORY_RELAXED);
+    bool  won  = atomic_cas_i64(&deque->top, &top, top + 1, MEMORY_SEQ_CST);
+    return won ? job : NULL;
+}
+
+internal bool _job_deque_is_empty(JobDeque* deque)
+{
+    return atomic_load_i64(&deque->top, MEMORY_ACQUIRE) >=
+           atomic_load_i64(&deque->bottom, MEMORY_ACQUIRE);
+}
+
+//------------------------------------------------------------------------------
+// Scheduling
+
+internal JobWorker* _job_current_worker(JobSystem* system)
+{
+    JobWorker* worker = g_job_worker;
+    return worker && worker->system == system ? worker : NULL;
+}
+
+internal bool _job_has_work(JobSystem* system)
+{
+    if (atomic_load_usize(&system->queued, MEMORY_ACQUIRE)) {
+        return true;
+    }
+    for (usize i = 0; i < system->worker_count; ++i) {
+        if (!_job_deque_is_empty(&system->workers[i].deque)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+internal void _job_wake(JobSystem* system)
+{
+    // Pairs with the fence in _job_sleep(): either the sleeper sees the new
+    // job or we see the sleeper.
+    atomic_fence(MEMORY_SEQ_CST);
+    if (atomic_load_usize(&system->sleeping, MEMORY_ACQUIRE)) {
+        mutex_lock(&system->sleep_mutex);
+        condvar_signal(&system->wake);
+        mutex_unlock(&system->sleep_mutex);
+    }
+}
+
+internal void _job_sleep(JobSystem* system)
+{
+    mutex_lock(&system->sleep_mutex);
+    atomic_fetch_add_usize(&system->sleeping, 1, MEMORY_ACQ_REL);
+    atomic_fence(MEMORY_SEQ_CST);
+    if (!system->stopping && !_job_has_work(system)) {
+        condvar_wait(&system->wake, &system->sleep_mutex);
+    }
+    atomic_fetch_sub_usize(&system->sleeping, 1, MEMORY_ACQ_REL);
+    mutex_unlock(&system->sleep_mutex);
+}
+
+internal void _job_run(JobSystem* system, Job* job);
+
+internal void _job_schedule(JobSystem* system, Job* job)
+{
+    atomic_fetch_add_usize(&system->unfinished, 1, MEMORY_ACQ_REL);
+    JobWorker* worker = _job_current_worker(system);
+    if (worker) {
+        if (!_job_deque_push(&worker->deque, job)) {
+            _job_run(system, job);
+            return;
+        }
+    } else {
+        job->next = NULL;
+        mutex_lock(&system->queue_mutex);
+        if (system->queue_tail) {
+            system->queue_tail->next = job;
+        } else {
+            system->queue_head = job;
+        }
+        system->queue_tail = job;
+        atomic_fetch_add_usize(&system->queued, 1, MEMORY_ACQ_REL);
+        mutex_unlock(&system->queue_mutex);
+    }
+
+    _job_wake(system);
+}
+
+internal Job* _job_dequeue(JobSystem* system)
+{
+    if (!atomic_load_usize(&system->queued, MEMORY_ACQUIRE)) {
+        return NULL;
+    }
+
+    mutex_lock(&system->queue_mutex);
+    Job* job = system->queue_head;
+    if (job) {
+        system->queue_head = job->next;
+        if (!system->queue_head) {
+            system->queue_tail = NULL;
+        }
+        atomic_fetch_sub_usize(&system->queued, 1, MEMORY_ACQ_REL);
+    }
+    mutex_unlock(&system->queue_mutex);
+    return job;
+}
+
+// Finds a job to run: the worker's own newest job, then the shared queue, then
+// the oldest job of another worker, starting from a random victim.
+internal Job* _job_next(JobSystem* system, JobWorker* worker)
+{
+    Job* job = worker ? _job_deque_pop(&worker->deque) : NULL;
+    if (!job) {
+        job = _job_dequeue(system);
+    }
+    if (job) {
+        return job;
+    }
+
+    usize start = 0;
+    if (worker) {
+        worker->seed ^= worker->seed << 13;
+        worker->seed ^= worker->seed >> 7;
+        worker->seed ^= worker->seed << 17;
+        start = (usize)(worker->seed % system->worker_count);
+    }
+    for (usize i = 0; i < system->worker_count && !job; ++i) {
+        JobWorker* victim = &system->workers[(start + i) % system->worker_count];
+        if (victim != worker) {
+            job = _job_deque_steal(&victim->deque);
+        }
+    }
+    return job;
+}
+
+internal void _job_run(JobSystem* system, Job* job)
+{
+    job->func(job->context);
+
+    // The job may be freed as soon as its counter drops, so release the
+    // dependents first.
+    JobCounter* counter = job->counter;
+    for (u32 i = 0; i < job->dependent_count; ++i) {
+        Job* dependent = job->dependents[i];
+        usize pending =
+            atomic_fetch_sub_usize(&dependent->pending, 1, MEMORY_ACQ_REL);
+        if (pending == 1) {
+            _job_schedule(system, dependent);
+        }
+    }
+    if (counter) {
+        atomic_fetch_sub_usize(&counter->value, 1, MEMORY_ACQ_REL);
+    }
+    // Last, so that dependents are counted before this job stops being.
+    atomic_fetch_sub_usize(&system->unfinished, 1, MEMORY_ACQ_REL);
+}
+
+//------------------------------------------------------------------------------
+// Workers
+
+internal void _job_worker_main(void* context)
+{
+    JobWorker* worker = (JobWorker*)context;
+    JobSystem* system = worker->system;
+    g_job_worker      = worker;
+
+    u32 idle = 0;
+    while (!_job_is_stopping(system)) {
+        Job* job = _job_next(system, worker);
+        if (job) {
+            _job_run(system, job);
+            idle = 0;
+        } else if (++idle < JOB_SPIN_COUNT) {
+            CPU_RELAX();
+        } else {
+            _job_sleep(system);
+            idle = 0;
+        }
+    }
+
+    g_job_worker = NULL;
+}
+
+void _job_system_init(JobSystem* system, JobSystemDefaultParams params)
+{
+    if (params.worker_count == 0) {
+        params.worker_count = thread_cpu_count();
+    }
+    if (!params.name) {
+        params.name = "job";
+    }
+
+    memset(system, 0, sizeof(*system));
+    system->workers      = KORE_ARRAY_ALLOC(JobWorker, params.worker_count);
+    system->worker_count = params.worker_count;
+    mutex_init(&system->queue_mutex, .name = "job_queue");
+    mutex_init(&system->sleep_mutex, .name = "job_sleep");
+    condvar_init(&system->wake);
+
+    for (usize i = 0; i < system->worker_count; ++i) {
+        JobWorker* worker = &system->workers[i];
+        memset(worker, 0, sizeof(*worker));
+        worker->system     = system;
+        worker->deque.jobs = KORE_ARRAY_ALLOC(Job*, JOB_DEQUE_CAPACITY);
+        worker->seed       = (i + 1) * 0x9e3779b97f4a7c15ull;
+        worker->index      = i;
+    }
+
+    ASSERT(!g_job_worker, "This thread already belongs to a job system.");
+    g_job_worker = &system->workers[0];
+
+    for (usize i = 1; i < system->worker_count; ++i) {
+        char name[32];
+        snprintf(name, sizeof(name), "%s-%zu", params.name, i);
+        u32  cpu     = params.pin_workers ? THREAD_CPU(cpu_spread(i)) : 0;
+        bool created = thread_create(&system->workers[i].thread,
+                                     _job_worker_main,
+                                     &system->workers[i],
+                                     .stack_size = params.stack_size,
+                                     .name       = name,
+                                     .cpu        = cpu);
+        ASSERT(created, "Unable to create job worker %zu.", i);
+    }
+}
+
+void job_system_done(JobSystem* system)
+{
+    ASSERT(_job_current_worker(system) == &system->workers[0],
+           "A job system must be shut down by the thread that created it.");
+
+    // Run what is left, as job_wait() does, so that jobs submitted but never
+    // waited for still finish.  Jobs may submit more, so wait for the count
+    // of unfinished jobs rather than for the queues to look empty.
+    JobWorker* worker = &system->workers[0];
+    while (atomic_load_usize(&system->unfinished, MEMORY_ACQUIRE)) {
+        Job* job = _job_next(system, worker);
+        if (job) {
+            _job_run(system, job);
+        } else {
+            CPU_RELAX();
+        }
+    }
+
+    mutex_lock(&system->sleep_mutex);
+    atomic_store_bool(&system->stopping, true, MEMORY_RELEASE);
+    condvar_broadcast(&system->wake);
+    mutex_unlock(&system->sleep_mutex);
+
+    for (usize i = 1; i < system->worker_count; ++i) {
+        thread_join(&system->workers[i].thread);
+    }
+    g_job_worker = NULL;
+
+    ASSERT(system->queued == 0, "Jobs were submitted during shutdown.");
+    for (usize i = 0; i < system->worker_count; ++i) {
+        ASSERT(_job_deque_is_empty(&system->workers[i].deque),
+               "Jobs were submitted during shutdown.");
+        KORE_ARRAY_FREE(system->workers[i].deque.jobs);
+    }
+    KORE_ARRAY_FREE(system->workers);
+    condvar_done(&system->wake);
+    mutex_done(&system->sleep_mutex);
+    mutex_done(&system->queue_mutex);
+}
+
+//------------------------------------------------------------------------------
+// Jobs
+
+void job_init(Job* job, JobFunc func, void* context)
+{
+    job->func            = func;
+    job->context         = context;
+    job->pending         = 1;
+    job->counter         = NULL;
+    job->dependent_count = 0;
+    job->next            = NULL;
+}
+
+void job_depend(Job* job, Job* parent)
+{
+    ASSERT(parent->dependent_count < JOB_MAX_DEPENDENTS,
+           "A job can have at most %d dependents.",
+           JOB_MAX_DEPENDENTS);
+    parent->dependents[parent->dependent_count++] = job;
+    job->pending++;
+}
+
+void job_submit(JobSystem* system, Job* job, JobCounter* counter)
+{
+    job->counter = counter;
+    if (counter) {
+        atomic_fetch_add_usize(&counter->value, 1, MEMORY_ACQ_REL);
+    }
+    if (atomic_fetch_sub_usize(&job->pending, 1, MEMORY_ACQ_REL) == 1) {
+        _job_schedule(system, job);
+    }
+}
+
+void job_wait(JobSystem* system, JobCounter* counter)
+{
+    JobWorker* worker = _job_current_worker(system);
+    while (atomic_load_usize(&counter->value, MEMORY_ACQUIRE)) {
+        Job* job = _job_next(system, worker);
+        if (job) {
+            _job_run(system, job);
+        } else {
+            CPU_RELAX();
+        }
+    }
+}
@@ -6,7 +6,9 @@
 
 #include <core/core.h>
 
-extern Mutex g_kore_output_mutex;
+extern AdaptiveMutex g_kore_output_mutex;
+extern Mutex         g_kore_arena_registry_mutex;
+extern ThreadPool    g_kore_thread_pool;
 
 //------------------------------------------------------------------------------
 
@@ -15,7 +17,9 @@ int run(int argc, char** argv);
 #ifndef TEST
 int main(int argc, char** argv)
 {
-    mutex_init(&g_kore_output_mutex);
+    adaptive_mutex_init(&g_kore_output_mutex, .name = "output");
+    mutex_init(&g_kore_arena_registry_mutex, .name = "arena_registry");
+    thread_pool_init(&g_kore_thread_pool);
 
 #if OS_WINDOWS
     UINT old_cp = GetConsoleCP();
@@ -25,6 +29,8 @@ int main(int argc, char** argv)
 #endif // OS_WINDOWS
 
     int result = run(argc, argv);
+    thread_pool_done(&g_kore_thread_pool);
+    pr_flush();
 
 #if OS_WINDOWS
     SetConsoleCP(old_cp);
@@ -34,7 +40,8 @@ int main(int argc, char** argv)
 #if CONFIG_DEBUG
     mem_print_leaks();
 #endif // CONFIG_DEBUG
-    mutex_done(&g_kore_output_mutex);
+    mutex_done(&g_kore_arena_registry_mutex);
+    adaptive_mutex_done(&g_kore_output_mutex);
     return result;
 }
 #endif
@@ -46,5 +53,6 @@ void kill(cstr format, ...)
     eprv(format, args);
     va_end(args);
     epr("\n");
+    pr_flush();
     abort();
 }
@@ -6,20 +6,598 @@
 
 #include <core/core.h>
 
+#if OS_POSIX
+#    include <sched.h>
+#endif // OS_POSIX
+
+#if OS_LINUX
+#    include <linux/futex.h>
+#    include <sys/syscall.h>
+#endif // OS_LINUX
+
+#if OS_WINDOWS && COMPILER_MSVC
+#    pragma comment(lib, "synchronization.lib")
+#endif
+
 //------------------------------------------------------------------------------
+// Lock profiling
+
+global_variable bool        g_lock_profiling = false;
+global_variable Spinlock    g_lock_profile_lock;
+global_variable LockProfile g_lock_profiles[LOCK_PROFILE_MAX];
+global_variable usize       g_lock_profile_count = 0;
+
+void lock_profile_enable(bool enabled)
+{
+    atomic_store_bool(&g_lock_profiling, enabled, MEMORY_RELEASE);
+}
+
+bool lock_profile_enabled(void)
+{
+    return atomic_load_bool(&g_lock_profiling, MEMORY_RELAXED);
+}
+
+// Returns the profile a lock records into, or NULL when it is not being
+// profiled.  The lookup by name happens once per lock and is cached.
+internal LockProfile* _lock_profile(cstr name, LockProfile** cache)
+{
+    if (!name || !atomic_load_bool(&g_lock_profiling, MEMORY_RELAXED)) {
+        return NULL;
+    }
+    LockProfile* profile = atomic_load_ptr((void**)cache, MEMORY_ACQUIRE);
+    if (profile) {
+        return profile;
+    }
+
+    spinlock_lock(&g_lock_profile_lock);
+    for (usize i = 0; i < g_lock_profile_count && !profile; ++i) {
+        if (strcmp(g_lock_profiles[i].name, name) == 0) {
+            profile = &g_lock_profiles[i];
+        }
+    }
+    if (!profile) {
+        // Names past the table's capacity share its last row.
+        if (g_lock_profile_count < LOCK_PROFILE_MAX) {
+            profile       = &g_lock_profiles[g_lock_profile_count++];
+            profile->name = g_lock_profile_count < LOCK_PROFILE_MAX ? name
+                                                                    : "(other)";
+        } else {
+            profile = &g_lock_profiles[LOCK_PROFILE_MAX - 1];
+        }
+    }
+    spinlock_unlock(&g_lock_profile_lock);
+
+    atomic_store_ptr((void**)cache, profile, MEMORY_RELEASE);
+    return profile;
+}
+
+internal void _lock_profile_max(u64* max, u64 value)
+{
+    u64 current = atomic_load_u64(max, MEMORY_RELAXED);
+    while (value > current &&
+           !atomic_cas_u64(max, &current, value, MEMORY_RELAXED)) {
+    }
+}
+
+// Profiles are shared between locks of the same name, so counters are atomic.
+// `locked_at` belongs to the lock and is only touched by its holder.
+internal void _lock_profile_acquired(LockProfile* profile,
+                                     u64*         locked_at,
+                                     TimePoint    start,
+                                     bool         contended)
+{
+    TimePoint now = start;
+    atomic_fetch_add_u64(&profile->acquisitions, 1, MEMORY_RELAXED);
+    if (contended) {
+        now               = time_now();
+        TimeDuration wait = time_elapsed(start, now);
+        atomic_fetch_add_u64(&profile->contended, 1, MEMORY_RELAXED);
+        atomic_fetch_add_u64(&profile->wait_time, wait, MEMORY_RELAXED);
+        _lock_profile_max(&profile->max_wait, wait);
+    }
+    *locked_at = now;
+}
+
+internal void _lock_profile_released(LockProfile* profile, u64* locked_at)
+{
+    TimeDuration hold = time_elapsed(*locked_at, time_now());
+    *locked_at        = 0;
+    atomic_fetch_add_u64(&profile->hold_time, hold, MEMORY_RELAXED);
+    _lock_profile_max(&profile->max_hold, hold);
+}
+
+void lock_profile_reset(void)
+{
+    spinlock_lock(&g_lock_profile_lock);
+    for (usize i = 0; i < g_lock_profile_count; ++i) {
+        LockProfile* profile = &g_lock_profiles[i];
+        atomic_store_u64(&profile->acquisitions, 0, MEMORY_RELAXED);
+        atomic_store_u64(&profile->contended, 0, MEMORY_RELAXED);
+        atomic_store_u64(&profile->wait_time, 0, MEMORY_RELAXED);
+        atomic_store_u64(&profile->max_wait, 0, MEMORY_RELAXED);
+        atomic_store_u64(&profile->hold_time, 0, MEMORY_RELAXED);
+        atomic_store_u64(&profile->max_hold, 0, MEMORY_RELAXED);
+    }
+    spinlock_unlock(&g_lock_profile_lock);
+}
+
+internal u64 _lock_profile_load(u64* counter)
+{
+    return atomic_load_u64(counter, MEMORY_RELAXED);
+}
+
+internal bool _lock_profile_worse(LockProfile* a, LockProfile* b)
+{
+    if (a->wait_time != b->wait_time) {
+        return a->wait_time > b->wait_time;
+    }
+    if (a->contended != b->contended) {
+        return a->contended > b->contended;
+    }
+    return a->acquisitions > b->acquisitions;
+}
+
+usize lock_profile_snapshot(LockProfile* profiles, usize max)
+{
+    LockProfile all[LOCK_PROFILE_MAX];
+    spinlock_lock(&g_lock_profile_lock);
+    usize count = g_lock_profile_count;
+    for (usize i = 0; i < count; ++i) {
+        LockProfile* profile = &g_lock_profiles[i];
+        LockProfile* copy    = &all[i];
+        copy->name           = profile->name;
+        copy->acquisitions   = _lock_profile_load(&profile->acquisitions);
+        copy->contended      = _lock_profile_load(&profile->contended);
+        copy->wait_time      = _lock_profile_load(&profile->wait_time);
+        copy->max_wait       = _lock_profile_load(&profile->max_wait);
+        copy->hold_time      = _lock_profile_load(&profile->hold_time);
+        copy->max_hold       = _lock_profile_load(&profile->max_hold);
+    }
+    spinlock_unlock(&g_lock_profile_lock);
+
+    // Insertion sort: the table is small and nearly sorted between calls.
+    for (usize i = 1; i < count; ++i) {
+        LockProfile profile = all[i];
+        usize       j       = i;
+        while (j > 0 && _lock_profile_worse(&profile, &all[j - 1])) {
+            all[j] = all[j - 1];
+            --j;
+        }
+        all[j] = profile;
+    }
+
+    count = MIN(count, max);
+    memcpy(profiles, all, count * sizeof(LockProfile));
+    return count;
+}
+
+void lock_profile_print(usize max)
+{
+    LockProfile profiles[LOCK_PROFILE_MAX];
+    usize count = lock_profile_snapshot(profiles, MIN(max, LOCK_PROFILE_MAX));
+
+    prn(ANSI_BOLD "%-20s %12s %12s %7s %12s %12s %12s %12s" ANSI_RESET,
+        "Lock",
+        "Acquired",
+        "Contended",
+        "Cont %",
+        "Wait (us)",
+        "Max wait",
+        "Hold (us)",
+        "Max hold");
+    for (usize i = 0; i < count; ++i) {
+        LockProfile* profile = &profiles[i];
+        f64          percent = 0.0;
+        if (profile->acquisitions) {
+            percent = 100.0 * (f64)profile->contended /
+                      (f64)profile->acquisitions;
+        }
+        prn("%-20s %12llu %12llu %7.1f %12llu %12llu %12llu %12llu",
+            profile->name,
+            (unsigned long long)profile->acquisitions,
+            (unsigned long long)profile->contended,
+            percent,
+            (unsigned long long)time_duration_to_us(profile->wait_time),
+            (unsigned long long)time_duration_to_us(profile->max_wait),
+            (unsigned long long)time_duration_to_us(profile->hold_time),
+            (unsigned long long)time_duration_to_us(profile->max_hold));
+    }
+}
+
+//------------------------------------------------------------------------------
+// Mutex
 
 #if OS_WINDOWS
 
-void mutex_init(Mutex* mutex) { InitializeCriticalSection(mutex); }
-void mutex_done(Mutex* mutex) { DeleteCriticalSection(mutex); }
-void mutex_lock(Mutex* mutex) { EnterCriticalSection(mutex); }
-void mutex_unlock(Mutex* mutex) { LeaveCriticalSection(mutex); }
+internal void _mutex_native_lock(Mutex* mutex)
+{
+    EnterCriticalSection(&mutex->handle);
+}
+
+internal bool _mutex_native_try_lock(Mutex* mutex)
+{
+    return TryEnterCriticalSection(&mutex->handle) != 0;
+}
+
+internal void _mutex_native_unlock(Mutex* mutex)
+{
+    LeaveCriticalSection(&mutex->handle);
+}
+
+void _mutex_init(Mutex* mutex, MutexDefaultParams params)
+{
+    InitializeCriticalSection(&mutex->handle);
+    mutex->name      = params.name;
+    mutex->profile   = NULL;
+    mutex->locked_at = 0;
+}
+
+void mutex_done(Mutex* mutex) { DeleteCriticalSection(&mutex->handle); }
+
+void condvar_init(CondVar* condvar) { InitializeConditionVariable(condvar); }
+void condvar_done(CondVar* condvar) { UNUSED(condvar); }
+void condvar_signal(CondVar* condvar) { WakeConditionVariable(condvar); }
+void condvar_broadcast(CondVar* condvar) { WakeAllConditionVariable(condvar); }
+
+internal void _condvar_native_wait(CondVar* condvar, Mutex* mutex)
+{
+    SleepConditionVariableCS(condvar, &mutex->handle, INFINITE);
+}
 
 #else // OS_POSIX
 
-void mutex_init(Mutex* mutex) { pthread_mutex_init(mutex, NULL); }
-void mutex_done(Mutex* mutex) { pthread_mutex_destroy(mutex); }
-void mutex_lock(Mutex* mutex) { pthread_mutex_lock(mutex); }
-void mutex_unlock(Mutex* mutex) { pthread_mutex_unlock(mutex); }
+internal void _mutex_native_lock(Mutex* mutex)
+{
+    pthread_mutex_lock(&mutex->handle);
+}
+
+internal bool _mutex_native_try_lock(Mutex* mutex)
+{
+    return pthread_mutex_trylock(&mutex->handle) == 0;
+}
+
+internal void _mutex_native_unlock(Mutex* mutex)
+{
+    pthread_mutex_unlock(&mutex->handle);
+}
+
+void _mutex_init(Mutex* mutex, MutexDefaultParams params)
+{
+    pthread_mutex_init(&mutex->handle, NULL);
+    mutex->name      = params.name;
+    mutex->profile   = NULL;
+    mutex->locked_at = 0;
+}
+
+void mutex_done(Mutex* mutex) { pthread_mutex_destroy(&mutex->handle); }
+
+void condvar_init(CondVar* condvar) { pthread_cond_init(condvar, NULL); }
+void condvar_done(CondVar* condvar) { pthread_cond_destroy(condvar); }
+void condvar_signal(CondVar* condvar) { pthread_cond_signal(condvar); }
+void condvar_broadcast(CondVar* condvar) { pthread_cond_broadcast(condvar); }
+
+internal void _condvar_native_wait(CondVar* condvar, Mutex* mutex)
+{
+    pthread_cond_wait(condvar, &mutex->handle);
+}
+
+#endif // OS_WINDOWS
+
+void mutex_lock(Mutex* mutex)
+{
+    LockProfile* profile = _lock_profile(mutex->name, &mutex->profile);
+    if (!profile) {
+        _mutex_native_lock(mutex);
+        return;
+    }
+
+    TimePoint start     = time_now();
+    bool      contended = !_mutex_native_try_lock(mutex);
+    if (contended) {
+        _mutex_native_lock(mutex);
+    }
+    _lock_profile_acquired(profile, &mutex->locked_at, start, contended);
+}
+
+void mutex_unlock(Mutex* mutex)
+{
+    if (mutex->locked_at) {
+        _lock_profile_released(mutex->profile, &mutex->locked_at);
+    }
+    _mutex_native_unlock(mutex);
+}
+
+// Time spent waiting on the condition is not time holding the mutex.
+void condvar_wait(CondVar* condvar, Mutex* mutex)
+{
+    bool profiled = mutex->locked_at != 0;
+    if (profiled) {
+        _lock_profile_released(mutex->profile, &mutex->locked_at);
+    }
+    _condvar_native_wait(condvar, mutex);
+    if (profiled) {
+        mutex->locked_at = time_now();
+    }
+}
+
+//------------------------------------------------------------------------------
+// Futex
+
+#if OS_WINDOWS
+
+void futex_wait(u32* address, u32 expected)
+{
+    WaitOnAddress(address, &expected, sizeof(u32), INFINITE);
+}
+
+void futex_wait_timeout(u32* address, u32 expected, u64 timeout)
+{
+    DWORD ms = (DWORD)MIN(time_duration_to_ms(timeout), INFINITE - 1);
+    WaitOnAddress(address, &expected, sizeof(u32), ms);
+}
 
+void futex_wake_one(u32* address) { WakeByAddressSingle(address); }
+void futex_wake_all(u32* address) { WakeByAddressAll(address); }
+
+#elif OS_LINUX
+
+void futex_wait(u32* address, u32 expected)
+{
+    syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+void futex_wait_timeout(u32* address, u32 expected, u64 timeout)
+{
+    u64             ns = time_duration_to_ns(timeout);
+    struct timespec ts = {
+        .tv_sec  = (time_t)(ns / 1000000000ull),
+        .tv_nsec = (long)(ns % 1000000000ull),
+    };
+    syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, &ts, NULL, 0);
+}
+
+void futex_wake_one(u32* address)
+{
+    syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+void futex_wake_all(u32* address)
+{
+    syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, INT32_MAX, NULL, NULL, 0);
+}
+
+#elif OS_POSIX
+
+void futex_wait(u32* address, u32 expected)
+{
+    UNUSED(address);
+    UNUSED(expected);
+    sched_yield();
+}
+
+void futex_wait_timeout(u32* address, u32 expected, u64 timeout)
+{
+    UNUSED(address);
+    UNUSED(expected);
+    UNUSED(timeout);
+    sched_yield();
+}
+
+void futex_wake_one(u32* address) { UNUSED(address); }
+void futex_wake_all(u32* address) { UNUSED(address); }
+
+#else
+#    error "Futex not implemented for this OS."
 #endif // OS_WINDOWS
+
+//------------------------------------------------------------------------------
+// Lock word helpers
+
+// Lock words are compared against constants, so `expected` is taken by value.
+internal bool _lock_cas(u32* value, u32 expected, u32 desired)
+{
+    return atomic_cas_u32(value, &expected, desired, MEMORY_SEQ_CST);
+}
+
+internal void _lock_yield(void)
+{
+#if OS_WINDOWS
+    SwitchToThread();
+#else
+    sched_yield();
+#endif // OS_WINDOWS
+}
+
+//------------------------------------------------------------------------------
+// Adaptive mutex
+
+void _adaptive_mutex_init(AdaptiveMutex*             mutex,
+                          AdaptiveMutexDefaultParams params)
+{
+    mutex->state     = 0;
+    mutex->spins     = 0;
+    mutex->name      = params.name;
+    mutex->profile   = NULL;
+    mutex->locked_at = 0;
+}
+
+void adaptive_mutex_done(AdaptiveMutex* mutex)
+{
+    ASSERT(mutex->state == 0, "Adaptive mutex destroyed while locked.");
+}
+
+void adaptive_mutex_lock(AdaptiveMutex* mutex)
+{
+    LockProfile* profile = _lock_profile(mutex->name, &mutex->profile);
+    TimePoint    start   = profile ? time_now() : 0;
+    if (_lock_cas(&mutex->state, 0, 1)) {
+        if (profile) {
+            _lock_profile_acquired(profile, &mutex->locked_at, start, false);
+        }
+        return;
+    }
+
+    // Spin for up to twice as long as recent acquisitions needed, and move the
+    // estimate an eighth of the way towards this attempt.  Only the holder
+    // updates the estimate, so it needs no read-modify-write.
+    u32  spins    = atomic_load_u32(&mutex->spins, MEMORY_ACQUIRE);
+    u32  limit    = MIN(spins * 2 + 10, ADAPTIVE_MUTEX_MAX_SPINS);
+    u32  count    = 0;
+    bool acquired = false;
+    while (count < limit && !acquired) {
+        CPU_RELAX();
+        ++count;
+        acquired = atomic_load_u32(&mutex->state, MEMORY_ACQUIRE) == 0 &&
+                   _lock_cas(&mutex->state, 0, 1);
+    }
+
+    if (!acquired) {
+        // Mark the lock as having sleepers so that unlock wakes us.
+        while (atomic_exchange_u32(&mutex->state, 2, MEMORY_SEQ_CST) != 0) {
+            futex_wait(&mutex->state, 2);
+        }
+    }
+
+    i32 delta = ((i32)count - (i32)spins) / 8;
+    atomic_store_u32(&mutex->spins, (u32)((i32)spins + delta), MEMORY_SEQ_CST);
+
+    if (profile) {
+        _lock_profile_acquired(profile, &mutex->locked_at, start, true);
+    }
+}
+
+void adaptive_mutex_unlock(AdaptiveMutex* mutex)
+{
+    if (mutex->locked_at) {
+        _lock_profile_released(mutex->profile, &mutex->locked_at);
+    }
+    if (atomic_exchange_u32(&mutex->state, 0, MEMORY_SEQ_CST) == 2) {
+        futex_wake_one(&mutex->state);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Ticket spinlock
+
+#define SPINLOCK_YIELD_ROUNDS 64
+
+void spinlock_init(Spinlock* lock)
+{
+    lock->next    = 0;
+    lock->serving = 0;
+}
+
+void spinlock_done(Spinlock* lock)
+{
+    ASSERT(lock->next == lock->serving, "Spinlock destroyed while locked.");
+}
+
+void spinlock_lock(Spinlock* lock)
+{
+    u32 ticket = atomic_fetch_add_u32(&lock->next, 1, MEMORY_SEQ_CST);
+    for (u32 rounds = 1;; ++rounds) {
+        u32 serving = atomic_load_u32(&lock->serving, MEMORY_ACQUIRE);
+        if (serving == ticket) {
+            return;
+        }
+
+        // Back off in proportion to the number of threads ahead of us.  If the
+        // line is not moving the holder has probably been preempted, so give
+        // up the CPU rather than burn the rest of our time slice.
+        for (u32 i = ticket - serving; i > 0; --i) {
+            CPU_RELAX();
+        }
+        if (rounds % SPINLOCK_YIELD_ROUNDS == 0) {
+            _lock_yield();
+        }
+    }
+}
+
+void spinlock_unlock(Spinlock* lock)
+{
+    atomic_store_u32(&lock->serving, lock->serving + 1, MEMORY_SEQ_CST);
+}
+
+//------------------------------------------------------------------------------
+// Reader-writer lock
+
+#define RWLOCK_SPINS 100
+
+// Waits for `state` to change from `observed`, spinning briefly first.
+internal void _rwlock_wait(RwLock* lock, u32 observed)
+{
+    for (u32 i = 0; i < RWLOCK_SPINS; ++i) {
+        CPU_RELAX();
+        if (atomic_load_u32(&lock->state, MEMORY_ACQUIRE) != observed) {
+            return;
+        }
+    }
+
+    atomic_fetch_add_u32(&lock->sleepers, 1, MEMORY_SEQ_CST);
+    futex_wait(&lock->state, observed);
+    atomic_fetch_sub_u32(&lock->sleepers, 1, MEMORY_SEQ_CST);
+}
+
+// Sequentially consistent like the state change before it and the increment
+// in _rwlock_wait(), so either the waiter sees the new state or we see the
+// waiter.
+internal void _rwlock_wake(RwLock* lock)
+{
+    if (atomic_load_u32(&lock->sleepers, MEMORY_SEQ_CST)) {
+        futex_wake_all(&lock->state);
+    }
+}
+
+void rwlock_init(RwLock* lock)
+{
+    lock->state    = 0;
+    lock->sleepers = 0;
+}
+
+void rwlock_done(RwLock* lock)
+{
+    ASSERT(lock->state == 0, "Reader-writer lock destroyed while locked.");
+}
+
+void rwlock_read_lock(RwLock* lock)
+{
+    for (;;) {
+        u32 state = atomic_load_u32(&lock->state, MEMORY_ACQUIRE);
+        if (!(state & RWLOCK_WRITER)) {
+            if (_lock_cas(&lock->state, state, state + 1)) {
+                return;
+            }
+        } else {
+            _rwlock_wait(lock, state);
+        }
+    }
+}
+
+void rwlock_read_unlock(RwLock* lock)
+{
+    // Only writers wait while readers hold the lock, so wake them once the
+    // last reader leaves.
+    if (atomic_fetch_sub_u32(&lock->state, 1, MEMORY_SEQ_CST) == 1) {
+        _rwlock_wake(lock);
+    }
+}
+
+void rwlock_write_lock(RwLock* lock)
+{
+    for (;;) {
+        u32 state = atomic_load_u32(&lock->state, MEMORY_ACQUIRE);
+        if (state == 0) {
+            if (_lock_cas(&lock->state, 0, RWLOCK_WRITER)) {
+                return;
+            }
+        } else {
+            _rwlock_wait(lock, state);
+        }
+    }
+}
+
+void rwlock_write_unlock(RwLock* lock)
+{
+    atomic_store_u32(&lock->state, 0, MEMORY_SEQ_CST);
+    _rwlock_wake(lock);
+}
@@ -8,7 +8,53 @@
 
 #include <stdio.h>
 
-Mutex g_kore_output_mutex;
+#if OS_POSIX
+#    include <errno.h>
+#    include <sys/uio.h>
+#endif // OS_POSIX
+
+// Named statically so that pr() shows up in lock profiles even in programs
+// that never run kore's main().
+AdaptiveMutex g_kore_output_mutex = {.name = "output"};
+
+typedef enum {
+    OUTPUT_STDOUT,
+    OUTPUT_STDERR,
+    OUTPUT_STREAM_COUNT,
+} OutputStream;
+
+typedef struct {
+    usize size;
+    char  data[OUTPUT_BUFFER_SIZE];
+} OutputBuffer;
+
+// A thread's buffers, linked into the list of threads that have printed so
+// that exit can write out threads that are still running.
+typedef struct OutputThread OutputThread;
+
+struct OutputThread {
+    OutputBuffer  buffers[OUTPUT_STREAM_COUNT];
+    OutputThread* prev;
+    OutputThread* next;
+    bool          linked;
+};
+
+thread_local global_variable OutputThread g_output_thread;
+
+// Guarded by g_kore_output_mutex.
+global_variable OutputThread* g_output_threads = NULL;
+global_variable bool          g_output_ready   = false;
+
+#if OS_POSIX
+global_variable pthread_key_t g_output_key;
+#elif OS_WINDOWS
+global_variable DWORD g_output_key;
+#endif
+
+global_variable u32 g_output_flush[OUTPUT_STREAM_COUNT] = {
+    OUTPUT_FLUSH_AUTO,
+    OUTPUT_FLUSH_LINES,
+};
 
 //------------------------------------------------------------------------------
 
@@ -34,59 +80,333 @@ internal cstr _format_output(cstr format, va_list args, usize* out_size)
 
 #if OS_POSIX
 
-internal void fprv(int fd, cstr format, va_list args)
+internal bool _output_is_terminal(OutputStream stream)
 {
-    usize size;
-    mutex_lock(&g_kore_output_mutex);
-    cstr output = _format_output(format, args, &size);
-    write(fd, output, size);
-    mutex_unlock(&g_kore_output_mutex);
+    return isatty(stream == OUTPUT_STDOUT ? STDOUT_FILENO : STDERR_FILENO);
 }
 
-void prv(cstr format, va_list args) { fprv(STDOUT_FILENO, format, args); }
-void eprv(cstr format, va_list args) { fprv(STDERR_FILENO, format, args); }
+// Writes both pieces, in one system call unless the stream takes less.  The
+// caller holds the output lock.
+internal void _output_write_locked(OutputStream stream,
+                                   cstr         a,
+                                   usize        a_size,
+                                   cstr         b,
+                                   usize        b_size)
+{
+    int           fd       = stream == OUTPUT_STDOUT ? STDOUT_FILENO
+                                                     : STDERR_FILENO;
+    struct iovec  parts[2] = {{(void*)a, a_size}, {(void*)b, b_size}};
+    struct iovec* part     = parts;
+    int           count    = 2;
+
+    while (count) {
+        ssize_t written = writev(fd, part, count);
+        if (written <= 0) {
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        // A full pipe takes part of it; carry on from where it stopped.
+        while (count && (usize)written >= part->iov_len) {
+            written -= (ssize_t)part->iov_len;
+            part++;
+            count--;
+        }
+        if (count) {
+            part->iov_base = (char*)part->iov_base + written;
+            part->iov_len -= (usize)written;
+        }
+    }
+}
 
 #elif defined(OS_WINDOWS)
 
-internal void fprv(HANDLE handle, cstr format, va_list args)
+internal HANDLE _output_handle(OutputStream stream)
 {
-    usize size;
-    mutex_lock(&g_kore_output_mutex);
-    cstr output = _format_output(format, args, &size);
+    return GetStdHandle(stream == OUTPUT_STDOUT ? STD_OUTPUT_HANDLE
+                                                : STD_ERROR_HANDLE);
+}
 
-    // Write to the file handle.
+internal bool _output_is_terminal(OutputStream stream)
+{
     DWORD console_mode;
-    BOOL  is_console = GetConsoleMode(handle, &console_mode);
+    return GetConsoleMode(_output_handle(stream), &console_mode);
+}
+
+// Handles have no gather write, so the pieces go out one after the other,
+// under the caller's lock so nothing gets between them.
+internal void _output_write_locked(OutputStream stream,
+                                   cstr         a,
+                                   usize        a_size,
+                                   cstr         b,
+                                   usize        b_size)
+{
+    HANDLE handle = _output_handle(stream);
+    DWORD  console_mode;
+    BOOL   is_console = GetConsoleMode(handle, &console_mode);
+    cstr   parts[2]   = {a, b};
+    usize  sizes[2]   = {a_size, b_size};
+
+    for (usize i = 0; i < 2; ++i) {
+        if (!sizes[i]) {
+            continue;
+        }
+        DWORD bytes_written;
+        if (is_console) {
+            WriteConsoleA(
+                handle, parts[i], (DWORD)sizes[i], &bytes_written, NULL);
+        } else {
+            WriteFile(handle, parts[i], (DWORD)sizes[i], &bytes_written, NULL);
+        }
+    }
+}
+
+#else
+#    error "Output functions not implemented for this OS."
+
+#endif // OS_POSIX
+
+internal void _output_write(OutputStream stream,
+                            cstr         a,
+                            usize        a_size,
+                            cstr         b,
+                            usize        b_size)
+{
+    adaptive_mutex_lock(&g_kore_output_mutex);
+    _output_write_locked(stream, a, a_size, b, b_size);
+    adaptive_mutex_unlock(&g_kore_output_mutex);
+}
+
+//------------------------------------------------------------------------------
+// Buffering
+
+internal OutputFlush _output_flush_policy(OutputStream stream)
+{
+    u32 flush = atomic_load_u32(&g_output_flush[stream], MEMORY_RELAXED);
+    if (flush == OUTPUT_FLUSH_AUTO) {
+        u32 auto_flush = OUTPUT_FLUSH_AUTO;
+        flush          = _output_is_terminal(stream) ? OUTPUT_FLUSH_LINES
+                                                     : OUTPUT_FLUSH_FULL;
+        atomic_cas_u32(
+            &g_output_flush[stream], &auto_flush, flush, MEMORY_RELAXED);
+    }
+    return (OutputFlush)flush;
+}
+
+// Writes out the first `size` bytes of the buffer followed by `extra`, and
+// keeps the rest.
+internal void _output_flush(OutputStream stream,
+                            usize        size,
+                            cstr         extra,
+                            usize        extra_size)
+{
+    OutputBuffer* buffer = &g_output_thread.buffers[stream];
+    if (!size && !extra_size) {
+        return;
+    }
+    _output_write(stream, buffer->data, size, extra, extra_size);
+    memmove(buffer->data, buffer->data + size, buffer->size - size);
+    buffer->size -= size;
+}
+
+// The size of the buffer up to its last newline at or after `from`, or 0.
+internal usize _output_lines_end(OutputBuffer* buffer, usize from)
+{
+    for (usize i = buffer->size; i > from; --i) {
+        if (buffer->data[i - 1] == '\n') {
+            return i;
+        }
+    }
+    return 0;
+}
+
+// Formats onto the end of the buffer if the text fits, which vsnprintf only
+// knows once it has tried.  The newline takes the terminator's place.
+internal bool _output_append(OutputBuffer* buffer,
+                             cstr          format,
+                             va_list       args,
+                             bool          newline,
+                             usize*        out_length)
+{
+    char*   end  = buffer->data + buffer->size;
+    usize   room = OUTPUT_BUFFER_SIZE - buffer->size;
+    va_list args_copy;
+    va_copy(args_copy, args);
+    int length = vsnprintf(end, room, format, args_copy);
+    va_end(args_copy);
 
-    DWORD bytes_written;
-    if (is_console) {
-        WriteConsoleA(handle, output, size, &bytes_written, NULL);
+    *out_length = length < 0 ? 0 : (usize)length;
+    if (*out_length >= room) {
+        return false;
+    }
+    if (newline) {
+        end[*out_length] = '\n';
+    }
+    buffer->size += *out_length + newline;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Threads
+
+// Writes out everything a thread has buffered.  The caller holds the output
+// lock.
+internal void _output_drain(OutputThread* thread)
+{
+    for (usize stream = 0; stream < OUTPUT_STREAM_COUNT; ++stream) {
+        OutputBuffer* buffer = &thread->buffers[stream];
+        _output_write_locked(stream, buffer->data, buffer->size, NULL, 0);
+        buffer->size = 0;
+    }
+}
+
+// Runs as each thread ends, whoever created it.
+internal void _output_thread_exit(void* context)
+{
+    OutputThread* thread = context;
+    adaptive_mutex_lock(&g_kore_output_mutex);
+    _output_drain(thread);
+    if (thread->prev) {
+        thread->prev->next = thread->next;
     } else {
-        WriteFile(handle, output, size, &bytes_written, NULL);
+        g_output_threads = thread->next;
     }
-    mutex_unlock(&g_kore_output_mutex);
+    if (thread->next) {
+        thread->next->prev = thread->prev;
+    }
+    thread->linked = false;
+    adaptive_mutex_unlock(&g_kore_output_mutex);
 }
 
-void prv(cstr format, va_list args)
+#if OS_WINDOWS
+internal VOID WINAPI _output_fls_exit(PVOID context)
 {
-    fprv(GetStdHandle(STD_OUTPUT_HANDLE), format, args);
+    _output_thread_exit(context);
 }
+#endif // OS_WINDOWS
 
-void eprv(cstr format, va_list args)
+// Threads still running at exit have their buffers written out too, though a
+// thread caught mid-print may lose what it was adding.
+internal void _output_at_exit(void)
 {
-    fprv(GetStdHandle(STD_ERROR_HANDLE), format, args);
+    adaptive_mutex_lock(&g_kore_output_mutex);
+    for (OutputThread* thread = g_output_threads; thread;
+         thread               = thread->next) {
+        _output_drain(thread);
+    }
+    adaptive_mutex_unlock(&g_kore_output_mutex);
 }
 
-#else
-#    error "Output functions not implemented for this OS."
+// Links the calling thread in on its first print, and asks for its buffers to
+// be written out when it ends.
+internal void _output_register(void)
+{
+    OutputThread* thread = &g_output_thread;
+    adaptive_mutex_lock(&g_kore_output_mutex);
+    if (!g_output_ready) {
+        g_output_ready = true;
+        atexit(_output_at_exit);
+#if OS_POSIX
+        pthread_key_create(&g_output_key, _output_thread_exit);
+#elif OS_WINDOWS
+        g_output_key = FlsAlloc(_output_fls_exit);
+#endif
+    }
+    thread->prev = NULL;
+    thread->next = g_output_threads;
+    if (g_output_threads) {
+        g_output_threads->prev = thread;
+    }
+    g_output_threads = thread;
+    thread->linked   = true;
+    adaptive_mutex_unlock(&g_kore_output_mutex);
 
-#endif // OS_POSIX
+#if OS_POSIX
+    pthread_setspecific(g_output_key, thread);
+#elif OS_WINDOWS
+    FlsSetValue(g_output_key, thread);
+#endif
+}
+
+//------------------------------------------------------------------------------
+
+internal void _output_print(OutputStream stream,
+                            cstr         format,
+                            va_list      args,
+                            bool         newline)
+{
+    if (!g_output_thread.linked) {
+        _output_register();
+    }
+    OutputBuffer* buffers = g_output_thread.buffers;
+    if (stream == OUTPUT_STDERR) {
+        _output_flush(OUTPUT_STDOUT, buffers[OUTPUT_STDOUT].size, NULL, 0);
+    }
+
+    OutputBuffer* buffer = &buffers[stream];
+    usize         start  = buffer->size;
+    usize         length;
+    if (!_output_append(buffer, format, args, newline, &length)) {
+        // Make room with the complete lines first, so that only a line longer
+        // than the buffer is ever split.
+        _output_flush(stream, _output_lines_end(buffer, 0), NULL, 0);
+        if (length >= OUTPUT_BUFFER_SIZE - buffer->size) {
+            _output_flush(stream, buffer->size, NULL, 0);
+        }
+        if (length >= OUTPUT_BUFFER_SIZE) {
+            // Too big to buffer at all: write it straight out.
+            usize size;
+            char* text = (char*)_format_output(format, args, &size);
+            if (newline) {
+                text[size++] = '\n';
+            }
+            _output_flush(stream, 0, text, size);
+            return;
+        }
+        start = buffer->size;
+        _output_append(buffer, format, args, newline, &length);
+    }
+
+    if (_output_flush_policy(stream) == OUTPUT_FLUSH_LINES) {
+        _output_flush(stream, _output_lines_end(buffer, start), NULL, 0);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void pr_set_flush(OutputFlush flush)
+{
+    atomic_store_u32(&g_output_flush[OUTPUT_STDOUT], flush, MEMORY_RELAXED);
+}
+
+void epr_set_flush(OutputFlush flush)
+{
+    atomic_store_u32(&g_output_flush[OUTPUT_STDERR], flush, MEMORY_RELAXED);
+}
+
+void pr_flush(void)
+{
+    OutputBuffer* buffers = g_output_thread.buffers;
+    _output_flush(OUTPUT_STDOUT, buffers[OUTPUT_STDOUT].size, NULL, 0);
+    _output_flush(OUTPUT_STDERR, buffers[OUTPUT_STDERR].size, NULL, 0);
+}
+
+void prv(cstr format, va_list args)
+{
+    _output_print(OUTPUT_STDOUT, format, args, false);
+}
+
+void eprv(cstr format, va_list args)
+{
+    _output_print(OUTPUT_STDERR, format, args, false);
+}
 
 void pr(cstr format, ...)
 {
     va_list args;
     va_start(args, format);
-    prv(format, args);
+    _output_print(OUTPUT_STDOUT, format, args, false);
     va_end(args);
 }
 
@@ -94,8 +414,7 @@ void prn(cstr format, ...)
 {
     va_list args;
     va_start(args, format);
-    prv(format, args);
-    pr("\n");
+    _output_print(OUTPUT_STDOUT, format, args, true);
     va_end(args);
 }
 
@@ -103,7 +422,7 @@ void epr(cstr format, ...)
 {
     va_list args;
     va_start(args, format);
-    eprv(format, args);
+    _output_print(OUTPUT_STDERR, format, args, false);
     va_end(args);
 }
 
@@ -111,7 +430,6 @@ void eprn(cstr format, ...)
 {
     va_list args;
     va_start(args, format);
-    eprv(format, args);
-    epr("\n");
+    _output_print(OUTPUT_STDERR, format, args, true);
     va_end(args);
 }
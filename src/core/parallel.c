@@ -0,0 +1,699 @@
+//------------------------------------------------------------------------------
+// Data-parallel algorithms on the job system
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+
+#include <core/core.h>
+
+#define PARALLEL_INSERTION_SORT 16 // Runs below this length use insertion sort
+#define PARALLEL_RADIX_BITS 8
+#define PARALLEL_RADIX_BUCKETS (1 << PARALLEL_RADIX_BITS)
+
+//------------------------------------------------------------------------------
+// Running indexed tasks
+
+typedef void (*ParallelTaskFunc)(void* context, usize index);
+
+typedef struct {
+    Job              job;
+    ParallelTaskFunc func;
+    void*            context;
+    usize            index;
+} ParallelTask;
+
+internal void _parallel_task(void* context)
+{
+    ParallelTask* task = context;
+    task->func(task->context, task->index);
+}
+
+// Calls `func(context, i)` for every i in [0, count) as jobs and waits for them
+// all.
+internal void _parallel_invoke(JobSystem*       system,
+                               usize            count,
+                               ParallelTaskFunc func,
+                               void*            context)
+{
+    if (count == 1) {
+        func(context, 0);
+        return;
+    }
+
+    ArenaScratch  scratch = scratch_begin();
+    ParallelTask* tasks =
+        arena_alloc(scratch.arena, sizeof(ParallelTask) * count);
+    JobCounter counter = {0};
+    for (usize i = 0; i < count; ++i) {
+        tasks[i].func    = func;
+        tasks[i].context = context;
+        tasks[i].index   = i;
+        job_init(&tasks[i].job, _parallel_task, &tasks[i]);
+        job_submit(system, &tasks[i].job, &counter);
+    }
+    job_wait(system, &counter);
+    scratch_end(scratch);
+}
+
+//------------------------------------------------------------------------------
+// Splitting a range into chunks
+
+typedef struct {
+    usize count;       // Elements in the range
+    usize chunk_size;  // Elements per chunk (the last may be shorter)
+    usize chunk_count; // Number of chunks, at least 1
+} ParallelSplit;
+
+internal ParallelSplit _parallel_split(JobSystem* system,
+                                       usize      count,
+                                       usize      grain)
+{
+    grain            = grain ? grain : PARALLEL_DEFAULT_GRAIN;
+    usize max_chunks = system->worker_count * PARALLEL_CHUNKS_PER_WORKER;
+    usize chunks     = CLAMP((count + grain - 1) / grain, 1, max_chunks);
+    usize size       = MAX((count + chunks - 1) / chunks, 1);
+    return (ParallelSplit){
+        .count       = count,
+        .chunk_size  = size,
+        .chunk_count = MAX((count + size - 1) / size, 1),
+    };
+}
+
+internal usize _parallel_begin(ParallelSplit split, usize chunk)
+{
+    return MIN(chunk * split.chunk_size, split.count);
+}
+
+internal usize _parallel_end(ParallelSplit split, usize chunk)
+{
+    return MIN((chunk + 1) * split.chunk_size, split.count);
+}
+
+//------------------------------------------------------------------------------
+// Parallel copy
+
+typedef struct {
+    ParallelSplit split;
+    u8*           dst;
+    const u8*     src;
+} ParallelCopy;
+
+internal void _parallel_copy_chunk(void* context, usize chunk)
+{
+    ParallelCopy* copy  = context;
+    usize         begin = _parallel_begin(copy->split, chunk);
+    usize         end   = _parallel_end(copy->split, chunk);
+    memcpy(copy->dst + begin, copy->src + begin, end - begin);
+}
+
+internal void _parallel_copy(JobSystem*  system,
+                             void*       dst,
+                             const void* src,
+                             usize       bytes)
+{
+    ParallelCopy copy = {_parallel_split(system, bytes, KB(256)), dst, src};
+    _parallel_invoke(
+        system, copy.split.chunk_count, _parallel_copy_chunk, &copy);
+}
+
+//------------------------------------------------------------------------------
+// For
+
+typedef struct {
+    ParallelSplit   split;
+    ParallelForFunc func;
+    void*           context;
+} ParallelFor;
+
+internal void _parallel_for_chunk(void* context, usize chunk)
+{
+    ParallelFor* loop = context;
+    loop->func(loop->context,
+               _parallel_begin(loop->split, chunk),
+               _parallel_end(loop->split, chunk));
+}
+
+void parallel_for(JobSystem*      system,
+                  usize           count,
+                  usize           grain,
+                  ParallelForFunc func,
+                  void*           context)
+{
+    if (count == 0) {
+        return;
+    }
+    ParallelFor loop = {_parallel_split(system, count, grain), func, context};
+    _parallel_invoke(
+        system, loop.split.chunk_count, _parallel_for_chunk, &loop);
+}
+
+//------------------------------------------------------------------------------
+// Reduce
+
+typedef struct {
+    ParallelSplit      split;
+    ParallelReduceFunc reduce;
+    void*              context;
+    u8*                results; // One accumulator per chunk
+    usize              result_size;
+} ParallelReduce;
+
+internal void _parallel_reduce_chunk(void* context, usize chunk)
+{
+    ParallelReduce* reduce = context;
+    reduce->reduce(reduce->context,
+                   _parallel_begin(reduce->split, chunk),
+                   _parallel_end(reduce->split, chunk),
+                   reduce->results + chunk * reduce->result_size);
+}
+
+void parallel_reduce(JobSystem*          system,
+                     usize               count,
+                     usize               grain,
+                     ParallelReduceFunc  reduce,
+                     ParallelCombineFunc combine,
+                     void*               context,
+                     void*               result,
+                     usize               result_size)
+{
+    if (count == 0) {
+        return;
+    }
+
+    ArenaScratch   scratch = scratch_begin();
+    ParallelReduce state   = {
+          .split       = _parallel_split(system, count, grain),
+          .reduce      = reduce,
+          .context     = context,
+          .result_size = result_size,
+    };
+    usize chunks  = state.split.chunk_count;
+    state.results = arena_alloc(scratch.arena, chunks * result_size);
+    for (usize i = 0; i < chunks; ++i) {
+        memcpy(state.results + i * result_size, result, result_size);
+    }
+
+    _parallel_invoke(system, chunks, _parallel_reduce_chunk, &state);
+
+    for (usize i = 0; i < chunks; ++i) {
+        combine(context, result, state.results + i * result_size);
+    }
+    scratch_end(scratch);
+}
+
+//------------------------------------------------------------------------------
+// Scan
+//
+// The first pass totals each chunk, a serial pass turns the totals into the
+// starting value of each chunk, and the second pass scans each chunk from its
+// starting value.
+
+typedef struct {
+    ParallelSplit       split;
+    const u8*           input;
+    u8*                 output;
+    usize               element_size;
+    ParallelCombineFunc combine;
+    void*               context;
+    u8*                 totals;  // Per chunk: total, then starting value
+    u8*                 scratch; // Per chunk: one element of temporary space
+    bool                inclusive;
+} ParallelScan;
+
+internal void _parallel_scan_total(void* context, usize chunk)
+{
+    ParallelScan* scan  = context;
+    usize         size  = scan->element_size;
+    u8*           total = scan->totals + chunk * size;
+    usize         end   = _parallel_end(scan->split, chunk);
+    for (usize i = _parallel_begin(scan->split, chunk); i < end; ++i) {
+        scan->combine(scan->context, total, scan->input + i * size);
+    }
+}
+
+internal void _parallel_scan_chunk(void* context, usize chunk)
+{
+    ParallelScan* scan  = context;
+    usize         size  = scan->element_size;
+    u8*           total = scan->totals + chunk * size;
+    u8*           value = scan->scratch + chunk * size;
+    usize         end   = _parallel_end(scan->split, chunk);
+    for (usize i = _parallel_begin(scan->split, chunk); i < end; ++i) {
+        // Copy the input first, as the output may overwrite it.
+        memcpy(value, scan->input + i * size, size);
+        if (scan->inclusive) {
+            scan->combine(scan->context, total, value);
+            memcpy(scan->output + i * size, total, size);
+        } else {
+            memcpy(scan->output + i * size, total, size);
+            scan->combine(scan->context, total, value);
+        }
+    }
+}
+
+void parallel_scan(JobSystem*          system,
+                   const void*         input,
+                   usize               count,
+                   usize               element_size,
+                   void*               output,
+                   usize               grain,
+                   ParallelCombineFunc combine,
+                   void*               context,
+                   const void*         identity,
+                   bool                inclusive)
+{
+    if (count == 0) {
+        return;
+    }
+
+    ArenaScratch scratch = scratch_begin();
+    ParallelScan scan    = {
+           .split        = _parallel_split(system, count, grain),
+           .input        = input,
+           .output       = output,
+           .element_size = element_size,
+           .combine      = combine,
+           .context      = context,
+           .inclusive    = inclusive,
+    };
+    usize chunks = scan.split.chunk_count;
+    scan.totals  = arena_alloc(scratch.arena, chunks * element_size);
+    scan.scratch = arena_alloc(scratch.arena, (chunks + 1) * element_size);
+    for (usize i = 0; i < chunks; ++i) {
+        memcpy(scan.totals + i * element_size, identity, element_size);
+    }
+
+    // The last chunk's total is never needed.
+    if (chunks > 1) {
+        _parallel_invoke(system, chunks - 1, _parallel_scan_total, &scan);
+    }
+
+    // Replace each total with the combined totals of the chunks before it.
+    u8* running = scan.scratch + chunks * element_size;
+    memcpy(running, identity, element_size);
+    for (usize i = 0; i < chunks; ++i) {
+        u8* total = scan.totals + i * element_size;
+        memcpy(scan.scratch, total, element_size);
+        memcpy(total, running, element_size);
+        combine(context, running, scan.scratch);
+    }
+
+    _parallel_invoke(system, chunks, _parallel_scan_chunk, &scan);
+    scratch_end(scratch);
+}
+
+//------------------------------------------------------------------------------
+// Merge sort
+
+typedef struct {
+    u8*                 base;
+    u8*                 temp; // Same size as `base`
+    usize               count;
+    usize               element_size;
+    ParallelCompareFunc compare;
+    void*               context;
+    ParallelSplit       split;
+
+    // Current merge round
+    u8*   src;
+    u8*   dst;
+    usize run;    // Length of the sorted runs being merged
+    usize pieces; // Tasks per pair of runs
+} ParallelSort;
+
+internal u8* _sort_at(ParallelSort* sort, u8* base, usize index)
+{
+    return base + index * sort->element_size;
+}
+
+// Merges sorted `a` and `b` into `dst`, taking from `a` on ties.
+internal void _sort_merge(ParallelSort* sort,
+                          u8*           dst,
+                          u8*           a,
+                          usize         a_count,
+                          u8*           b,
+                          usize         b_count)
+{
+    usize size = sort->element_size;
+    while (a_count && b_count) {
+        if (sort->compare(sort->context, b, a) < 0) {
+            memcpy(dst, b, size);
+            b += size;
+            b_count--;
+        } else {
+            memcpy(dst, a, size);
+            a += size;
+            a_count--;
+        }
+        dst += size;
+    }
+    memcpy(dst, a, a_count * size);
+    memcpy(dst + a_count * size, b, b_count * size);
+}
+
+// Sorts one chunk in place, using the same span of `temp`.
+internal void _sort_chunk(void* context, usize chunk)
+{
+    ParallelSort* sort  = context;
+    usize         size  = sort->element_size;
+    usize         begin = _parallel_begin(sort->split, chunk);
+    usize         count = _parallel_end(sort->split, chunk) - begin;
+    u8*           src   = _sort_at(sort, sort->base, begin);
+    u8*           dst   = _sort_at(sort, sort->temp, begin);
+
+    // Insertion sort short runs, using the first temp slot as the hole.
+    u8* hole = dst;
+    for (usize run = 0; run < count; run += PARALLEL_INSERTION_SORT) {
+        usize end = MIN(run + PARALLEL_INSERTION_SORT, count);
+        for (usize i = run + 1; i < end; ++i) {
+            memcpy(hole, src + i * size, size);
+            usize j = i;
+            while (j > run &&
+                   sort->compare(sort->context, hole, src + (j - 1) * size) <
+                       0) {
+                memcpy(src + j * size, src + (j - 1) * size, size);
+                j--;
+            }
+            memcpy(src + j * size, hole, size);
+        }
+    }
+
+    // Merge runs bottom-up, swapping between the chunk and its temp span.
+    for (usize run = PARALLEL_INSERTION_SORT; run < count; run *= 2) {
+        for (usize start = 0; start < count; start += 2 * run) {
+            usize mid = MIN(start + run, count);
+            usize end = MIN(start + 2 * run, count);
+            _sort_merge(sort,
+                        dst + start * size,
+                        src + start * size,
+                        mid - start,
+                        src + mid * size,
+                        end - mid);
+        }
+        u8* swap = src;
+        src      = dst;
+        dst      = swap;
+    }
+    if (src != _sort_at(sort, sort->base, begin)) {
+        memcpy(dst, src, count * size);
+    }
+}
+
+// Returns how many of the first `k` merged elements come from `a`.
+internal usize _sort_corank(ParallelSort* sort,
+                            u8*           a,
+                            usize         a_count,
+                            u8*           b,
+                            usize         b_count,
+                            usize         k)
+{
+    usize lo = k > b_count ? k - b_count : 0;
+    usize hi = MIN(k, a_count);
+    while (lo < hi) {
+        // Does a[mid] come before b[k - mid - 1]?
+        usize mid = lo + (hi - lo) / 2;
+        if (sort->compare(sort->context,
+                          _sort_at(sort, b, k - mid - 1),
+                          _sort_at(sort, a, mid)) >= 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Merges one piece of one pair of runs.
+internal void _sort_merge_piece(void* context, usize index)
+{
+    ParallelSort* sort  = context;
+    usize         pair  = index / sort->pieces;
+    usize         piece = index % sort->pieces;
+    usize         start = pair * 2 * sort->run;
+    usize         mid   = MIN(start + sort->run, sort->count);
+    usize         end   = MIN(start + 2 * sort->run, sort->count);
+
+    u8*   a       = _sort_at(sort, sort->src, start);
+    u8*   b       = _sort_at(sort, sort->src, mid);
+    usize a_count = mid - start;
+    usize b_count = end - mid;
+    usize total   = end - start;
+    usize k0      = total * piece / sort->pieces;
+    usize k1      = total * (piece + 1) / sort->pieces;
+    usize i0      = _sort_corank(sort, a, a_count, b, b_count, k0);
+    usize i1      = _sort_corank(sort, a, a_count, b, b_count, k1);
+
+    _sort_merge(sort,
+                _sort_at(sort, sort->dst, start + k0),
+                _sort_at(sort, a, i0),
+                i1 - i0,
+                _sort_at(sort, b, k0 - i0),
+                (k1 - i1) - (k0 - i0));
+}
+
+void parallel_sort(JobSystem*          system,
+                   void*               base,
+                   usize               count,
+                   usize               element_size,
+                   ParallelCompareFunc compare,
+                   void*               context)
+{
+    if (count < 2) {
+        return;
+    }
+
+    ArenaScratch scratch = scratch_begin();
+    ParallelSort sort    = {
+           .base         = base,
+           .temp         = arena_alloc(scratch.arena, count * element_size),
+           .count        = count,
+           .element_size = element_size,
+           .compare      = compare,
+           .context      = context,
+           .split        = _parallel_split(system, count, 0),
+    };
+    usize chunks = sort.split.chunk_count;
+    _parallel_invoke(system, chunks, _sort_chunk, &sort);
+
+    // Merge pairs of runs until one is left, splitting each merge so that
+    // every round still has about `chunks` tasks.
+    sort.src = sort.base;
+    sort.dst = sort.temp;
+    for (sort.run = sort.split.chunk_size; sort.run < count; sort.run *= 2) {
+        usize pairs = (count + 2 * sort.run - 1) / (2 * sort.run);
+        sort.pieces = MAX(chunks / pairs, 1);
+        _parallel_invoke(system, pairs * sort.pieces, _sort_merge_piece, &sort);
+
+        u8* swap = sort.src;
+        sort.src = sort.dst;
+        sort.dst = swap;
+    }
+    if (sort.src != sort.base) {
+        _parallel_copy(system, sort.base, sort.src, count * element_size);
+    }
+    scratch_end(scratch);
+}
+
+//------------------------------------------------------------------------------
+// Radix sort
+
+typedef struct {
+    ParallelSplit split;
+    u8*           src;
+    u8*           dst;
+    usize         element_size;
+    usize         key_offset;
+    usize         key_size;
+    u32           shift;     // Bit position of the current digit
+    usize*        histogram; // PARALLEL_RADIX_BUCKETS counts per chunk
+} ParallelRadix;
+
+internal usize _radix_digit(ParallelRadix* radix, const u8* element)
+{
+    u64 key = 0;
+    memcpy(&key, element + radix->key_offset, radix->key_size);
+    return (usize)(key >> radix->shift) & (PARALLEL_RADIX_BUCKETS - 1);
+}
+
+internal void _radix_count(void* context, usize chunk)
+{
+    ParallelRadix* radix  = context;
+    usize*         counts = radix->histogram + chunk * PARALLEL_RADIX_BUCKETS;
+    memset(counts, 0, sizeof(usize) * PARALLEL_RADIX_BUCKETS);
+
+    usize end = _parallel_end(radix->split, chunk);
+    for (usize i = _parallel_begin(radix->split, chunk); i < end; ++i) {
+        counts[_radix_digit(radix, radix->src + i * radix->element_size)]++;
+    }
+}
+
+internal void _radix_scatter(void* context, usize chunk)
+{
+    ParallelRadix* radix   = context;
+    usize*         offsets = radix->histogram + chunk * PARALLEL_RADIX_BUCKETS;
+    usize          size    = radix->element_size;
+
+    usize end = _parallel_end(radix->split, chunk);
+    for (usize i = _parallel_begin(radix->split, chunk); i < end; ++i) {
+        const u8* element = radix->src + i * size;
+        memcpy(radix->dst + offsets[_radix_digit(radix, element)]++ * size,
+               element,
+               size);
+    }
+}
+
+void parallel_radix_sort(JobSystem* system,
+                         void*      base,
+                         usize      count,
+                         usize      element_size,
+                         usize      key_offset,
+                         usize      key_size)
+{
+    ASSERT(key_size >= 1 && key_size <= sizeof(u64),
+           "Radix sort keys must be 1 to 8 bytes.");
+    if (count < 2) {
+        return;
+    }
+
+    ArenaScratch  scratch = scratch_begin();
+    ParallelRadix radix   = {
+          .split        = _parallel_split(system, count, 0),
+          .src          = base,
+          .dst          = arena_alloc(scratch.arena, count * element_size),
+          .element_size = element_size,
+          .key_offset   = key_offset,
+          .key_size     = key_size,
+    };
+    usize chunks    = radix.split.chunk_count;
+    radix.histogram = arena_alloc(
+        scratch.arena, sizeof(usize) * PARALLEL_RADIX_BUCKETS * chunks);
+
+    for (radix.shift = 0; radix.shift < key_size * 8;
+         radix.shift += PARALLEL_RADIX_BITS) {
+        _parallel_invoke(system, chunks, _radix_count, &radix);
+
+        // Turn the counts into each chunk's first output slot per digit,
+        // ordered by digit and then by chunk so that the sort is stable.
+        usize offset = 0;
+        bool  skip   = false;
+        for (usize digit = 0; digit < PARALLEL_RADIX_BUCKETS; ++digit) {
+            usize digit_count = 0;
+            for (usize c = 0; c < chunks; ++c) {
+                usize* slot =
+                    &radix.histogram[c * PARALLEL_RADIX_BUCKETS + digit];
+                usize n = *slot;
+                *slot   = offset;
+                offset += n;
+                digit_count += n;
+            }
+            skip |= digit_count == count;
+        }
+        if (skip) {
+            continue;
+        }
+
+        _parallel_invoke(system, chunks, _radix_scatter, &radix);
+        u8* swap  = radix.src;
+        radix.src = radix.dst;
+        radix.dst = swap;
+    }
+
+    if (radix.src != base) {
+        _parallel_copy(system, base, radix.src, count * element_size);
+    }
+    scratch_end(scratch);
+}
+
+//------------------------------------------------------------------------------
+// Partition
+
+typedef struct {
+    ParallelSplit         split;
+    const u8*             input;
+    u8*                   output;
+    usize                 element_size;
+    ParallelPredicateFunc predicate;
+    void*                 context;
+    u8*                   flags;  // Predicate result per element
+    usize*                passed; // Per chunk: count, then first output slot
+    usize*                failed; // Per chunk: count, then first output slot
+} ParallelPartition;
+
+internal void _partition_count(void* context, usize chunk)
+{
+    ParallelPartition* partition = context;
+    usize              passed    = 0;
+    usize              begin     = _parallel_begin(partition->split, chunk);
+    usize              end       = _parallel_end(partition->split, chunk);
+    for (usize i = begin; i < end; ++i) {
+        bool flag = partition->predicate(
+            partition->context, partition->input + i * partition->element_size);
+        partition->flags[i] = flag;
+        passed += flag;
+    }
+    partition->passed[chunk] = passed;
+    partition->failed[chunk] = (end - begin) - passed;
+}
+
+internal void _partition_scatter(void* context, usize chunk)
+{
+    ParallelPartition* partition = context;
+    usize              size      = partition->element_size;
+    usize              passed    = partition->passed[chunk];
+    usize              failed    = partition->failed[chunk];
+    usize              end       = _parallel_end(partition->split, chunk);
+    for (usize i = _parallel_begin(partition->split, chunk); i < end; ++i) {
+        usize slot = partition->flags[i] ? passed++ : failed++;
+        memcpy(partition->output + slot * size,
+               partition->input + i * size,
+               size);
+    }
+}
+
+usize parallel_partition(JobSystem*            system,
+                         const void*           input,
+                         usize                 count,
+                         usize                 element_size,
+                         void*                 output,
+                         ParallelPredicateFunc predicate,
+                         void*                 context)
+{
+    if (count == 0) {
+        return 0;
+    }
+
+    ArenaScratch      scratch   = scratch_begin();
+    ParallelPartition partition = {
+        .split        = _parallel_split(system, count, 0),
+        .input        = input,
+        .output       = output,
+        .element_size = element_size,
+        .predicate    = predicate,
+        .context      = context,
+        .flags        = arena_alloc(scratch.arena, count),
+    };
+    usize chunks     = partition.split.chunk_count;
+    partition.passed = arena_alloc(scratch.arena, sizeof(usize) * chunks);
+    partition.failed = arena_alloc(scratch.arena, sizeof(usize) * chunks);
+
+    _parallel_invoke(system, chunks, _partition_count, &partition);
+
+    usize total_passed = 0;
+    for (usize i = 0; i < chunks; ++i) {
+        total_passed += partition.passed[i];
+    }
+    usize passed = 0;
+    usize failed = total_passed;
+    for (usize i = 0; i < chunks; ++i) {
+        usize chunk_passed  = partition.passed[i];
+        usize chunk_failed  = partition.failed[i];
+        partition.passed[i] = passed;
+        partition.failed[i] = failed;
+        passed += chunk_passed;
+        failed += chunk_failed;
+    }
+
+    _parallel_invoke(system, chunks, _partition_scatter, &partition);
+    scratch_end(scratch);
+    return total_passed;
+}
@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+// Pool implementation
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+
+#include <core/core.h>
+
+//------------------------------------------------------------------------------
+
+void pool_init(Pool* pool, Arena* arena, usize slot_size, usize alignment)
+{
+    // Every slot must be able to hold the free list link.
+    alignment = MAX(alignment, alignof(void*));
+    slot_size = ALIGN_UP(MAX(slot_size, sizeof(void*)), alignment);
+
+    pool->arena     = arena;
+    pool->slot_size = slot_size;
+    pool->alignment = alignment;
+    pool_reset(pool);
+}
+
+void pool_reset(Pool* pool)
+{
+    pool->free_list  = NULL;
+    pool->chunk_next = NULL;
+    pool->chunk_end  = NULL;
+    pool->count      = 0;
+}
+
+internal void* _pool_alloc_chunk(Pool* pool)
+{
+    // Carve a page's worth of slots at a time so that fresh slots are adjacent
+    // even when the arena is shared with other allocations.
+    usize slots = MAX(pool->arena->alloc_granularity / pool->slot_size, 1);
+    usize size  = slots * pool->slot_size;
+
+    u8* chunk        = arena_alloc_align(pool->arena, size, pool->alignment);
+    pool->chunk_next = chunk + pool->slot_size;
+    pool->chunk_end  = chunk + size;
+    return chunk;
+}
+
+void* pool_alloc(Pool* pool)
+{
+    pool->count++;
+
+    void* slot = pool->free_list;
+    if (slot) {
+        pool->free_list = *(void**)slot;
+
+#if CONFIG_DEBUG
+        u8* bytes = (u8*)slot;
+        for (usize i = sizeof(void*); i < pool->slot_size; ++i) {
+            ASSERT(bytes[i] == POOL_POISON_BYTE,
+                   "Pool slot %p was written to after being freed.",
+                   slot);
+        }
+#endif // CONFIG_DEBUG
+
+        return slot;
+    }
+
+    if (pool->chunk_next < pool->chunk_end) {
+        slot = pool->chunk_next;
+        pool->chunk_next += pool->slot_size;
+        return slot;
+    }
+
+    return _pool_alloc_chunk(pool);
+}
+
+void pool_free(Pool* pool, void* ptr)
+{
+    if (!ptr) {
+        return;
+    }
+
+    ASSERT(pool->count > 0, "Pool free without a matching allocation.");
+    pool->count--;
+
+#if CONFIG_DEBUG
+    memset(ptr, POOL_POISON_BYTE, pool->slot_size);
+#endif // CONFIG_DEBUG
+
+    *(void**)ptr    = pool->free_list;
+    pool->free_list = ptr;
+}
@@ -0,0 +1,261 @@
+//------------------------------------------------------------------------------
+// Lock-free bounded queues
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+
+#include <core/core.h>
+
+#if OS_POSIX
+#    include <sched.h>
+#endif // OS_POSIX
+
+#define QUEUE_SPINS 64 // Failed attempts before a blocking call yields
+
+//------------------------------------------------------------------------------
+
+// Spins for a while, then yields the CPU on each further call.
+internal void _queue_backoff(u32* spins)
+{
+    if (++*spins < QUEUE_SPINS) {
+        CPU_RELAX();
+    } else {
+#if OS_WINDOWS
+        SwitchToThread();
+#else
+        sched_yield();
+#endif // OS_WINDOWS
+    }
+}
+
+internal usize _queue_capacity(usize capacity)
+{
+    usize rounded = 2;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+//------------------------------------------------------------------------------
+// SPSC ring
+
+void spsc_init(SpscQueue* queue,
+               Arena*     arena,
+               usize      capacity,
+               usize      element_size)
+{
+    memset(queue, 0, sizeof(*queue));
+    queue->capacity     = _queue_capacity(capacity);
+    queue->element_size = element_size;
+    queue->buffer       = arena_alloc_align(
+        arena, queue->capacity * element_size, CACHE_LINE);
+}
+
+// Copies `count` elements between the ring, starting at `index`, and `data`,
+// splitting the copy where the ring wraps.
+internal void _spsc_copy(SpscQueue* queue,
+                         u64        index,
+                         u8*        data,
+                         usize      count,
+                         bool       into_ring)
+{
+    usize slot  = (usize)index & (queue->capacity - 1);
+    usize first = MIN(count, queue->capacity - slot) * queue->element_size;
+    usize rest  = count * queue->element_size - first;
+    u8*   ring  = queue->buffer + slot * queue->element_size;
+
+    if (into_ring) {
+        memcpy(ring, data, first);
+        memcpy(queue->buffer, data + first, rest);
+    } else {
+        memcpy(data, ring, first);
+        memcpy(data + first, queue->buffer, rest);
+    }
+}
+
+usize spsc_push_batch(SpscQueue* queue, const void* elements, usize count)
+{
+    u64   head = queue->head;
+    usize free = queue->capacity - (usize)(head - queue->cached_tail);
+    if (free < count) {
+        queue->cached_tail = atomic_load_u64(&queue->tail, MEMORY_ACQUIRE);
+        free = queue->capacity - (usize)(head - queue->cached_tail);
+    }
+
+    count = MIN(count, free);
+    if (count) {
+        _spsc_copy(queue, head, (u8*)elements, count, true);
+        atomic_store_u64(&queue->head, head + count, MEMORY_RELEASE);
+    }
+    return count;
+}
+
+usize spsc_pop_batch(SpscQueue* queue, void* elements, usize count)
+{
+    u64   tail      = queue->tail;
+    usize available = (usize)(queue->cached_head - tail);
+    if (available < count) {
+        queue->cached_head = atomic_load_u64(&queue->head, MEMORY_ACQUIRE);
+        available          = (usize)(queue->cached_head - tail);
+    }
+
+    count = MIN(count, available);
+    if (count) {
+        _spsc_copy(queue, tail, (u8*)elements, count, false);
+        atomic_store_u64(&queue->tail, tail + count, MEMORY_RELEASE);
+    }
+    return count;
+}
+
+bool spsc_try_push(SpscQueue* queue, const void* element)
+{
+    return spsc_push_batch(queue, element, 1) == 1;
+}
+
+bool spsc_try_pop(SpscQueue* queue, void* element)
+{
+    return spsc_pop_batch(queue, element, 1) == 1;
+}
+
+void spsc_push(SpscQueue* queue, const void* element)
+{
+    u32 spins = 0;
+    while (!spsc_try_push(queue, element)) {
+        _queue_backoff(&spins);
+    }
+}
+
+void spsc_pop(SpscQueue* queue, void* element)
+{
+    u32 spins = 0;
+    while (!spsc_try_pop(queue, element)) {
+        _queue_backoff(&spins);
+    }
+}
+
+//------------------------------------------------------------------------------
+// MPMC queue
+//
+// A cell at position `pos` can be written when its sequence equals `pos` and
+// read when it equals `pos + 1`.  Reading sets it to `pos + capacity`, ready
+// for the producer one lap later.
+
+internal u8* _mpmc_cell(MpmcQueue* queue, u64 pos)
+{
+    usize index = (usize)pos & (queue->capacity - 1);
+    return queue->cells + index * queue->cell_size;
+}
+
+internal u64 _mpmc_sequence(MpmcQueue* queue, u64 pos)
+{
+    return atomic_load_u64((u64*)_mpmc_cell(queue, pos), MEMORY_ACQUIRE);
+}
+
+void mpmc_init(MpmcQueue* queue,
+               Arena*     arena,
+               usize      capacity,
+               usize      element_size)
+{
+    memset(queue, 0, sizeof(*queue));
+    queue->capacity     = _queue_capacity(capacity);
+    queue->element_size = element_size;
+    queue->cell_size    = ALIGN_UP(sizeof(u64) + element_size, sizeof(u64));
+    queue->cells        = arena_alloc_align(
+        arena, queue->capacity * queue->cell_size, CACHE_LINE);
+
+    for (usize i = 0; i < queue->capacity; ++i) {
+        *(u64*)_mpmc_cell(queue, i) = i;
+    }
+}
+
+// Claims up to `count` consecutive cells from `*pos_ptr` whose sequence is the
+// position plus `ready`, returning the first claimed position in `*first`.
+internal usize _mpmc_claim(MpmcQueue* queue,
+                           u64*       pos_ptr,
+                           u64        ready,
+                           usize      count,
+                           u64*       first)
+{
+    u64 pos = atomic_load_u64(pos_ptr, MEMORY_RELAXED);
+    for (;;) {
+        usize claimable = 0;
+        while (claimable < count) {
+            u64 next = pos + claimable;
+            if (_mpmc_sequence(queue, next) != next + ready) {
+                break;
+            }
+            claimable++;
+        }
+
+        if (claimable == 0) {
+            // Either the queue is full (or empty), or another thread claimed
+            // `pos` since we read it.
+            i64 diff = (i64)(_mpmc_sequence(queue, pos) - (pos + ready));
+            if (diff < 0) {
+                return 0;
+            }
+            pos = atomic_load_u64(pos_ptr, MEMORY_RELAXED);
+            continue;
+        }
+
+        if (atomic_cas_u64(pos_ptr, &pos, pos + claimable, MEMORY_RELAXED)) {
+            *first = pos;
+            return claimable;
+        }
+    }
+}
+
+usize mpmc_push_batch(MpmcQueue* queue, const void* elements, usize count)
+{
+    u64   pos;
+    usize claimed = _mpmc_claim(queue, &queue->enqueue_pos, 0, count, &pos);
+    for (usize i = 0; i < claimed; ++i) {
+        u8* cell = _mpmc_cell(queue, pos + i);
+        memcpy(cell + sizeof(u64),
+               (const u8*)elements + i * queue->element_size,
+               queue->element_size);
+        atomic_store_u64((u64*)cell, pos + i + 1, MEMORY_RELEASE);
+    }
+    return claimed;
+}
+
+usize mpmc_pop_batch(MpmcQueue* queue, void* elements, usize count)
+{
+    u64   pos;
+    usize claimed = _mpmc_claim(queue, &queue->dequeue_pos, 1, count, &pos);
+    for (usize i = 0; i < claimed; ++i) {
+        u8* cell = _mpmc_cell(queue, pos + i);
+        memcpy((u8*)elements + i * queue->element_size,
+               cell + sizeof(u64),
+               queue->element_size);
+        atomic_store_u64((u64*)cell, pos + i + queue->capacity, MEMORY_RELEASE);
+    }
+    return claimed;
+}
+
+bool mpmc_try_push(MpmcQueue* queue, const void* element)
+{
+    return mpmc_push_batch(queue, element, 1) == 1;
+}
+
+bool mpmc_try_pop(MpmcQueue* queue, void* element)
+{
+    return mpmc_pop_batch(queue, element, 1) == 1;
+}
+
+void mpmc_push(MpmcQueue* queue, const void* element)
+{
+    u32 spins = 0;
+    while (!mpmc_try_push(queue, element)) {
+        _queue_backoff(&spins);
+    }
+}
+
+void mpmc_pop(MpmcQueue* queue, void* element)
+{
+    u32 spins = 0;
+    while (!mpmc_try_pop(queue, element)) {
+        _queue_backoff(&spins);
+    }
+}
@@ -0,0 +1,136 @@
+//------------------------------------------------------------------------------
+// Seqlocks and snapshot publishing
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+
+#include <core/core.h>
+
+#if OS_POSIX
+#    include <sched.h>
+#endif // OS_POSIX
+
+// Spins before a waiting reader or writer gives up the CPU, in case the thread
+// it waits for has been preempted.
+#define SEQLOCK_SPINS 64
+
+internal void _seqlock_backoff(u32* spins)
+{
+    if (++*spins % SEQLOCK_SPINS) {
+        CPU_RELAX();
+        return;
+    }
+#if OS_WINDOWS
+    SwitchToThread();
+#else
+    sched_yield();
+#endif // OS_WINDOWS
+}
+
+//------------------------------------------------------------------------------
+// Seqlock
+
+void seqlock_init(SeqLock* lock) { lock->sequence = 0; }
+
+u32 seqlock_read_begin(SeqLock* lock)
+{
+    u32 spins = 0;
+    u32 sequence;
+    while ((sequence = atomic_load_u32(&lock->sequence, MEMORY_ACQUIRE)) & 1) {
+        _seqlock_backoff(&spins);
+    }
+    return sequence;
+}
+
+bool seqlock_read_retry(SeqLock* lock, u32 start)
+{
+    // Keeps the data reads above from moving below the second load.
+    atomic_fence(MEMORY_ACQUIRE);
+    return atomic_load_u32(&lock->sequence, MEMORY_RELAXED) != start;
+}
+
+void seqlock_write_lock(SeqLock* lock)
+{
+    u32 spins = 0;
+    for (;;) {
+        u32 sequence = atomic_load_u32(&lock->sequence, MEMORY_RELAXED);
+        if (!(sequence & 1) &&
+            atomic_cas_u32(
+                &lock->sequence, &sequence, sequence + 1, MEMORY_ACQUIRE)) {
+            break;
+        }
+        _seqlock_backoff(&spins);
+    }
+
+    // Readers that see any of the new data must also see the odd sequence.
+    atomic_fence(MEMORY_RELEASE);
+}
+
+void seqlock_write_unlock(SeqLock* lock)
+{
+    atomic_store_u32(&lock->sequence, lock->sequence + 1, MEMORY_RELEASE);
+}
+
+void seqlock_read(SeqLock* lock, void* out, const void* data, usize size)
+{
+    u32 start;
+    do {
+        start = seqlock_read_begin(lock);
+        memcpy(out, data, size);
+    } while (seqlock_read_retry(lock, start));
+}
+
+void seqlock_write(SeqLock* lock, void* data, const void* in, usize size)
+{
+    seqlock_write_lock(lock);
+    memcpy(data, in, size);
+    seqlock_write_unlock(lock);
+}
+
+//------------------------------------------------------------------------------
+// Snapshot
+
+void _snapshot_init(Snapshot* snapshot, SnapshotDefaultParams params)
+{
+    ASSERT(params.domain, "Snapshots need an epoch domain.");
+    snapshot->current      = params.initial;
+    snapshot->domain       = params.domain;
+    snapshot->free_func    = params.free_func ? params.free_func
+                                              : epoch_free_mem;
+    snapshot->free_context = params.free_context;
+}
+
+void snapshot_done(Snapshot* snapshot)
+{
+    if (snapshot->current) {
+        snapshot->free_func(snapshot->free_context, snapshot->current);
+        snapshot->current = NULL;
+    }
+}
+
+const void* snapshot_read_begin(Snapshot* snapshot, EpochThread* thread)
+{
+    ASSERT(thread->domain == snapshot->domain, "Wrong epoch domain.");
+    epoch_enter(thread);
+    return atomic_load_ptr(&snapshot->current, MEMORY_ACQUIRE);
+}
+
+void snapshot_read_end(Snapshot* snapshot, EpochThread* thread)
+{
+    UNUSED(snapshot);
+    epoch_exit(thread);
+}
+
+void snapshot_publish(Snapshot* snapshot, EpochThread* thread, void* fresh)
+{
+    ASSERT(thread->domain == snapshot->domain, "Wrong epoch domain.");
+    void* old = atomic_exchange_ptr(&snapshot->current, fresh, MEMORY_ACQ_REL);
+    if (old) {
+        epoch_retire(thread, old, snapshot->free_func, snapshot->free_context);
+    }
+}
+
+void* snapshot_current(Snapshot* snapshot)
+{
+    return atomic_load_ptr(&snapshot->current, MEMORY_ACQUIRE);
+}
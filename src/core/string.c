@@ -39,7 +39,8 @@ string string_formatv(Arena* arena, cstr fmt, va_list args)
 
     vsnprintf((char*)data, (usize)len + 1, fmt, args);
 
-    arena->cursor--; // Remove null terminator from arena allocation
+    // Remove null terminator from arena allocation
+    arena_shrink_last(arena, data, (usize)len + 1, (usize)len);
 
     return (string){.data = data, .count = (usize)len};
 }
@@ -61,6 +62,19 @@ string string_from(u8* data, usize size)
 //------------------------------------------------------------------------------
 // StringBuilder implementation
 
+// Builders rely on their appends being contiguous in the arena.
+internal u8* _sb_alloc(StringBuilder* sb, usize size)
+{
+    u8* dest = (u8*)arena_alloc(sb->arena, size);
+    if (sb->size == 0) {
+        // A chained arena may have moved on to a new block.
+        sb->data = dest;
+    }
+    ASSERT(dest == sb->data + sb->size,
+           "StringBuilder appends must be contiguous in the arena.");
+    return dest;
+}
+
 void sb_init(StringBuilder* sb, Arena* arena)
 {
     sb->data  = (u8*)arena_alloc(arena, 0);
@@ -76,14 +90,14 @@ void sb_append_cstr(StringBuilder* sb, cstr str)
 
 void sb_append_string(StringBuilder* sb, string str)
 {
-    u8* dest = (u8*)arena_alloc(sb->arena, str.count);
+    u8* dest = _sb_alloc(sb, str.count);
     memcpy(dest, str.data, str.count);
     sb->size += str.count;
 }
 
 void sb_append_char(StringBuilder* sb, char c)
 {
-    u8* dest = (u8*)arena_alloc(sb->arena, 1);
+    u8* dest = _sb_alloc(sb, 1);
     *dest    = (u8)c;
     sb->size += 1;
 }
@@ -103,9 +117,9 @@ void sb_formatv(StringBuilder* sb, cstr fmt, va_list args)
         return;
     }
 
-    u8* dest = (u8*)arena_alloc(sb->arena, (usize)len + 1);
+    u8* dest = _sb_alloc(sb, (usize)len + 1);
     vsnprintf((char*)dest, (usize)len + 1, fmt, args);
-    sb->arena->cursor--;
+    arena_shrink_last(sb->arena, dest, (usize)len + 1, (usize)len);
     sb->size += (usize)len;
 }
 
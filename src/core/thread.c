@@ -0,0 +1,304 @@
+//------------------------------------------------------------------------------
+// Threads and thread pool
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+
+#include <core/core.h>
+
+#include <stdio.h>
+
+#if OS_POSIX
+#    include <limits.h>
+#    include <unistd.h>
+#endif // OS_POSIX
+
+#if OS_LINUX
+#    include <sys/prctl.h>
+#elif OS_BSD
+#    include <pthread_np.h>
+#endif
+
+ThreadPool g_kore_thread_pool;
+
+//------------------------------------------------------------------------------
+// Threads
+//------------------------------------------------------------------------------
+
+// Lives on the creating thread's stack.  thread_create() waits until the new
+// thread has signalled `ready`, after which the record is no longer touched.
+typedef struct {
+    ThreadFunc func;
+    void*      context;
+    cstr       name;
+    u32        cpu; // THREAD_CPU() to pin to, or 0
+    Mutex      mutex;
+    CondVar    started;
+    bool       ready;
+} ThreadStart;
+
+internal void _thread_run(ThreadStart* start)
+{
+    ThreadFunc func    = start->func;
+    void*      context = start->context;
+    if (start->name) {
+        thread_set_name(start->name);
+    }
+    if (start->cpu && !thread_pin_cpu(start->cpu - 1)) {
+#if OS_LINUX || OS_WINDOWS
+        // The thread runs unpinned, but say so where pinning is supported.
+        eprn("Thread %s could not be pinned to CPU %u.",
+             start->name ? start->name : "(unnamed)",
+             start->cpu - 1);
+#endif
+    }
+
+    mutex_lock(&start->mutex);
+    start->ready = true;
+    condvar_signal(&start->started);
+    mutex_unlock(&start->mutex);
+
+    func(context);
+    scratch_done();
+}
+
+#if OS_WINDOWS
+
+internal DWORD WINAPI _thread_entry(LPVOID arg)
+{
+    _thread_run((ThreadStart*)arg);
+    return 0;
+}
+
+internal bool _thread_start(Thread* thread, ThreadStart* start, usize stack)
+{
+    thread->handle = CreateThread(NULL, stack, _thread_entry, start, 0, NULL);
+    return thread->handle != NULL;
+}
+
+void thread_join(Thread* thread)
+{
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+}
+
+void thread_detach(Thread* thread) { CloseHandle(thread->handle); }
+
+void thread_set_name(cstr name)
+{
+    wchar_t wide_name[64];
+    if (MultiByteToWideChar(CP_UTF8, 0, name, -1, wide_name, 64)) {
+        SetThreadDescription(GetCurrentThread(), wide_name);
+    }
+}
+
+usize thread_cpu_count(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (usize)info.dwNumberOfProcessors;
+}
+
+#elif OS_POSIX
+
+internal void* _thread_entry(void* arg)
+{
+    _thread_run((ThreadStart*)arg);
+    return NULL;
+}
+
+internal bool _thread_start(Thread* thread, ThreadStart* start, usize stack)
+{
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (stack) {
+        usize page = (usize)sysconf(_SC_PAGESIZE);
+        stack      = ALIGN_UP(MAX(stack, (usize)PTHREAD_STACK_MIN), page);
+        pthread_attr_setstacksize(&attr, stack);
+    }
+
+    int result = pthread_create(&thread->handle, &attr, _thread_entry, start);
+    pthread_attr_destroy(&attr);
+    return result == 0;
+}
+
+void thread_join(Thread* thread) { pthread_join(thread->handle, NULL); }
+void thread_detach(Thread* thread) { pthread_detach(thread->handle); }
+
+void thread_set_name(cstr name)
+{
+#    if OS_LINUX
+    // Linux limits names to 15 characters plus the terminator.
+    char short_name[16];
+    snprintf(short_name, sizeof(short_name), "%s", name);
+    prctl(PR_SET_NAME, short_name, 0, 0, 0);
+#    elif OS_MACOS
+    pthread_setname_np(name);
+#    elif OS_BSD
+    pthread_set_name_np(pthread_self(), name);
+#    endif
+}
+
+usize thread_cpu_count(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (usize)count : 1;
+}
+
+#else
+#    error "Threads not implemented for this OS."
+#endif // OS_WINDOWS
+
+bool _thread_create(Thread*             thread,
+                    ThreadFunc          func,
+                    void*               context,
+                    ThreadDefaultParams params)
+{
+    ThreadStart start = {
+        .func    = func,
+        .context = context,
+        .name    = params.name,
+        .cpu     = params.cpu,
+    };
+    mutex_init(&start.mutex);
+    condvar_init(&start.started);
+
+    bool created = _thread_start(thread, &start, params.stack_size);
+    if (created) {
+        mutex_lock(&start.mutex);
+        while (!start.ready) {
+            condvar_wait(&start.started, &start.mutex);
+        }
+        mutex_unlock(&start.mutex);
+    }
+
+    condvar_done(&start.started);
+    mutex_done(&start.mutex);
+    return created;
+}
+
+//------------------------------------------------------------------------------
+// Thread pool
+//------------------------------------------------------------------------------
+
+internal void _thread_pool_worker(void* context)
+{
+    ThreadPool* pool = (ThreadPool*)context;
+
+    mutex_lock(&pool->mutex);
+    for (;;) {
+        while (!pool->queued && !pool->stopping) {
+            condvar_wait(&pool->task_ready, &pool->mutex);
+        }
+        if (!pool->queued) {
+            // Stopping and the queue has drained.
+            break;
+        }
+
+        ThreadTask task = pool->tasks[pool->head];
+        pool->head      = (pool->head + 1) % pool->capacity;
+        pool->queued--;
+        pool->running++;
+        condvar_signal(&pool->task_space);
+        mutex_unlock(&pool->mutex);
+
+        task.func(task.context);
+
+        mutex_lock(&pool->mutex);
+        pool->running--;
+        if (!pool->queued && !pool->running) {
+            condvar_broadcast(&pool->idle);
+        }
+    }
+    mutex_unlock(&pool->mutex);
+}
+
+void _thread_pool_init(ThreadPool* pool, ThreadPoolDefaultParams params)
+{
+    if (params.thread_count == 0) {
+        params.thread_count = thread_cpu_count();
+    }
+    if (params.queue_capacity == 0) {
+        params.queue_capacity = THREAD_POOL_DEFAULT_CAPACITY;
+    }
+    if (!params.name) {
+        params.name = "worker";
+    }
+
+    pool->threads      = KORE_ARRAY_ALLOC(Thread, params.thread_count);
+    pool->thread_count = params.thread_count;
+    pool->tasks        = KORE_ARRAY_ALLOC(ThreadTask, params.queue_capacity);
+    pool->capacity     = params.queue_capacity;
+    pool->head         = 0;
+    pool->queued       = 0;
+    pool->running      = 0;
+    pool->stopping     = false;
+    mutex_init(&pool->mutex, .name = "thread_pool");
+    condvar_init(&pool->task_ready);
+    condvar_init(&pool->task_space);
+    condvar_init(&pool->idle);
+
+    for (usize i = 0; i < pool->thread_count; ++i) {
+        char name[32];
+        snprintf(name, sizeof(name), "%s-%zu", params.name, i);
+        u32  cpu     = params.pin_workers ? THREAD_CPU(cpu_spread(i)) : 0;
+        bool created = thread_create(&pool->threads[i],
+                                     _thread_pool_worker,
+                                     pool,
+                                     .stack_size = params.stack_size,
+                                     .name       = name,
+                                     .cpu        = cpu);
+        ASSERT(created, "Unable to create thread pool worker %zu.", i);
+    }
+}
+
+void thread_pool_done(ThreadPool* pool)
+{
+    mutex_lock(&pool->mutex);
+    pool->stopping = true;
+    condvar_broadcast(&pool->task_ready);
+    mutex_unlock(&pool->mutex);
+
+    for (usize i = 0; i < pool->thread_count; ++i) {
+        thread_join(&pool->threads[i]);
+    }
+
+    condvar_done(&pool->idle);
+    condvar_done(&pool->task_space);
+    condvar_done(&pool->task_ready);
+    mutex_done(&pool->mutex);
+    KORE_ARRAY_FREE(pool->tasks);
+    KORE_ARRAY_FREE(pool->threads);
+    pool->thread_count = 0;
+}
+
+void thread_pool_submit(ThreadPool* pool, ThreadFunc func, void* context)
+{
+    mutex_lock(&pool->mutex);
+    ASSERT(!pool->stopping, "Task submitted to a stopping thread pool.");
+    while (pool->queued == pool->capacity) {
+        condvar_wait(&pool->task_space, &pool->mutex);
+    }
+
+    usize tail        = (pool->head + pool->queued) % pool->capacity;
+    pool->tasks[tail] = (ThreadTask){.func = func, .context = context};
+    pool->queued++;
+    condvar_signal(&pool->task_ready);
+    mutex_unlock(&pool->mutex);
+}
+
+void thread_pool_wait(ThreadPool* pool)
+{
+    mutex_lock(&pool->mutex);
+    while (pool->queued || pool->running) {
+        condvar_wait(&pool->idle, &pool->mutex);
+    }
+    mutex_unlock(&pool->mutex);
+}
+
+ThreadPool* thread_pool_global(void)
+{
+    ASSERT(g_kore_thread_pool.threads,
+           "The global thread pool is only available inside run().");
+    return &g_kore_thread_pool;
+}
@@ -0,0 +1,276 @@
+//------------------------------------------------------------------------------
+// Hierarchical timer wheel
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+
+#include <core/core.h>
+
+// Bucket of timers detached for firing; not a slot.
+#define TIMER_BUCKET_FIRING (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS)
+
+// Ticks reachable from the top level before a timer has to be re-placed.
+#define TIMER_WHEEL_SPAN (1ull << (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS))
+
+//------------------------------------------------------------------------------
+// Bit scans
+
+internal u32 _timer_ffs(u64 bits)
+{
+#if COMPILER_MSVC
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (u32)index;
+#elif COMPILER_GCC || COMPILER_CLANG
+    return (u32)__builtin_ctzll(bits);
+#else
+#    error "Unsupported compiler for bit scans."
+#endif
+}
+
+internal u64 _timer_rotr(u64 bits, u32 count)
+{
+    count &= 63;
+    return count ? (bits >> count) | (bits << (64 - count)) : bits;
+}
+
+//------------------------------------------------------------------------------
+// Slots
+
+internal u64 _timer_tick_of(TimerWheel* wheel, TimePoint time)
+{
+    if (time <= wheel->origin) {
+        return 0;
+    }
+    // Round up so that no timer fires before its deadline.
+    u64 elapsed = time - wheel->origin;
+    return elapsed / wheel->tick + (elapsed % wheel->tick != 0);
+}
+
+internal void _timer_link(TimerWheel* wheel, Timer* timer, u32 bucket)
+{
+    Timer** head = &wheel->slots[bucket];
+    timer->next  = *head;
+    timer->pprev = head;
+    if (*head) {
+        (*head)->pprev = &timer->next;
+    }
+    *head         = timer;
+    timer->bucket = bucket;
+    wheel->occupied[bucket / TIMER_WHEEL_SLOTS] |=
+        1ull << (bucket % TIMER_WHEEL_SLOTS);
+}
+
+internal void _timer_unlink(TimerWheel* wheel, Timer* timer)
+{
+    *timer->pprev = timer->next;
+    if (timer->next) {
+        timer->next->pprev = timer->pprev;
+    }
+    u32 bucket = timer->bucket;
+    if (bucket != TIMER_BUCKET_FIRING && !wheel->slots[bucket]) {
+        wheel->occupied[bucket / TIMER_WHEEL_SLOTS] &=
+            ~(1ull << (bucket % TIMER_WHEEL_SLOTS));
+    }
+}
+
+// Puts the timer in the lowest level whose slots reach its tick, measured from
+// `base`, the earliest tick still to be processed.
+internal void _timer_place(TimerWheel* wheel, Timer* timer, u64 base)
+{
+    u64 expires = MAX(timer->expires, base);
+    u64 delta   = expires - base;
+
+    // Past the top level: park in its furthest slot and re-place from there.
+    if (delta >= TIMER_WHEEL_SPAN) {
+        expires = base + TIMER_WHEEL_SPAN - 1;
+        delta   = TIMER_WHEEL_SPAN - 1;
+    }
+
+    u32 level = 0;
+    while (delta >> (TIMER_WHEEL_SLOT_BITS * (level + 1))) {
+        level++;
+    }
+    u64 slot = (expires >> (TIMER_WHEEL_SLOT_BITS * level)) &
+               (TIMER_WHEEL_SLOTS - 1);
+    _timer_link(wheel, timer, level * TIMER_WHEEL_SLOTS + (u32)slot);
+}
+
+// The first tick after `now` that has a level 0 slot to fire or a higher slot
+// to move down.  Level L is only looked at on multiples of 64^L.
+internal u64 _timer_next_tick(TimerWheel* wheel)
+{
+    u64 next = ~0ull;
+    for (u32 level = 0; level < TIMER_WHEEL_LEVELS; ++level) {
+        u64 occupied = wheel->occupied[level];
+        if (!occupied) {
+            continue;
+        }
+        u32 shift = TIMER_WHEEL_SLOT_BITS * level;
+        u64 first = (wheel->now >> shift) + 1;
+        u64 ahead = _timer_ffs(_timer_rotr(occupied, (u32)first));
+        next      = MIN(next, (first + ahead) << shift);
+    }
+    return next;
+}
+
+internal void _timer_release(TimerWheel* wheel, Timer* timer)
+{
+    timer->generation = 0;
+    pool_free(&wheel->timers, timer);
+    wheel->count--;
+}
+
+// Moves due higher slots down, then fires level 0's slot for `tick`.
+internal usize _timer_process_tick(TimerWheel* wheel, u64 tick)
+{
+    for (u32 level = TIMER_WHEEL_LEVELS - 1; level > 0; --level) {
+        u32 shift = TIMER_WHEEL_SLOT_BITS * level;
+        if (tick & ((1ull << shift) - 1)) {
+            continue;
+        }
+        u32 slot   = (u32)(tick >> shift) & (TIMER_WHEEL_SLOTS - 1);
+        u32 bucket = level * TIMER_WHEEL_SLOTS + slot;
+        Timer* timer = wheel->slots[bucket];
+        wheel->slots[bucket] = NULL;
+        wheel->occupied[level] &= ~(1ull << slot);
+        while (timer) {
+            Timer* next = timer->next;
+            _timer_place(wheel, timer, tick);
+            timer = next;
+        }
+    }
+
+    u32 slot = (u32)tick & (TIMER_WHEEL_SLOTS - 1);
+    Timer* batch = wheel->slots[slot];
+    if (!batch) {
+        return 0;
+    }
+    wheel->slots[slot] = NULL;
+    wheel->occupied[0] &= ~(1ull << slot);
+    wheel->firing = batch;
+    batch->pprev  = &wheel->firing;
+    for (Timer* timer = batch; timer; timer = timer->next) {
+        ASSERT(timer->expires <= tick, "Timer placed in the wrong slot.");
+        timer->bucket = TIMER_BUCKET_FIRING;
+    }
+
+    // Callbacks may cancel timers later in the batch, so pop one at a time.
+    usize fired = 0;
+    while (wheel->firing) {
+        Timer* timer = wheel->firing;
+        _timer_unlink(wheel, timer);
+        TimerFunc func    = timer->func;
+        void*     context = timer->context;
+        _timer_release(wheel, timer);
+        func(context);
+        fired++;
+    }
+    return fired;
+}
+
+//------------------------------------------------------------------------------
+
+void _timer_wheel_init(TimerWheel* wheel, TimerWheelDefaultParams params)
+{
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->tick   = params.tick ? params.tick : time_from_ms(1);
+    wheel->origin = params.start ? params.start : time_now();
+    ASSERT(wheel->tick > 0, "Timer wheel tick is shorter than the clock.");
+    arena_init(&wheel->arena, .reserved_size = GB(1));
+    pool_init_typed(&wheel->timers, &wheel->arena, Timer);
+}
+
+void timer_wheel_done(TimerWheel* wheel) { arena_done(&wheel->arena); }
+
+TimerHandle timer_schedule(TimerWheel* wheel,
+                           TimePoint   deadline,
+                           TimerFunc   func,
+                           void*       context)
+{
+    Timer* timer      = pool_new(&wheel->timers, Timer);
+    timer->expires    = MAX(_timer_tick_of(wheel, deadline), wheel->now + 1);
+    timer->generation = ++wheel->generation;
+    timer->func       = func;
+    timer->context    = context;
+    _timer_place(wheel, timer, wheel->now + 1);
+    wheel->count++;
+    return (TimerHandle){timer, timer->generation};
+}
+
+bool timer_reschedule(TimerWheel* wheel,
+                      TimerHandle handle,
+                      TimePoint   deadline)
+{
+    if (!timer_pending(wheel, handle)) {
+        return false;
+    }
+    Timer* timer = handle.timer;
+    _timer_unlink(wheel, timer);
+    timer->expires = MAX(_timer_tick_of(wheel, deadline), wheel->now + 1);
+    _timer_place(wheel, timer, wheel->now + 1);
+    return true;
+}
+
+bool timer_cancel(TimerWheel* wheel, TimerHandle handle)
+{
+    if (!timer_pending(wheel, handle)) {
+        return false;
+    }
+    _timer_unlink(wheel, handle.timer);
+    _timer_release(wheel, handle.timer);
+    return true;
+}
+
+bool timer_pending(TimerWheel* wheel, TimerHandle handle)
+{
+    UNUSED(wheel);
+    // Freed records keep their memory in the arena, so reading is safe; the
+    // generation is cleared on release and never handed out twice.
+    return handle.timer && handle.timer->generation == handle.generation;
+}
+
+usize timer_wheel_advance(TimerWheel* wheel, TimePoint now)
+{
+    if (now < wheel->origin) {
+        return 0;
+    }
+    u64   target = (now - wheel->origin) / wheel->tick;
+    usize fired  = 0;
+    while (wheel->now < target) {
+        u64 tick = wheel->count ? _timer_next_tick(wheel) : ~0ull;
+        if (tick > target) {
+            wheel->now = target;
+            break;
+        }
+        wheel->now = tick;
+        fired += _timer_process_tick(wheel, tick);
+    }
+    return fired;
+}
+
+TimePoint timer_wheel_next_deadline(TimerWheel* wheel)
+{
+    if (!wheel->count) {
+        return TIMER_NEVER;
+    }
+    u64 tick = _timer_next_tick(wheel);
+    if (tick >= (TIMER_NEVER - wheel->origin) / wheel->tick) {
+        return TIMER_NEVER - 1;
+    }
+    return time_add_duration(wheel->origin, tick * wheel->tick);
+}
+
+int timer_wheel_timeout_ms(TimerWheel* wheel, TimePoint now)
+{
+    TimePoint deadline = timer_wheel_next_deadline(wheel);
+    if (deadline == TIMER_NEVER) {
+        return -1;
+    }
+    if (deadline <= now) {
+        return 0;
+    }
+    u64 ns = time_duration_to_ns(time_elapsed(now, deadline));
+    u64 ms = ns / 1000000 + (ns % 1000000 != 0);
+    return (int)MIN(ms, 0x7fffffffull);
+}
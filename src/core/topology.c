@@ -0,0 +1,322 @@
+//------------------------------------------------------------------------------
+// CPU topology and affinity
+//
+// Copyright (C)2026 Matt Davies, all rights reserved
+//------------------------------------------------------------------------------
+
+#include <core/core.h>
+
+#include <stdio.h>
+
+#if OS_LINUX
+#    include <sched.h>
+#    include <unistd.h>
+#endif // OS_LINUX
+
+global_variable CpuTopology g_topology;
+global_variable bool        g_topology_ready = false;
+global_variable Spinlock    g_topology_lock;
+
+// ARENA_NODE() of the node this thread is pinned within, or 0.
+thread_local global_variable u32 g_thread_pinned_node = 0;
+
+//------------------------------------------------------------------------------
+// sysfs
+
+#if OS_LINUX
+
+internal bool _topology_read(cstr path, char* buffer, usize size)
+{
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+    usize read = fread(buffer, 1, size - 1, file);
+    fclose(file);
+    buffer[read] = 0;
+    return read > 0;
+}
+
+internal bool _topology_read_u32(cstr path, u32* value)
+{
+    char buffer[32];
+    if (!_topology_read(path, buffer, sizeof(buffer))) {
+        return false;
+    }
+    *value = (u32)strtoul(buffer, NULL, 10);
+    return true;
+}
+
+// Parses a list such as "0-3,8,10-11" into ids below TOPOLOGY_MAX_CPUS and
+// returns how many were written.
+internal usize _topology_parse_list(cstr list, u32* ids, usize max)
+{
+    usize count = 0;
+    char* cursor = (char*)list;
+    while (*cursor && *cursor != '\n') {
+        u32 first = (u32)strtoul(cursor, &cursor, 10);
+        u32 last  = first;
+        if (*cursor == '-') {
+            last = (u32)strtoul(cursor + 1, &cursor, 10);
+        }
+        for (u32 id = first; id <= last && id < TOPOLOGY_MAX_CPUS; ++id) {
+            if (count < max) {
+                ids[count++] = id;
+            }
+        }
+        if (*cursor == ',') {
+            cursor++;
+        } else {
+            break;
+        }
+    }
+    return count;
+}
+
+internal void _topology_scan(CpuTopology* topology)
+{
+    char buffer[4096];
+    u32  ids[TOPOLOGY_MAX_CPUS];
+    if (!_topology_read(
+            "/sys/devices/system/cpu/online", buffer, sizeof(buffer))) {
+        return;
+    }
+    usize count = _topology_parse_list(buffer, ids, TOPOLOGY_MAX_CPUS);
+
+    // Keep the CPUs the process may run on (taskset, cgroup cpusets), so that
+    // spreading and pinning never pick one the kernel would refuse.  The main
+    // thread's mask stands for the process, as a pinned thread's is narrower.
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(getpid(), sizeof(allowed), &allowed) == 0) {
+        usize kept = 0;
+        for (usize i = 0; i < count; ++i) {
+            if (CPU_ISSET(ids[i], &allowed)) {
+                ids[kept++] = ids[i];
+            }
+        }
+        count = kept ? kept : count;
+    }
+
+    for (usize i = 0; i < count; ++i) {
+        CpuInfo* cpu = &topology->cpus[i];
+        char     path[128];
+        *cpu = (CpuInfo){.id = ids[i], .core = ids[i]};
+        snprintf(path,
+                 sizeof(path),
+                 "/sys/devices/system/cpu/cpu%u/topology/core_id",
+                 ids[i]);
+        _topology_read_u32(path, &cpu->core);
+        snprintf(path,
+                 sizeof(path),
+                 "/sys/devices/system/cpu/cpu%u/topology/physical_package_id",
+                 ids[i]);
+        _topology_read_u32(path, &cpu->package);
+    }
+    topology->cpu_count = count;
+
+    // Nodes list their CPUs; CPUs on no listed node stay on node 0.
+    u32 nodes[TOPOLOGY_MAX_NODES];
+    if (!_topology_read(
+            "/sys/devices/system/node/online", buffer, sizeof(buffer))) {
+        return;
+    }
+    usize node_count = _topology_parse_list(buffer, nodes, TOPOLOGY_MAX_NODES);
+    for (usize n = 0; n < node_count; ++n) {
+        if (nodes[n] >= TOPOLOGY_MAX_NODES) {
+            continue;
+        }
+        char path[128];
+        snprintf(path,
+                 sizeof(path),
+                 "/sys/devices/system/node/node%u/cpulist",
+                 nodes[n]);
+        if (!_topology_read(path, buffer, sizeof(buffer))) {
+            continue;
+        }
+        usize node_cpus = _topology_parse_list(buffer, ids, TOPOLOGY_MAX_CPUS);
+        for (usize i = 0; i < node_cpus; ++i) {
+            topology->cpu_node[ids[i]] = (u8)nodes[n];
+        }
+    }
+}
+
+#endif // OS_LINUX
+
+//------------------------------------------------------------------------------
+
+// Interleaves nodes and puts the first CPU of every core ahead of its
+// siblings.
+internal void _topology_build_spread(CpuTopology* topology)
+{
+    // Sibling rank of each CPU: how many CPUs before it share its core.
+    u32 rank[TOPOLOGY_MAX_CPUS];
+    u32 max_rank = 0;
+    for (usize i = 0; i < topology->cpu_count; ++i) {
+        CpuInfo* cpu = &topology->cpus[i];
+        rank[i]      = 0;
+        for (usize j = 0; j < i; ++j) {
+            CpuInfo* other = &topology->cpus[j];
+            rank[i] += other->package == cpu->package &&
+                       other->core == cpu->core && other->node == cpu->node;
+        }
+        max_rank = MAX(max_rank, rank[i]);
+    }
+
+    // Each node's CPUs in placement order, then a round robin across nodes.
+    u32   order[TOPOLOGY_MAX_CPUS];
+    usize node_start[TOPOLOGY_MAX_NODES + 1] = {0};
+    for (usize n = 0; n < topology->node_count; ++n) {
+        node_start[n + 1] = node_start[n] + topology->node_cpus[n];
+    }
+    usize filled[TOPOLOGY_MAX_NODES] = {0};
+    for (u32 r = 0; r <= max_rank; ++r) {
+        for (usize i = 0; i < topology->cpu_count; ++i) {
+            if (rank[i] == r) {
+                u32 node = topology->cpus[i].node;
+                order[node_start[node] + filled[node]++] = topology->cpus[i].id;
+            }
+        }
+    }
+
+    usize spread = 0;
+    for (usize round = 0; spread < topology->cpu_count; ++round) {
+        for (usize n = 0; n < topology->node_count; ++n) {
+            if (round < topology->node_cpus[n]) {
+                topology->spread[spread++] = order[node_start[n] + round];
+            }
+        }
+    }
+}
+
+internal void _topology_init(CpuTopology* topology)
+{
+    memset(topology, 0, sizeof(*topology));
+#if OS_LINUX
+    _topology_scan(topology);
+#endif
+
+    // Without sysfs, report every CPU on node 0.
+    if (topology->cpu_count == 0) {
+        topology->cpu_count = MIN(thread_cpu_count(), TOPOLOGY_MAX_CPUS);
+        for (usize i = 0; i < topology->cpu_count; ++i) {
+            topology->cpus[i] = (CpuInfo){.id = (u32)i, .core = (u32)i};
+        }
+    }
+
+    topology->node_count = 1;
+    for (usize i = 0; i < topology->cpu_count; ++i) {
+        CpuInfo* cpu = &topology->cpus[i];
+        cpu->node    = topology->cpu_node[cpu->id];
+        topology->node_cpus[cpu->node]++;
+        topology->node_count = MAX(topology->node_count, cpu->node + 1);
+    }
+
+    _topology_build_spread(topology);
+}
+
+const CpuTopology* cpu_topology(void)
+{
+    if (!atomic_load_bool(&g_topology_ready, MEMORY_ACQUIRE)) {
+        spinlock_lock(&g_topology_lock);
+        if (!g_topology_ready) {
+            _topology_init(&g_topology);
+            atomic_store_bool(&g_topology_ready, true, MEMORY_RELEASE);
+        }
+        spinlock_unlock(&g_topology_lock);
+    }
+    return &g_topology;
+}
+
+u32 cpu_spread(usize index)
+{
+    const CpuTopology* topology = cpu_topology();
+    return topology->spread[index % topology->cpu_count];
+}
+
+//------------------------------------------------------------------------------
+// Affinity
+
+#if OS_LINUX
+
+internal bool _thread_set_affinity(const u32* cpus, usize count)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (usize i = 0; i < count; ++i) {
+        if (cpus[i] < CPU_SETSIZE) {
+            CPU_SET(cpus[i], &set);
+        }
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+u32 thread_current_cpu(void)
+{
+    int cpu = sched_getcpu();
+    return cpu >= 0 ? (u32)cpu : 0;
+}
+
+#elif OS_WINDOWS
+
+internal bool _thread_set_affinity(const u32* cpus, usize count)
+{
+    DWORD_PTR mask = 0;
+    for (usize i = 0; i < count; ++i) {
+        if (cpus[i] < sizeof(mask) * 8) {
+            mask |= (DWORD_PTR)1 << cpus[i];
+        }
+    }
+    return mask && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+}
+
+u32 thread_current_cpu(void) { return (u32)GetCurrentProcessorNumber(); }
+
+#else
+
+internal bool _thread_set_affinity(const u32* cpus, usize count)
+{
+    UNUSED(cpus);
+    UNUSED(count);
+    return false;
+}
+
+u32 thread_current_cpu(void) { return 0; }
+
+#endif // OS_LINUX
+
+bool thread_pin_cpu(u32 cpu)
+{
+    // Read the topology first in case this thread is the one it looks at.
+    const CpuTopology* topology = cpu_topology();
+    if (cpu >= TOPOLOGY_MAX_CPUS || !_thread_set_affinity(&cpu, 1)) {
+        return false;
+    }
+    g_thread_pinned_node = ARENA_NODE(topology->cpu_node[cpu]);
+    return true;
+}
+
+bool thread_pin_node(u32 node)
+{
+    const CpuTopology* topology = cpu_topology();
+    u32                cpus[TOPOLOGY_MAX_CPUS];
+    usize              count = 0;
+    for (usize i = 0; i < topology->cpu_count; ++i) {
+        if (topology->cpus[i].node == node) {
+            cpus[count++] = topology->cpus[i].id;
+        }
+    }
+    if (count == 0 || !_thread_set_affinity(cpus, count)) {
+        return false;
+    }
+    g_thread_pinned_node = ARENA_NODE(node);
+    return true;
+}
+
+u32 thread_current_node(void)
+{
+    u32 cpu = thread_current_cpu();
+    return cpu < TOPOLOGY_MAX_CPUS ? cpu_topology()->cpu_node[cpu] : 0;
+}
+
+u32 thread_pinned_node(void) { return g_thread_pinned_node; }
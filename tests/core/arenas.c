@@ -3,6 +3,26 @@
 #include <core/core.h>
 #include <test.h>
 
+#if OS_POSIX
+#    include <sys/mman.h>
+
+// Number of system pages in the range that are backed by memory.
+internal usize resident_pages(void* start, usize size)
+{
+    usize page  = (usize)sysconf(_SC_PAGESIZE);
+    usize count = ALIGN_UP(size, page) / page;
+    u8*   pages = KORE_ALLOC(count);
+    usize total = 0;
+    if (mincore(start, size, (void*)pages) == 0) {
+        for (usize i = 0; i < count; ++i) {
+            total += pages[i] & 1;
+        }
+    }
+    KORE_FREE(pages);
+    return total;
+}
+#endif // OS_POSIX
+
 TEST_CASE(arena, simple)
 {
     Arena arena;
@@ -61,3 +81,376 @@ TEST_CASE(arena, session_tracks_count_and_undoes)
 
     arena_done(&arena);
 }
+
+#define CONCURRENT_THREADS 4
+#define CONCURRENT_ALLOCS 2000
+
+typedef struct {
+    Arena* arena;
+    u8     id;
+    u8*    blocks[CONCURRENT_ALLOCS];
+} ConcurrentArenaWorker;
+
+internal void concurrent_arena_worker(void* context)
+{
+    ConcurrentArenaWorker* worker = context;
+    for (usize i = 0; i < CONCURRENT_ALLOCS; ++i) {
+        u8* block = arena_alloc_align(worker->arena, 24, 8);
+        memset(block, worker->id, 24);
+        worker->blocks[i] = block;
+    }
+}
+
+TEST_CASE(arena, concurrent_allocations_do_not_overlap)
+{
+    Arena arena;
+    arena_init(
+        &arena, .reserved_size = MB(16), .grow_rate = 1, .concurrent = true);
+
+    ConcurrentArenaWorker workers[CONCURRENT_THREADS];
+    Thread                threads[CONCURRENT_THREADS];
+    for (int i = 0; i < CONCURRENT_THREADS; ++i) {
+        workers[i].arena = &arena;
+        workers[i].id    = (u8)(i + 1);
+        thread_create(&threads[i], concurrent_arena_worker, &workers[i]);
+    }
+    for (int i = 0; i < CONCURRENT_THREADS; ++i) {
+        thread_join(&threads[i]);
+    }
+
+    usize bad_blocks = 0;
+    for (int i = 0; i < CONCURRENT_THREADS; ++i) {
+        for (usize j = 0; j < CONCURRENT_ALLOCS; ++j) {
+            u8* block = workers[i].blocks[j];
+            if (((usize)block & 7) != 0) {
+                bad_blocks++;
+                continue;
+            }
+            for (usize k = 0; k < 24; ++k) {
+                if (block[k] != workers[i].id) {
+                    bad_blocks++;
+                    break;
+                }
+            }
+        }
+    }
+
+    TEST_ASSERT_EQ(bad_blocks, 0);
+    TEST_ASSERT_GE(arena_store(&arena),
+                   CONCURRENT_THREADS * CONCURRENT_ALLOCS * 24);
+    TEST_ASSERT_GE(arena.committed_size, arena_store(&arena));
+
+    arena_reset(&arena);
+    TEST_ASSERT_EQ(arena_store(&arena), 0);
+
+    arena_done(&arena);
+}
+
+TEST_CASE(arena, scratch_avoids_conflicts_and_restores)
+{
+    ArenaScratch outer = scratch_begin();
+    TEST_ASSERT_NOT_NULL(outer.arena);
+
+    u8* outer_data = arena_alloc(outer.arena, 32);
+    memset(outer_data, 0xaa, 32);
+
+    // A callee allocating into the outer arena must get a different scratch.
+    ArenaScratch inner = scratch_begin(outer.arena);
+    TEST_ASSERT(inner.arena != outer.arena);
+
+    u8* inner_data = arena_alloc(inner.arena, 64);
+    memset(inner_data, 0x55, 64);
+    TEST_ASSERT_EQ(outer_data[31], 0xaa);
+
+    scratch_end(inner);
+    TEST_ASSERT_EQ(arena_store(inner.arena), inner.mark);
+
+    // Without conflicts the first scratch arena is reused.
+    ArenaScratch again = scratch_begin();
+    TEST_ASSERT_EQ(again.arena, outer.arena);
+    scratch_end(again);
+
+    scratch_end(outer);
+    TEST_ASSERT_EQ(arena_store(outer.arena), outer.mark);
+
+    scratch_done();
+}
+
+TEST_CASE(arena, decommit_after_rewinds_keeps_warm_pages)
+{
+    Arena arena;
+    arena_init(&arena,
+               .reserved_size       = MB(1),
+               .grow_rate           = 1,
+               .decommit_keep_pages = 2,
+               .decommit_after      = 2);
+    usize page = arena.alloc_granularity;
+
+    // A spike followed by a small reset: the spike is still in the window.
+    memset(arena_alloc(&arena, page * 8), 1, page * 8);
+    arena_reset(&arena);
+    arena_alloc(&arena, 16);
+    arena_reset(&arena);
+
+    ArenaStats stats = arena_stats(&arena);
+    TEST_ASSERT_EQ(stats.used, 0);
+    TEST_ASSERT_EQ(stats.peak, page * 8);
+    TEST_ASSERT_EQ(stats.committed, page * 8);
+    TEST_ASSERT_EQ(stats.decommit_count, 0);
+
+    // A full window of small usage returns the spike down to the warm pages.
+    arena_alloc(&arena, 16);
+    arena_reset(&arena);
+    arena_alloc(&arena, 16);
+    arena_reset(&arena);
+
+    stats = arena_stats(&arena);
+    TEST_ASSERT_EQ(stats.committed, page * 2);
+    TEST_ASSERT_EQ(stats.decommit_count, 1);
+    TEST_ASSERT_EQ(stats.decommitted, page * 6);
+
+    // Decommitted pages are committed again on demand.
+    u8* data = arena_alloc(&arena, page * 4);
+    memset(data, 2, page * 4);
+    TEST_ASSERT_EQ(data[page * 4 - 1], 2);
+    TEST_ASSERT_EQ(arena_stats(&arena).committed, page * 4);
+
+    arena_done(&arena);
+}
+
+TEST_CASE(arena, registry_tracks_named_arenas)
+{
+    usize before = arena_registry_count();
+
+    Arena named;
+    arena_init(&named, .reserved_size = MB(1), .grow_rate = 1, .name = "parse");
+    Arena anonymous;
+    arena_init(&anonymous, .reserved_size = MB(1), .grow_rate = 1);
+    TEST_ASSERT_EQ(arena_registry_count(), before + 1);
+
+    arena_alloc(&named, named.alloc_granularity * 3);
+    ArenaStats stats = arena_stats(&named);
+    TEST_ASSERT_EQ(stats.commit_count, 2);
+    TEST_ASSERT_EQ(stats.peak, named.alloc_granularity * 3);
+
+    u8* json = arena_registry_json(&anonymous);
+    TEST_ASSERT_NOT_NULL(strstr((char*)json, "{\"name\":\"parse\""));
+    TEST_ASSERT_NOT_NULL(strstr((char*)json, "\"commit_count\":2"));
+    TEST_ASSERT_EQ(json[strlen((char*)json) - 1], ']');
+
+    arena_done(&named);
+    TEST_ASSERT_EQ(arena_registry_count(), before);
+    arena_done(&anonymous);
+}
+
+TEST_CASE(arena, chained_blocks_grow_and_release)
+{
+    Arena arena;
+    arena_init(
+        &arena, .reserved_size = MB(1), .grow_rate = 1, .chained = true);
+    usize page = arena.alloc_granularity;
+
+    u8* first = arena_alloc(&arena, page / 2);
+    memset(first, 1, page / 2);
+    u64 mark = arena_store(&arena);
+
+    // These do not fit in the first block, so new blocks are chained.
+    u8* second = arena_alloc(&arena, page - 64);
+    memset(second, 2, page - 64);
+    u8* large = arena_alloc_align(&arena, page * 4, 16);
+    memset(large, 3, page * 4);
+    TEST_ASSERT_EQ(((usize)large & 15), 0);
+    TEST_ASSERT_EQ(first[page / 2 - 1], 1);
+    TEST_ASSERT_EQ(second[0], 2);
+
+    ArenaStats stats = arena_stats(&arena);
+    TEST_ASSERT_EQ(stats.commit_count, 3);
+    TEST_ASSERT_GE(stats.committed, page * 6);
+
+    // Restoring releases the later blocks, keeping one spare for reuse.
+    arena_restore(&arena, mark);
+    TEST_ASSERT_EQ(arena_store(&arena), mark);
+    TEST_ASSERT_EQ(arena.memory, first);
+    stats = arena_stats(&arena);
+    TEST_ASSERT_EQ(stats.decommit_count, 1);
+
+    // Sessions and builders follow the arena into a new block when empty.
+    arena_alloc(&arena, page / 2 - 32);
+    StringBuilder sb;
+    sb_init(&sb, &arena);
+    sb_append_cstr(&sb, "a string that crosses into the next block");
+    sb_append_null(&sb);
+    TEST_ASSERT_STR_EQ((char*)sb.data,
+                       "a string that crosses into the next block");
+    TEST_ASSERT_EQ(arena_stats(&arena).commit_count, 3);
+
+    arena_reset(&arena);
+    TEST_ASSERT_EQ(arena.memory, first);
+    TEST_ASSERT_EQ(arena_store(&arena), 0);
+
+    // Padding that runs off a block is not mapped on its own: the new block
+    // starts aligned and is sized for the allocation.
+    arena_alloc(&arena, arena.committed_size - 8);
+    usize commits = arena_stats(&arena).commit_count;
+    u8*   aligned = arena_alloc_align(&arena, page * 8, 64);
+    TEST_ASSERT_EQ(((usize)aligned & 63), 0);
+    TEST_ASSERT_EQ(aligned, arena.memory);
+    TEST_ASSERT_EQ(arena_stats(&arena).commit_count, commits + 1);
+
+    // A spare too small for the next block is unmapped, and counted.
+    arena_reset(&arena);
+    arena_alloc(&arena, arena.committed_size - 8);
+    stats = arena_stats(&arena);
+    arena_alloc(&arena, page * 16);
+    TEST_ASSERT_EQ(arena_stats(&arena).decommit_count,
+                   stats.decommit_count + 1);
+    TEST_ASSERT_GE(arena_stats(&arena).decommitted,
+                   stats.decommitted + page * 8);
+
+    arena_done(&arena);
+}
+
+TEST_CASE(arena, prefault_and_huge_page_modes_take_effect)
+{
+    ArenaPrefault prefaults[] = {
+        ARENA_PREFAULT_NONE,
+        ARENA_PREFAULT_TOUCH,
+        ARENA_PREFAULT_POPULATE,
+    };
+    ArenaPages pages[] = {
+        ARENA_PAGES_NORMAL,
+        ARENA_PAGES_TRANSPARENT,
+        ARENA_PAGES_HUGETLB,
+    };
+
+    for (usize i = 0; i < 3 * 3 * 2; ++i) {
+        ArenaPrefault prefault = prefaults[i % 3];
+        ArenaPages    wanted   = pages[i / 3 % 3];
+        bool          chained  = i / 9 != 0;
+
+        Arena arena;
+        arena_init(&arena,
+                   .reserved_size = MB(64),
+                   .prefault      = prefault,
+                   .pages         = wanted,
+                   .chained       = chained);
+        usize unit      = arena.alloc_granularity * arena.grow_rate;
+        usize committed = arena.committed_size - arena.block_base;
+        TEST_ASSERT_GE(arena_stats(&arena).committed, unit);
+
+#if OS_POSIX
+        // Explicit huge pages are granted whole, or fall back to transparent
+        // ones, which are committed in aligned huge pages.
+        if (wanted == ARENA_PAGES_NORMAL) {
+            TEST_ASSERT_EQ(arena.pages, ARENA_PAGES_NORMAL);
+            TEST_ASSERT_EQ(arena.grow_rate, ARENA_DEFAULT_NUM_PAGES_GROW);
+        } else if (arena.pages == ARENA_PAGES_HUGETLB) {
+            TEST_ASSERT(!chained);
+            TEST_ASSERT_EQ(arena.alloc_granularity, ARENA_HUGE_PAGE_SIZE);
+            TEST_ASSERT_EQ(arena.grow_rate, 1);
+        } else {
+            TEST_ASSERT_EQ(arena.pages, ARENA_PAGES_TRANSPARENT);
+            TEST_ASSERT_EQ(unit % ARENA_HUGE_PAGE_SIZE, 0);
+            TEST_ASSERT_EQ((usize)arena.memory % ARENA_HUGE_PAGE_SIZE, 0);
+        }
+
+        // Prefaulting makes the first commit resident before any allocation.
+        // A chained block's header is written at its end, so only an
+        // unchained arena is untouched without it.
+        usize page     = (usize)sysconf(_SC_PAGESIZE);
+        usize resident = resident_pages(arena.memory, committed);
+        if (prefault != ARENA_PREFAULT_NONE) {
+            TEST_ASSERT_EQ(resident, ALIGN_UP(committed, page) / page);
+        } else if (!chained) {
+            TEST_ASSERT_EQ(resident, 0);
+        }
+#endif // OS_POSIX
+
+        u8* data = arena_alloc(&arena, MB(3));
+        memset(data, 7, MB(3));
+        TEST_ASSERT_EQ(data[MB(3) - 1], 7);
+        TEST_ASSERT_GE(arena_stats(&arena).committed, MB(3));
+
+        arena_done(&arena);
+    }
+}
+
+TEST_CASE(arena, realloc_extends_last_allocation_in_place)
+{
+    Arena arena;
+    arena_init(&arena, .reserved_size = MB(1), .grow_rate = 1);
+    usize page = arena.alloc_granularity;
+
+    u8* buffer = arena_realloc(&arena, NULL, 0, 16);
+    memset(buffer, 1, 16);
+
+    // Growing the top allocation, even across a commit, keeps the pointer.
+    u8* grown = arena_realloc(&arena, buffer, 16, page * 2);
+    TEST_ASSERT_EQ(grown, buffer);
+    TEST_ASSERT_EQ(arena_store(&arena), page * 2);
+    TEST_ASSERT_EQ(grown[15], 1);
+
+    TEST_ASSERT(arena_shrink_last(&arena, grown, page * 2, 32));
+    TEST_ASSERT_EQ(arena_store(&arena), 32);
+
+    // Once something else is allocated the buffer is no longer on top.
+    u8* other = arena_alloc(&arena, 8);
+    TEST_ASSERT(!arena_shrink_last(&arena, grown, 32, 16));
+    TEST_ASSERT_EQ(arena_realloc(&arena, grown, 32, 16), grown);
+
+    u8* moved = arena_realloc(&arena, grown, 32, 64);
+    TEST_ASSERT(moved > other);
+    TEST_ASSERT_EQ(((usize)moved % alignof(max_align_t)), 0);
+    TEST_ASSERT_MEM_EQ(moved, buffer, 16);
+
+    arena_done(&arena);
+}
+
+DEF_REF(u64);
+DEF_REF(RefNode);
+
+typedef struct {
+    u32            value;
+    Ref32(RefNode) next; // No node lives at offset 0, so it ends the list
+} RefNode;
+
+TEST_CASE(arena, references_resolve_against_base)
+{
+    Arena arena;
+    arena_init(&arena, .reserved_size = MB(1));
+
+    arena_alloc(&arena, 100);
+    u64* value = arena_alloc_align(&arena, sizeof(u64), 8);
+    *value     = 0x1234;
+
+    Ref32(u64) small = arena_ref32(&arena, u64, value);
+    Ref64(u64) large = arena_ref64(&arena, u64, value);
+    TEST_ASSERT_EQ(sizeof(small), sizeof(u32));
+    TEST_ASSERT_EQ(sizeof(large), sizeof(u64));
+    TEST_ASSERT_EQ(small.offset, 104);
+    TEST_ASSERT_EQ(large.offset, 104);
+    TEST_ASSERT_EQ(arena_ref_get(&arena, u64, small), value);
+    TEST_ASSERT_EQ(*ref_get(arena.memory, u64, large), 0x1234);
+
+    // A list linked by references walks the same from the arena or its base.
+    RefNode* head = NULL;
+    for (u32 i = 1; i <= 3; ++i) {
+        RefNode* node = arena_alloc_align(&arena, sizeof(RefNode), 4);
+        node->value   = i;
+        node->next    = (Ref32(RefNode)){0};
+        if (head) {
+            node->next = arena_ref32(&arena, RefNode, head);
+        }
+        head = node;
+    }
+    u32 sum = 0;
+    for (RefNode* node = head; node;) {
+        sum += node->value;
+        node = node->next.offset
+                   ? arena_ref_get(&arena, RefNode, node->next)
+                   : NULL;
+    }
+    TEST_ASSERT_EQ(sum, 6);
+
+    arena_done(&arena);
+}
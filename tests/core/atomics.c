@@ -0,0 +1,87 @@
+//> use: core
+
+#include <core/core.h>
+#include <test.h>
+
+#define ATOMIC_THREADS 4
+#define ATOMIC_ITERATIONS 50000
+
+TEST_CASE(atomic, operations_return_previous_values)
+{
+    u32 word = 5;
+    TEST_ASSERT_EQ(atomic_fetch_add_u32(&word, 3, MEMORY_RELAXED), 5);
+    TEST_ASSERT_EQ(atomic_fetch_sub_u32(&word, 1, MEMORY_ACQ_REL), 8);
+    TEST_ASSERT_EQ(atomic_exchange_u32(&word, 20, MEMORY_SEQ_CST), 7);
+    TEST_ASSERT_EQ(atomic_load_u32(&word, MEMORY_ACQUIRE), 20);
+
+    // A failed CAS reports the value it found.
+    u32 expected = 1;
+    TEST_ASSERT(!atomic_cas_u32(&word, &expected, 2, MEMORY_ACQ_REL));
+    TEST_ASSERT_EQ(expected, 20);
+    TEST_ASSERT(atomic_cas_u32(&word, &expected, 2, MEMORY_RELEASE));
+    TEST_ASSERT_EQ(word, 2);
+
+    i64 signed_value = 0;
+    atomic_fetch_sub_i64(&signed_value, 2, MEMORY_RELAXED);
+    TEST_ASSERT_EQ(atomic_load_i64(&signed_value, MEMORY_RELAXED), -2);
+
+    int   target  = 0;
+    void* pointer = NULL;
+    void* none    = NULL;
+    TEST_ASSERT(atomic_cas_ptr(&pointer, &none, &target, MEMORY_SEQ_CST));
+    TEST_ASSERT(atomic_load_ptr(&pointer, MEMORY_ACQUIRE) == &target);
+}
+
+TEST_CASE(atomic, cache_line_layout)
+{
+    TEST_ASSERT_EQ(sizeof(CounterShard), CACHE_LINE);
+    TEST_ASSERT_EQ(alignof(ShardedCounter), CACHE_LINE);
+    TEST_ASSERT_GE(offsetof(JobDeque, bottom) - offsetof(JobDeque, top),
+                   CACHE_LINE);
+    TEST_ASSERT_GE(offsetof(SpscQueue, tail) - offsetof(SpscQueue, head),
+                   CACHE_LINE);
+    TEST_ASSERT_GE(offsetof(SpscQueue, buffer) - offsetof(SpscQueue, tail),
+                   CACHE_LINE);
+    TEST_ASSERT_GE(
+        offsetof(MpmcQueue, dequeue_pos) - offsetof(MpmcQueue, enqueue_pos),
+        CACHE_LINE);
+}
+
+//------------------------------------------------------------------------------
+// Sharded counters
+
+internal void sharded_counter_worker(void* context)
+{
+    ShardedCounter* counter = context;
+    for (usize i = 0; i < ATOMIC_ITERATIONS; ++i) {
+        sharded_counter_add(counter, 2);
+    }
+}
+
+TEST_CASE(atomic, sharded_counter_sums_every_thread)
+{
+    local_persist ShardedCounter counter;
+    sharded_counter_reset(&counter);
+
+    Thread threads[ATOMIC_THREADS];
+    for (usize i = 0; i < ATOMIC_THREADS; ++i) {
+        thread_create(&threads[i], sharded_counter_worker, &counter);
+    }
+    sharded_counter_add(&counter, 1);
+    for (usize i = 0; i < ATOMIC_THREADS; ++i) {
+        thread_join(&threads[i]);
+    }
+
+    TEST_ASSERT_EQ(sharded_counter_read(&counter),
+                   2 * ATOMIC_THREADS * ATOMIC_ITERATIONS + 1);
+
+    // Threads created one after another land on different shards.
+    usize used = 0;
+    for (usize i = 0; i < SHARDED_COUNTER_SHARDS; ++i) {
+        used += counter.shards[i].value != 0;
+    }
+    TEST_ASSERT_GT(used, 1);
+
+    sharded_counter_reset(&counter);
+    TEST_ASSERT_EQ(sharded_counter_read(&counter), 0);
+}
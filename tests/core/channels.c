@@ -0,0 +1,150 @@
+//> use: core
+
+#include <core/core.h>
+#include <test.h>
+
+#define CHANNEL_ITEMS 100000
+
+//------------------------------------------------------------------------------
+// Pipeline
+
+typedef struct {
+    Channel* channel;
+    u64      first; // First value to send
+    u64      count; // Values to send
+} ChannelProducer;
+
+internal void channel_producer(void* context)
+{
+    ChannelProducer* producer = context;
+    u64              batch[32];
+    for (u64 sent = 0; sent < producer->count;) {
+        usize count = (usize)MIN(32, producer->count - sent);
+        for (usize i = 0; i < count; ++i) {
+            batch[i] = producer->first + sent + i;
+        }
+        sent += channel_send_batch(producer->channel, batch, count);
+    }
+    channel_close(producer->channel);
+}
+
+TEST_CASE(channel, batches_arrive_in_order_then_close)
+{
+    Arena arena;
+    arena_init(&arena, .reserved_size = MB(1));
+
+    Channel channel;
+    channel_init(&channel, &arena, 100, sizeof(u64));
+
+    ChannelProducer producer = {&channel, 0, CHANNEL_ITEMS};
+    Thread          thread;
+    thread_create(&thread, channel_producer, &producer);
+
+    u64   expected     = 0;
+    usize out_of_order = 0;
+    u64   batch[48];
+    usize count;
+    while ((count = channel_recv_batch(&channel, batch, 48)) > 0) {
+        for (usize i = 0; i < count; ++i) {
+            out_of_order += batch[i] != expected++;
+        }
+    }
+    thread_join(&thread);
+
+    TEST_ASSERT_EQ(expected, CHANNEL_ITEMS);
+    TEST_ASSERT_EQ(out_of_order, 0);
+
+    u64 value = 0;
+    TEST_ASSERT(!channel_recv(&channel, &value));
+    TEST_ASSERT(!channel_send(&channel, &value));
+
+    channel_done(&channel);
+    arena_done(&arena);
+}
+
+TEST_CASE(channel, try_and_timeout_report_why_they_failed)
+{
+    Arena arena;
+    arena_init(&arena, .reserved_size = MB(1));
+
+    Channel channel;
+    channel_init(&channel, &arena, 2, sizeof(u32));
+
+    u32 value = 7;
+    TEST_ASSERT(channel_try_send(&channel, &value));
+    TEST_ASSERT(channel_try_send(&channel, &value));
+    TEST_ASSERT(!channel_try_send(&channel, &value));
+
+    TEST_ASSERT(channel_try_recv(&channel, &value));
+    TEST_ASSERT_EQ(channel_recv_timeout(&channel, &value, time_from_ms(1)),
+                   CHANNEL_OK);
+    TEST_ASSERT(!channel_try_recv(&channel, &value));
+
+    // An empty channel waits out the timeout.
+    TimeDuration timeout = time_from_ms(20);
+    TimePoint    start   = time_now();
+    TEST_ASSERT_EQ(channel_recv_timeout(&channel, &value, timeout),
+                   CHANNEL_TIMEOUT);
+    TEST_ASSERT_GE(time_elapsed(start, time_now()), timeout);
+
+    // Closing keeps buffered elements available.
+    value = 9;
+    TEST_ASSERT(channel_send(&channel, &value));
+    channel_close(&channel);
+    value = 0;
+    TEST_ASSERT_EQ(channel_recv_timeout(&channel, &value, timeout),
+                   CHANNEL_OK);
+    TEST_ASSERT_EQ(value, 9);
+    TEST_ASSERT_EQ(channel_recv_timeout(&channel, &value, timeout),
+                   CHANNEL_CLOSED);
+
+    channel_done(&channel);
+    arena_done(&arena);
+}
+
+//------------------------------------------------------------------------------
+// Select
+
+TEST_CASE(channel, select_receives_from_every_channel)
+{
+    Arena arena;
+    arena_init(&arena, .reserved_size = MB(1));
+
+    Channel channels[3];
+    for (usize i = 0; i < 3; ++i) {
+        channel_init(&channels[i], &arena, 16, sizeof(u64));
+    }
+    Channel* selected[3] = {&channels[0], &channels[1], &channels[2]};
+
+    // Nothing has been sent yet.
+    u64   value = 0;
+    usize index = 0;
+    TEST_ASSERT_EQ(channel_select(selected, 3, &value, &index, 0),
+                   CHANNEL_TIMEOUT);
+
+    ChannelProducer producers[3];
+    Thread          threads[3];
+    for (usize i = 0; i < 3; ++i) {
+        producers[i] = (ChannelProducer){
+            &channels[i], i * CHANNEL_ITEMS, CHANNEL_ITEMS / 10};
+        thread_create(&threads[i], channel_producer, &producers[i]);
+    }
+
+    u64   received[3] = {0};
+    usize misrouted   = 0;
+    while (channel_select(selected, 3, &value, &index, CHANNEL_FOREVER) ==
+           CHANNEL_OK) {
+        misrouted += value / CHANNEL_ITEMS != index;
+        received[index]++;
+    }
+    for (usize i = 0; i < 3; ++i) {
+        thread_join(&threads[i]);
+    }
+
+    TEST_ASSERT_EQ(misrouted, 0);
+    for (usize i = 0; i < 3; ++i) {
+        TEST_ASSERT_EQ(received[i], CHANNEL_ITEMS / 10);
+        channel_done(&channels[i]);
+    }
+    arena_done(&arena);
+}
@@ -0,0 +1,101 @@
+//> use: core
+
+#include <core/core.h>
+#include <test.h>
+
+#include <stdio.h>
+
+typedef struct {
+    u32     value;
+    SelfPtr next;
+} SnapshotNode;
+
+DEF_REF(SnapshotNode);
+
+typedef struct {
+    u32                 count;
+    Ref32(SnapshotNode) first;
+} SnapshotRoot;
+
+#if OS_POSIX
+
+TEST_CASE(data, arena_snapshot_round_trips_without_fixups)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/kore_snapshot_%d.bin", (int)getpid());
+
+    Arena arena;
+    arena_init(&arena, .reserved_size = MB(1));
+
+    SnapshotRoot* root = arena_alloc_align(&arena, sizeof(SnapshotRoot), 8);
+    root->count        = 3;
+
+    SnapshotNode* prev = NULL;
+    for (u32 i = 0; i < root->count; ++i) {
+        SnapshotNode* node = arena_alloc_align(&arena, sizeof(SnapshotNode), 8);
+        node->value        = (i + 1) * 10;
+        self_ptr_set(&node->next, (SnapshotNode*)NULL);
+        if (prev) {
+            self_ptr_set(&prev->next, node);
+        } else {
+            root->first = arena_ref32(&arena, SnapshotNode, node);
+        }
+        prev = node;
+    }
+
+    TEST_ASSERT(arena_snapshot_save(&arena, path));
+    usize used = (usize)arena_store(&arena);
+    arena_done(&arena);
+
+    ArenaSnapshot snapshot;
+    TEST_ASSERT(arena_snapshot_load(&snapshot, path, false));
+    TEST_ASSERT_EQ(snapshot.size, used);
+
+    SnapshotRoot* loaded = (SnapshotRoot*)snapshot.memory;
+    SnapshotNode* node   = ref_get(snapshot.memory, SnapshotNode,
+                                   loaded->first);
+    u32           sum    = 0;
+    u32           count  = 0;
+    while (node) {
+        sum += node->value;
+        count++;
+        node = self_ptr_get(SnapshotNode, &node->next);
+    }
+    TEST_ASSERT_EQ(count, 3);
+    TEST_ASSERT_EQ(sum, 60);
+    arena_snapshot_unload(&snapshot);
+
+    // Copy-on-write mappings can be modified without touching the file.
+    TEST_ASSERT(arena_snapshot_load(&snapshot, path, true));
+    ((SnapshotRoot*)snapshot.memory)->count = 99;
+    arena_snapshot_unload(&snapshot);
+
+    TEST_ASSERT(arena_snapshot_load(&snapshot, path, false));
+    TEST_ASSERT_EQ(((SnapshotRoot*)snapshot.memory)->count, 3);
+    arena_snapshot_unload(&snapshot);
+
+    remove(path);
+}
+
+TEST_CASE(data, load_rejects_missing_and_invalid_files)
+{
+    ArenaSnapshot snapshot;
+    TEST_ASSERT(!arena_snapshot_load(&snapshot, "/nonexistent/kore", false));
+
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/kore_invalid_%d.bin", (int)getpid());
+    FILE* file = fopen(path, "wb");
+    fputs("not a snapshot", file);
+    fclose(file);
+
+    Data data;
+    TEST_ASSERT(data_load(path, &data));
+    TEST_ASSERT_EQ(data.size, 14);
+    TEST_ASSERT_EQ(data.data[0], 'n');
+    data_unload(&data);
+
+    TEST_ASSERT(!arena_snapshot_load(&snapshot, path, false));
+    remove(path);
+}
+
+#endif // OS_POSIX
@@ -0,0 +1,168 @@
+//> use: core
+
+#include <core/core.h>
+#include <test.h>
+
+#define EPOCH_READERS 3
+#define EPOCH_WRITES 20000
+
+//------------------------------------------------------------------------------
+// Deferral
+
+internal void count_free(void* context, void* ptr)
+{
+    UNUSED(ptr);
+    ++*(usize*)context;
+}
+
+TEST_CASE(epoch, readers_hold_back_reclamation)
+{
+    EpochDomain domain;
+    epoch_domain_init(&domain);
+
+    // Two records on one thread stand in for two threads.
+    EpochThread* reader = epoch_register(&domain);
+    EpochThread* writer = epoch_register(&domain);
+    TEST_ASSERT(reader != writer);
+
+    usize freed  = 0;
+    int   object = 0;
+    epoch_enter(reader);
+    epoch_enter(reader); // Nested
+    epoch_retire(writer, &object, count_free, &freed);
+    TEST_ASSERT_EQ(epoch_pending(writer), 1);
+
+    for (usize i = 0; i < 4; ++i) {
+        epoch_collect(writer);
+    }
+    epoch_exit(reader);
+    epoch_collect(writer);
+    TEST_ASSERT_EQ(freed, 0);
+
+    epoch_exit(reader);
+    epoch_collect(writer);
+    epoch_collect(writer);
+    TEST_ASSERT_EQ(freed, 1);
+    TEST_ASSERT_EQ(epoch_pending(writer), 0);
+
+    // Unregistering waits for everything the thread retired.
+    for (usize i = 0; i < 100; ++i) {
+        epoch_retire(writer, &object, count_free, &freed);
+    }
+    epoch_unregister(writer);
+    TEST_ASSERT_EQ(freed, 101);
+
+    // Records are reused.
+    TEST_ASSERT(epoch_register(&domain) == writer);
+    epoch_unregister(writer);
+    epoch_unregister(reader);
+    epoch_domain_done(&domain);
+}
+
+//------------------------------------------------------------------------------
+// Concurrent readers
+
+typedef struct {
+    u64 value;
+    u64 check; // Always value * 3 until the node is freed
+} EpochNode;
+
+typedef struct {
+    EpochDomain* domain;
+    EpochNode*   current; // Replaced by the writer, read by the readers
+    bool         done;
+    usize        bad_reads[EPOCH_READERS];
+    usize        reads[EPOCH_READERS];
+} EpochShared;
+
+typedef struct {
+    EpochShared* shared;
+    usize        index;
+} EpochReader;
+
+// Poisons the node before returning it to the pool, so a reader that can still
+// see it notices.
+internal void poison_free(void* context, void* ptr)
+{
+    EpochNode* node = ptr;
+    node->check     = 0;
+    pool_free(context, node);
+}
+
+internal void read_nodes(void* context)
+{
+    EpochReader* reader = context;
+    EpochShared* shared = reader->shared;
+    EpochThread* me     = epoch_register(shared->domain);
+
+    usize bad = 0, reads = 0;
+    while (!atomic_load_bool(&shared->done, MEMORY_ACQUIRE)) {
+        epoch_enter(me);
+        EpochNode* node =
+            atomic_load_ptr((void**)&shared->current, MEMORY_ACQUIRE);
+        for (usize i = 0; i < 16; ++i) {
+            bad += node->check != node->value * 3;
+        }
+        epoch_exit(me);
+        reads++;
+    }
+
+    epoch_unregister(me);
+    shared->bad_reads[reader->index] = bad;
+    shared->reads[reader->index]     = reads;
+}
+
+TEST_CASE(epoch, readers_never_see_freed_nodes)
+{
+    EpochDomain domain;
+    epoch_domain_init(&domain, .collect_threshold = 16);
+
+    Arena arena;
+    arena_init(&arena, .reserved_size = MB(16));
+    Pool pool;
+    pool_init_typed(&pool, &arena, EpochNode);
+
+    EpochShared shared = {.domain = &domain};
+    shared.current     = pool_new(&pool, EpochNode);
+    *shared.current    = (EpochNode){0, 0};
+
+    EpochReader readers[EPOCH_READERS];
+    Thread      threads[EPOCH_READERS];
+    for (usize i = 0; i < EPOCH_READERS; ++i) {
+        readers[i] = (EpochReader){&shared, i};
+        thread_create(&threads[i], read_nodes, &readers[i]);
+    }
+
+    // Only this thread touches the pool: frees run on the retiring thread.
+    EpochThread* me = epoch_register(&domain);
+    for (u64 i = 1; i <= EPOCH_WRITES; ++i) {
+        EpochNode* node = pool_new(&pool, EpochNode);
+        *node           = (EpochNode){i, i * 3};
+        EpochNode* old  = atomic_exchange_ptr(
+            (void**)&shared.current, node, MEMORY_ACQ_REL);
+        epoch_retire(me, old, poison_free, &pool);
+
+        // A reader preempted inside its critical section holds up every
+        // advance, so give the readers time to run on small machines.
+        if (i % 1000 == 0) {
+            time_sleep_ms(1);
+        }
+    }
+    TEST_ASSERT_LT(epoch_pending(me), EPOCH_WRITES);
+
+    atomic_store_bool(&shared.done, true, MEMORY_RELEASE);
+    for (usize i = 0; i < EPOCH_READERS; ++i) {
+        thread_join(&threads[i]);
+    }
+    epoch_unregister(me);
+
+    // Only the current node is still allocated.
+    TEST_ASSERT_EQ(pool.count, 1);
+    for (usize i = 0; i < EPOCH_READERS; ++i) {
+        TEST_ASSERT_EQ(shared.bad_reads[i], 0);
+        TEST_ASSERT_GT(shared.reads[i], 0);
+    }
+
+    arena_done(&arena);
+    epoch_domain_done(&domain);
+}
@@ -0,0 +1,256 @@
+//> use: core
+
+#include <core/core.h>
+#include <test.h>
+
+#define FIBER_COUNT 2000
+#define FIBER_ITEMS 10000
+
+//------------------------------------------------------------------------------
+// Scheduling
+
+typedef struct {
+    u32   log[12]; // Fiber ids in the order they ran
+    usize count;
+} FiberLog;
+
+typedef struct {
+    FiberLog* log;
+    u32       id;
+} FiberLogger;
+
+internal void log_and_yield(void* context)
+{
+    FiberLogger* logger = context;
+    for (usize i = 0; i < 4; ++i) {
+        logger->log->log[logger->log->count++] = logger->id;
+        fiber_yield();
+    }
+}
+
+internal void count_fiber(void* context)
+{
+    usize* finished = context;
+    fiber_yield();
+    ++*finished;
+}
+
+TEST_CASE(fiber, yields_round_robin)
+{
+    FiberScheduler scheduler;
+    fiber_scheduler_init(&scheduler);
+
+    FiberLog    log        = {0};
+    FiberLogger loggers[3] = {{&log, 0}, {&log, 1}, {&log, 2}};
+    for (usize i = 0; i < 3; ++i) {
+        fiber_spawn(&scheduler, log_and_yield, &loggers[i]);
+    }
+    TEST_ASSERT(!fiber_current());
+    fiber_scheduler_run(&scheduler);
+
+    TEST_ASSERT_EQ(log.count, 12);
+    usize out_of_turn = 0;
+    for (usize i = 0; i < 12; ++i) {
+        out_of_turn += log.log[i] != i % 3;
+    }
+    TEST_ASSERT_EQ(out_of_turn, 0);
+
+    // Thousands of fibers, with stacks recycled through the free list.
+    usize finished = 0;
+    for (usize i = 0; i < FIBER_COUNT; ++i) {
+        fiber_spawn(&scheduler, count_fiber, &finished);
+    }
+    fiber_scheduler_run(&scheduler);
+    TEST_ASSERT_EQ(finished, FIBER_COUNT);
+    TEST_ASSERT_LE(scheduler.free_count, FIBER_DEFAULT_FREE_STACKS);
+
+    fiber_scheduler_done(&scheduler);
+}
+
+//------------------------------------------------------------------------------
+// Parking
+
+typedef struct {
+    bool         timed_out;   // fiber_park_until() reported a timeout
+    TimeDuration waited;      // Time spent parked
+    Fiber*       sleeper;     // Fiber waiting to be unparked
+    bool         was_woken;   // fiber_park_until() reported a wakeup
+    bool         early_park;  // Unpark before park made park return at once
+} FiberParking;
+
+internal void park_with_deadline(void* context)
+{
+    FiberParking* parking = context;
+    TimePoint     start   = time_now();
+    parking->timed_out =
+        !fiber_park_until(time_add_duration(start, time_from_ms(20)));
+    parking->waited = time_elapsed(start, time_now());
+}
+
+internal void park_until_woken(void* context)
+{
+    FiberParking* parking = context;
+    parking->sleeper      = fiber_current();
+
+    fiber_unpark(parking->sleeper);
+    parking->early_park = fiber_park_until(FIBER_FOREVER);
+
+    parking->was_woken = fiber_park_until(FIBER_FOREVER);
+}
+
+internal void wake_sleeper(void* context)
+{
+    FiberParking* parking = context;
+    fiber_yield(); // Let the sleeper park
+    fiber_unpark(parking->sleeper);
+}
+
+TEST_CASE(fiber, park_times_out_or_wakes)
+{
+    FiberScheduler scheduler;
+    fiber_scheduler_init(&scheduler, .stack_size = KB(16));
+
+    FiberParking parking = {0};
+    fiber_spawn(&scheduler, park_with_deadline, &parking);
+    fiber_spawn(&scheduler, park_until_woken, &parking);
+    fiber_spawn(&scheduler, wake_sleeper, &parking);
+    fiber_scheduler_run(&scheduler);
+
+    TEST_ASSERT(parking.timed_out);
+    TEST_ASSERT_GE(parking.waited, time_from_ms(20));
+    TEST_ASSERT(parking.early_park);
+    TEST_ASSERT(parking.was_woken);
+
+    fiber_scheduler_done(&scheduler);
+}
+
+//------------------------------------------------------------------------------
+// Scratch
+
+typedef struct {
+    u8     fill;
+    bool   intact;   // Its scratch memory survived the other fibers
+    Arena* arena;    // Scratch arena it was given
+    usize  reserved; // Bytes that arena reserved
+} FiberScratch;
+
+// Holds scratch memory across yields while the other fibers begin and end
+// scratch scopes of their own, which on a shared arena rewind over it.
+internal void hold_scratch(void* context)
+{
+    FiberScratch* check = context;
+    for (usize round = 0; round < 4; ++round) {
+        ArenaScratch scratch = scratch_begin();
+        u8*          bytes   = arena_alloc(scratch.arena, 256);
+        memset(bytes, check->fill, 256);
+        check->arena    = scratch.arena;
+        check->reserved = scratch.arena->reserved_size;
+        fiber_yield();
+        for (usize i = 0; i < 256; ++i) {
+            check->intact &= bytes[i] == check->fill;
+        }
+        scratch_end(scratch);
+        if (round % 2 == check->fill % 2) {
+            fiber_yield(); // Puts the fibers' scopes out of step
+        }
+    }
+}
+
+TEST_CASE(fiber, scratch_survives_switches)
+{
+    FiberScheduler scheduler;
+    fiber_scheduler_init(&scheduler, .scratch_size = MB(64));
+
+    // The thread's own scratch is put aside while fibers run.
+    ArenaScratch outer = scratch_begin();
+    u8*          mine  = arena_alloc(outer.arena, 64);
+    memset(mine, 0x5a, 64);
+
+    FiberScratch checks[3];
+    for (usize i = 0; i < 3; ++i) {
+        checks[i] = (FiberScratch){.fill = (u8)(i + 1), .intact = true};
+        fiber_spawn(&scheduler, hold_scratch, &checks[i]);
+    }
+    fiber_scheduler_run(&scheduler);
+
+    for (usize i = 0; i < 3; ++i) {
+        TEST_ASSERT(checks[i].intact);
+        TEST_ASSERT(checks[i].arena != outer.arena);
+        TEST_ASSERT_EQ(checks[i].reserved, MB(64));
+        for (usize j = 0; j < i; ++j) {
+            TEST_ASSERT(checks[i].arena != checks[j].arena);
+        }
+    }
+    TEST_ASSERT_EQ(mine[63], 0x5a);
+    TEST_ASSERT_EQ(scratch_begin().arena, outer.arena);
+    scratch_end(outer);
+
+    fiber_scheduler_done(&scheduler);
+}
+
+//------------------------------------------------------------------------------
+// Channels
+
+internal void send_items(void* context)
+{
+    Channel* channel = context;
+    for (u64 i = 0; i < FIBER_ITEMS; ++i) {
+        channel_send(channel, &i);
+    }
+    channel_close(channel);
+}
+
+typedef struct {
+    Channel* channel;
+    u64      received;
+    usize    out_of_order;
+} FiberReceiver;
+
+internal void receive_items(void* context)
+{
+    FiberReceiver* receiver = context;
+    u64            value;
+    while (channel_recv(receiver->channel, &value)) {
+        receiver->out_of_order += value != receiver->received++;
+    }
+}
+
+internal void run_scheduler(void* context) { fiber_scheduler_run(context); }
+
+TEST_CASE(fiber, channels_park_fibers_not_threads)
+{
+    Arena arena;
+    arena_init(&arena, .reserved_size = MB(1));
+
+    // Both ends on one thread: a blocked fiber must let the other one run.
+    Channel channel;
+    channel_init(&channel, &arena, 4, sizeof(u64));
+    FiberScheduler scheduler;
+    fiber_scheduler_init(&scheduler);
+
+    FiberReceiver receiver = {&channel, 0, 0};
+    fiber_spawn(&scheduler, receive_items, &receiver);
+    fiber_spawn(&scheduler, send_items, &channel);
+    fiber_scheduler_run(&scheduler);
+
+    TEST_ASSERT_EQ(receiver.received, FIBER_ITEMS);
+    TEST_ASSERT_EQ(receiver.out_of_order, 0);
+    channel_done(&channel);
+
+    // A plain thread sends to a fiber parked on another thread.
+    channel_init(&channel, &arena, 4, sizeof(u64));
+    receiver = (FiberReceiver){&channel, 0, 0};
+    fiber_spawn(&scheduler, receive_items, &receiver);
+
+    Thread thread;
+    thread_create(&thread, run_scheduler, &scheduler);
+    send_items(&channel);
+    thread_join(&thread);
+
+    TEST_ASSERT_EQ(receiver.received, FIBER_ITEMS);
+    TEST_ASSERT_EQ(receiver.out_of_order, 0);
+
+    channel_done(&channel);
+    fiber_scheduler_done(&scheduler);
+    arena_done(&arena);
+}
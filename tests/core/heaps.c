@@ -0,0 +1,119 @@
+//> use: core
+
+#include <core/core.h>
+#include <test.h>
+
+TEST_CASE(heap, freed_blocks_are_reused_and_merged)
+{
+    Heap heap;
+    heap_init(&heap, .reserved_size = MB(16));
+
+    u8* a = heap_alloc(&heap, 100);
+    u8* b = heap_alloc(&heap, 200);
+    u8* c = heap_alloc(&heap, 300);
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_EQ((usize)a % HEAP_ALIGNMENT, 0);
+    TEST_ASSERT_EQ(heap_size(a), 104);
+    TEST_ASSERT_EQ(heap.count, 3);
+
+    // A freed block is handed back for a request of the same size.
+    heap_free(&heap, b);
+    TEST_ASSERT_EQ(heap_alloc(&heap, 200), b);
+
+    // Freeing neighbours merges them into one block that covers both.
+    heap_free(&heap, a);
+    heap_free(&heap, b);
+    HeapStats stats = heap_stats(&heap);
+    TEST_ASSERT_EQ(stats.count, 1);
+    TEST_ASSERT_EQ(stats.free_blocks, 2);
+    TEST_ASSERT_EQ(heap_alloc(&heap, 300), a);
+
+    heap_free(&heap, a);
+    heap_free(&heap, c);
+    stats = heap_stats(&heap);
+    TEST_ASSERT_EQ(stats.used, 0);
+    TEST_ASSERT_EQ(stats.count, 0);
+    TEST_ASSERT_EQ(stats.free_blocks, 1);
+    TEST_ASSERT(stats.fragmentation == 0.0);
+
+    heap_done(&heap);
+}
+
+TEST_CASE(heap, reports_fragmentation)
+{
+    Heap heap;
+    heap_init(&heap, .reserved_size = MB(16));
+
+    // Free every other block so that free space is split into small pieces.
+    u8* blocks[64];
+    for (usize i = 0; i < 64; ++i) {
+        blocks[i] = heap_alloc(&heap, 256);
+    }
+    HeapStats before = heap_stats(&heap);
+    for (usize i = 0; i < 64; i += 2) {
+        heap_free(&heap, blocks[i]);
+    }
+
+    HeapStats stats = heap_stats(&heap);
+    TEST_ASSERT_EQ(stats.used, before.used / 2);
+    TEST_ASSERT_EQ(stats.free_blocks, 33); // 32 holes and the tail
+    TEST_ASSERT(stats.fragmentation > 0.0 && stats.fragmentation < 1.0);
+
+    heap_done(&heap);
+}
+
+TEST_CASE(heap, survives_random_alloc_and_free)
+{
+    Heap heap;
+    heap_init(&heap, .reserved_size = MB(64));
+    random_seed(36);
+
+    // Fill each block with its index and check it survived until it is freed.
+    enum { SLOTS = 512 };
+    u8*   slots[SLOTS] = {0};
+    usize sizes[SLOTS] = {0};
+    usize corrupted    = 0;
+    for (usize round = 0; round < 20000; ++round) {
+        usize i = (usize)random_range_u64(0, SLOTS - 1);
+        if (slots[i]) {
+            for (usize j = 0; j < sizes[i]; ++j) {
+                corrupted += slots[i][j] != (u8)i;
+            }
+            heap_free(&heap, slots[i]);
+            slots[i] = NULL;
+        } else {
+            sizes[i] = (usize)random_range_u64(1, KB(16));
+            slots[i] = heap_alloc(&heap, sizes[i]);
+            memset(slots[i], (int)(u8)i, sizes[i]);
+        }
+    }
+    TEST_ASSERT_EQ(corrupted, 0);
+
+    for (usize i = 0; i < SLOTS; ++i) {
+        heap_free(&heap, slots[i]);
+    }
+    HeapStats stats = heap_stats(&heap);
+    TEST_ASSERT_EQ(stats.used, 0);
+    TEST_ASSERT_EQ(stats.free_blocks, 1);
+    TEST_ASSERT_GE(stats.peak, KB(16));
+
+    heap_done(&heap);
+}
+
+TEST_CASE(heap, returns_null_when_reserve_is_exhausted)
+{
+    Heap heap;
+    heap_init(&heap, .reserved_size = MB(1), .grow_rate = 1);
+
+    TEST_ASSERT_NULL(heap_alloc(&heap, MB(2)));
+    u8* big = heap_alloc(&heap, KB(512));
+    TEST_ASSERT_NOT_NULL(big);
+    TEST_ASSERT_NULL(heap_alloc(&heap, KB(768)));
+    TEST_ASSERT_NULL(heap_alloc(&heap, 0));
+
+    // Freed memory can be handed out again at the full size.
+    heap_free(&heap, big);
+    TEST_ASSERT_NOT_NULL(heap_alloc(&heap, KB(960)));
+
+    heap_done(&heap);
+}
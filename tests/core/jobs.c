@@ -0,0 +1,218 @@
+//> use: core
+
+#include <core/core.h>
+#include <test.h>
+
+//------------------------------------------------------------------------------
+// Recursive splitting
+
+typedef struct {
+    JobSystem* system;
+    u64        n;
+    u64        result;
+} FibJob;
+
+internal void fib_job(void* context)
+{
+    FibJob* fib = context;
+    if (fib->n < 2) {
+        fib->result = fib->n;
+        return;
+    }
+
+    // Children live on this job's stack, which outlives them because the
+    // wait below runs other jobs rather than returning.
+    FibJob     a = {fib->system, fib->n - 1, 0};
+    FibJob     b = {fib->system, fib->n - 2, 0};
+    Job        jobs[2];
+    JobCounter counter = {0};
+    job_init(&jobs[0], fib_job, &a);
+    job_init(&jobs[1], fib_job, &b);
+    job_submit(fib->system, &jobs[0], &counter);
+    job_submit(fib->system, &jobs[1], &counter);
+    job_wait(fib->system, &counter);
+
+    fib->result = a.result + b.result;
+}
+
+TEST_CASE(job, recursive_split_matches_serial_result)
+{
+    JobSystem system;
+    job_system_init(&system, .worker_count = 4);
+
+    FibJob     fib     = {&system, 20, 0};
+    Job        job;
+    JobCounter counter = {0};
+    job_init(&job, fib_job, &fib);
+    job_submit(&system, &job, &counter);
+    job_wait(&system, &counter);
+
+    TEST_ASSERT_EQ(fib.result, 6765);
+    TEST_ASSERT_EQ(counter.value, 0);
+
+    job_system_done(&system);
+}
+
+//------------------------------------------------------------------------------
+// Dependencies
+
+typedef struct {
+    u64 sequence; // Shared step counter
+    u64 step[4];  // Step at which each job ran
+} DiamondState;
+
+typedef struct {
+    DiamondState* state;
+    usize         index;
+} DiamondJob;
+
+internal void diamond_job(void* context)
+{
+    DiamondJob* job = context;
+    job->state->step[job->index] =
+        atomic_fetch_add_u64(&job->state->sequence, 1, MEMORY_ACQ_REL);
+}
+
+TEST_CASE(job, dependents_run_after_their_parents)
+{
+    JobSystem system;
+    job_system_init(&system, .worker_count = 4);
+
+    // a -> (b, c) -> d, submitted in reverse so nothing runs early by luck.
+    for (usize round = 0; round < 200; ++round) {
+        DiamondState state = {0};
+        DiamondJob   contexts[4];
+        Job          jobs[4];
+        for (usize i = 0; i < 4; ++i) {
+            contexts[i] = (DiamondJob){&state, i};
+            job_init(&jobs[i], diamond_job, &contexts[i]);
+        }
+        job_depend(&jobs[1], &jobs[0]);
+        job_depend(&jobs[2], &jobs[0]);
+        job_depend(&jobs[3], &jobs[1]);
+        job_depend(&jobs[3], &jobs[2]);
+
+        JobCounter counter = {0};
+        for (usize i = 4; i > 0; --i) {
+            job_submit(&system, &jobs[i - 1], &counter);
+        }
+        job_wait(&system, &counter);
+
+        TEST_ASSERT_EQ(state.sequence, 4);
+        TEST_ASSERT_EQ(state.step[0], 0);
+        TEST_ASSERT_EQ(state.step[3], 3);
+    }
+
+    job_system_done(&system);
+}
+
+//------------------------------------------------------------------------------
+// Fan-out
+
+internal void fan_out_job(void* context)
+{
+    u64* value = context;
+    *value     = *value * 2 + 1;
+}
+
+typedef struct {
+    JobSystem* system;
+    Job*       jobs;
+    u64*       values;
+    usize      count;
+} FanOutSubmitter;
+
+internal void fan_out_submit(void* context)
+{
+    FanOutSubmitter* submitter = context;
+    JobCounter       counter   = {0};
+    for (usize i = 0; i < submitter->count; ++i) {
+        job_init(&submitter->jobs[i], fan_out_job, &submitter->values[i]);
+        job_submit(submitter->system, &submitter->jobs[i], &counter);
+    }
+    job_wait(submitter->system, &counter);
+}
+
+TEST_CASE(job, wide_fan_out_from_workers_and_other_threads)
+{
+    JobSystem system;
+    job_system_init(&system, .worker_count = 4);
+
+    // More jobs than a deque holds, so some run inline on submission.
+    enum { COUNT = JOB_DEQUE_CAPACITY * 3 };
+    u64* values = KORE_ARRAY_ALLOC(u64, COUNT * 2);
+    Job* jobs   = KORE_ARRAY_ALLOC(Job, COUNT * 2);
+    for (usize i = 0; i < COUNT * 2; ++i) {
+        values[i] = i;
+    }
+
+    // The second half is submitted from a thread outside the system.
+    FanOutSubmitter outside = {&system, jobs + COUNT, values + COUNT, COUNT};
+    Thread          thread;
+    thread_create(&thread, fan_out_submit, &outside);
+
+    FanOutSubmitter inside = {&system, jobs, values, COUNT};
+    fan_out_submit(&inside);
+    thread_join(&thread);
+
+    usize wrong = 0;
+    for (usize i = 0; i < COUNT * 2; ++i) {
+        wrong += values[i] != i * 2 + 1;
+    }
+    TEST_ASSERT_EQ(wrong, 0);
+
+    KORE_ARRAY_FREE(jobs);
+    KORE_ARRAY_FREE(values);
+    job_system_done(&system);
+}
+
+//------------------------------------------------------------------------------
+// Shutdown
+
+typedef struct {
+    JobSystem* system;
+    Job*       jobs;
+    u64*       values;
+    usize      count;
+    JobCounter counter;
+} ShutdownSubmitter;
+
+// Submits without waiting, leaving the jobs for shutdown to run.
+internal void submit_and_leave(void* context)
+{
+    ShutdownSubmitter* submitter = context;
+    for (usize i = 0; i < submitter->count; ++i) {
+        job_init(&submitter->jobs[i], fan_out_job, &submitter->values[i]);
+        job_submit(submitter->system, &submitter->jobs[i], &submitter->counter);
+    }
+}
+
+TEST_CASE(job, shutdown_runs_jobs_nobody_waited_for)
+{
+    enum { COUNT = 1000 };
+    Job jobs[COUNT];
+    u64 values[COUNT];
+
+    // With worker 0 alone nothing runs until shutdown; with more workers some
+    // jobs are still queued when it starts.
+    for (usize workers = 1; workers <= 4; workers += 3) {
+        JobSystem system;
+        job_system_init(&system, .worker_count = workers);
+        for (usize i = 0; i < COUNT; ++i) {
+            values[i] = i;
+        }
+
+        ShutdownSubmitter submitter = {&system, jobs, values, COUNT, {0}};
+        Thread            thread;
+        thread_create(&thread, submit_and_leave, &submitter);
+        thread_join(&thread);
+        job_system_done(&system);
+
+        usize wrong = 0;
+        for (usize i = 0; i < COUNT; ++i) {
+            wrong += values[i] != i * 2 + 1;
+        }
+        TEST_ASSERT_EQ(wrong, 0);
+        TEST_ASSERT_EQ(submitter.counter.value, 0);
+    }
+}
@@ -0,0 +1,212 @@
+//> use: core
+
+#include <core/core.h>
+#include <test.h>
+
+#define LOCK_THREADS 4
+#define LOCK_ITERATIONS 20000
+
+typedef enum {
+    LOCK_KIND_ADAPTIVE,
+    LOCK_KIND_SPIN,
+    LOCK_KIND_RW,
+} LockKind;
+
+typedef struct {
+    LockKind      kind;
+    AdaptiveMutex adaptive;
+    Spinlock      spin;
+    RwLock        rw;
+    u64           a;    // Always equal to `b` outside the lock
+    u64           b;    // Updated separately from `a`
+    usize         torn; // Reads that saw `a != b` (written under the lock)
+} LockedCounter;
+
+internal void locked_counter_worker(void* context)
+{
+    LockedCounter* counter = context;
+    for (usize i = 0; i < LOCK_ITERATIONS; ++i) {
+        switch (counter->kind) {
+        case LOCK_KIND_ADAPTIVE:
+            adaptive_mutex_lock(&counter->adaptive);
+            counter->a++;
+            counter->b++;
+            adaptive_mutex_unlock(&counter->adaptive);
+            break;
+
+        case LOCK_KIND_SPIN:
+            spinlock_lock(&counter->spin);
+            counter->a++;
+            counter->b++;
+            spinlock_unlock(&counter->spin);
+            break;
+
+        case LOCK_KIND_RW:
+            // Mostly reads, with a write every eighth iteration.
+            if (i % 8 == 0) {
+                rwlock_write_lock(&counter->rw);
+                counter->a++;
+                counter->b++;
+                rwlock_write_unlock(&counter->rw);
+            } else {
+                rwlock_read_lock(&counter->rw);
+                bool torn = counter->a != counter->b;
+                rwlock_read_unlock(&counter->rw);
+                if (torn) {
+                    rwlock_write_lock(&counter->rw);
+                    counter->torn++;
+                    rwlock_write_unlock(&counter->rw);
+                }
+            }
+            break;
+        }
+    }
+}
+
+internal void run_locked_counter(LockedCounter* counter)
+{
+    Thread threads[LOCK_THREADS];
+    for (usize i = 0; i < LOCK_THREADS; ++i) {
+        thread_create(&threads[i], locked_counter_worker, counter);
+    }
+    for (usize i = 0; i < LOCK_THREADS; ++i) {
+        thread_join(&threads[i]);
+    }
+}
+
+TEST_CASE(lock, adaptive_mutex_excludes_threads)
+{
+    LockedCounter counter = {.kind = LOCK_KIND_ADAPTIVE};
+    adaptive_mutex_init(&counter.adaptive);
+    run_locked_counter(&counter);
+
+    TEST_ASSERT_EQ(counter.a, LOCK_THREADS * LOCK_ITERATIONS);
+    TEST_ASSERT_EQ(counter.b, counter.a);
+    TEST_ASSERT_EQ(counter.adaptive.state, 0);
+    adaptive_mutex_done(&counter.adaptive);
+}
+
+TEST_CASE(lock, spinlock_excludes_threads)
+{
+    LockedCounter counter = {.kind = LOCK_KIND_SPIN};
+    spinlock_init(&counter.spin);
+    run_locked_counter(&counter);
+
+    TEST_ASSERT_EQ(counter.a, LOCK_THREADS * LOCK_ITERATIONS);
+    TEST_ASSERT_EQ(counter.spin.next, counter.spin.serving);
+    spinlock_done(&counter.spin);
+}
+
+TEST_CASE(lock, rwlock_readers_never_see_partial_writes)
+{
+    LockedCounter counter = {.kind = LOCK_KIND_RW};
+    rwlock_init(&counter.rw);
+    run_locked_counter(&counter);
+
+    TEST_ASSERT_EQ(counter.a, LOCK_THREADS * LOCK_ITERATIONS / 8);
+    TEST_ASSERT_EQ(counter.b, counter.a);
+    TEST_ASSERT_EQ(counter.torn, 0);
+    TEST_ASSERT_EQ(counter.rw.state, 0);
+
+    // Readers share the lock.
+    rwlock_read_lock(&counter.rw);
+    rwlock_read_lock(&counter.rw);
+    TEST_ASSERT_EQ(counter.rw.state, 2);
+    rwlock_read_unlock(&counter.rw);
+    rwlock_read_unlock(&counter.rw);
+    rwlock_done(&counter.rw);
+}
+
+//------------------------------------------------------------------------------
+// Profiling
+
+typedef struct {
+    Mutex         mutex;
+    AdaptiveMutex adaptive;
+} ProfiledLocks;
+
+internal void take_profiled_locks(void* context)
+{
+    ProfiledLocks* locks = context;
+    mutex_lock(&locks->mutex);
+    mutex_unlock(&locks->mutex);
+    adaptive_mutex_lock(&locks->adaptive);
+    adaptive_mutex_unlock(&locks->adaptive);
+}
+
+internal LockProfile find_profile(cstr name)
+{
+    LockProfile profiles[LOCK_PROFILE_MAX];
+    usize       count = lock_profile_snapshot(profiles, LOCK_PROFILE_MAX);
+    for (usize i = 0; i < count; ++i) {
+        if (strcmp(profiles[i].name, name) == 0) {
+            return profiles[i];
+        }
+    }
+    return (LockProfile){0};
+}
+
+TEST_CASE(lock, profiles_record_contention_and_holds)
+{
+    ProfiledLocks locks;
+    mutex_init(&locks.mutex, .name = "test_mutex");
+    adaptive_mutex_init(&locks.adaptive, .name = "test_adaptive");
+    Mutex unnamed;
+    mutex_init(&unnamed);
+
+    // Nothing is recorded until profiling is enabled.
+    take_profiled_locks(&locks);
+    lock_profile_enable(true);
+    lock_profile_reset();
+
+    // Hold both locks while another thread queues for them.
+    mutex_lock(&locks.mutex);
+    adaptive_mutex_lock(&locks.adaptive);
+    Thread thread;
+    thread_create(&thread, take_profiled_locks, &locks);
+    time_sleep_ms(20);
+    mutex_unlock(&locks.mutex);
+    time_sleep_ms(20);
+    adaptive_mutex_unlock(&locks.adaptive);
+    thread_join(&thread);
+
+    mutex_lock(&unnamed);
+    mutex_unlock(&unnamed);
+    // Output only takes its lock when it is written out.
+    pr(" ");
+    pr_flush();
+    lock_profile_enable(false);
+    take_profiled_locks(&locks);
+
+    LockProfile mutex = find_profile("test_mutex");
+    TEST_ASSERT_EQ(mutex.acquisitions, 2);
+    TEST_ASSERT_EQ(mutex.contended, 1);
+    TEST_ASSERT_GE(mutex.max_wait, time_from_ms(5));
+    TEST_ASSERT_GE(mutex.wait_time, mutex.max_wait);
+    TEST_ASSERT_GE(mutex.max_hold, time_from_ms(20));
+    TEST_ASSERT_GE(mutex.hold_time, mutex.max_hold);
+
+    LockProfile adaptive = find_profile("test_adaptive");
+    TEST_ASSERT_EQ(adaptive.acquisitions, 2);
+    TEST_ASSERT_EQ(adaptive.contended, 1);
+    TEST_ASSERT_GE(adaptive.max_wait, time_from_ms(5));
+    TEST_ASSERT_GE(adaptive.max_hold, time_from_ms(40));
+
+    TEST_ASSERT_GE(find_profile("output").acquisitions, 1);
+    TEST_ASSERT(unnamed.profile == NULL);
+
+    // Worst offenders come first.
+    LockProfile profiles[LOCK_PROFILE_MAX];
+    usize       count    = lock_profile_snapshot(profiles, LOCK_PROFILE_MAX);
+    usize       unsorted = 0;
+    for (usize i = 1; i < count; ++i) {
+        unsorted += profiles[i].wait_time > profiles[i - 1].wait_time;
+    }
+    TEST_ASSERT_GE(count, 3);
+    TEST_ASSERT_EQ(unsorted, 0);
+    TEST_ASSERT_EQ(lock_profile_snapshot(profiles, 1), 1);
+
+    mutex_done(&unnamed);
+    adaptive_mutex_done(&locks.adaptive);
+    mutex_done(&locks.mutex);
+}
@@ -0,0 +1,251 @@
+//> use: core
+
+#include <core/core.h>
+#include <test.h>
+
+#include <stdio.h>
+
+#if OS_POSIX
+#    include <sched.h>
+// signal.h declares a kill() that clashes with kore's.
+#    define kill posix_kill
+#    include <sys/wait.h>
+#    undef kill
+#endif // OS_POSIX
+
+#define OUTPUT_THREADS 4
+#define OUTPUT_LINES 2000
+
+#if OS_POSIX
+
+//------------------------------------------------------------------------------
+// Capture stdout in a temporary file
+
+typedef struct {
+    int  file;
+    int  saved;
+    char path[32];
+} Capture;
+
+internal void capture_begin(Capture* capture)
+{
+    // Nothing printed before the test may land in the file.
+    pr_flush();
+    fflush(stdout);
+    strcpy(capture->path, "/tmp/kore_outputXXXXXX");
+    capture->file  = mkstemp(capture->path);
+    capture->saved = dup(STDOUT_FILENO);
+    dup2(capture->file, STDOUT_FILENO);
+}
+
+internal usize capture_size(Capture* capture)
+{
+    return (usize)lseek(capture->file, 0, SEEK_END);
+}
+
+// Restores stdout and returns what was written to it, which the caller frees.
+internal char* capture_end(Capture* capture, usize* out_size)
+{
+    dup2(capture->saved, STDOUT_FILENO);
+    close(capture->saved);
+
+    usize size = capture_size(capture);
+    char* text = KORE_ALLOC(size + 1);
+    usize got  = (usize)pread(capture->file, text, size, 0);
+    text[got]  = 0;
+    close(capture->file);
+    unlink(capture->path);
+    *out_size = got;
+    return text;
+}
+
+//------------------------------------------------------------------------------
+// Flush policies
+
+TEST_CASE(output, flushes_by_policy)
+{
+    Capture capture;
+    capture_begin(&capture);
+
+    // Fully buffered: nothing is written until asked.
+    pr_set_flush(OUTPUT_FLUSH_FULL);
+    prn("hello %d", 1);
+    pr("partial");
+    TEST_ASSERT_EQ(capture_size(&capture), 0);
+    pr_flush();
+    TEST_ASSERT_EQ(capture_size(&capture), 15);
+
+    // Line buffered: a print that ends a line writes it out.
+    pr_set_flush(OUTPUT_FLUSH_LINES);
+    pr(" line");
+    TEST_ASSERT_EQ(capture_size(&capture), 15);
+    prn(" done");
+    TEST_ASSERT_EQ(capture_size(&capture), 26);
+
+    // Text larger than the buffer goes straight out, even fully buffered.
+    pr_set_flush(OUTPUT_FLUSH_FULL);
+    usize big_size = OUTPUT_BUFFER_SIZE * 3;
+    char* big      = KORE_ALLOC(big_size + 1);
+    memset(big, 'x', big_size);
+    big[big_size] = 0;
+    pr("[");
+    prn("%s]", big);
+    TEST_ASSERT_EQ(capture_size(&capture), 26 + big_size + 3);
+    KORE_FREE(big);
+
+    pr_set_flush(OUTPUT_FLUSH_AUTO);
+    usize size;
+    char* text = capture_end(&capture, &size);
+    TEST_ASSERT_EQ(size, 26 + big_size + 3);
+    TEST_ASSERT(!memcmp(text, "hello 1\npartial line done\n[x", 28));
+    TEST_ASSERT(!memcmp(text + size - 3, "x]\n", 3));
+    KORE_FREE(text);
+}
+
+//------------------------------------------------------------------------------
+// Threads
+
+internal void print_lines(void* context)
+{
+    usize index = *(usize*)context;
+    for (usize i = 0; i < OUTPUT_LINES; ++i) {
+        // Built from several prints, so a flush can fall inside a line, and
+        // other threads get to run before it ends.
+        pr("thread %zu ", index);
+        sched_yield();
+        pr("line %zu", i);
+        prn(" %s", "................................................");
+    }
+}
+
+TEST_CASE(output, lines_from_threads_stay_whole)
+{
+    Capture capture;
+    capture_begin(&capture);
+    pr_set_flush(OUTPUT_FLUSH_FULL);
+
+    usize  indexes[OUTPUT_THREADS];
+    Thread threads[OUTPUT_THREADS];
+    for (usize i = 0; i < OUTPUT_THREADS; ++i) {
+        indexes[i] = i;
+        thread_create(&threads[i], print_lines, &indexes[i]);
+    }
+    // Each thread writes out what it has left as it ends.
+    for (usize i = 0; i < OUTPUT_THREADS; ++i) {
+        thread_join(&threads[i]);
+    }
+
+    pr_set_flush(OUTPUT_FLUSH_AUTO);
+    usize size;
+    char* text = capture_end(&capture, &size);
+
+    usize next[OUTPUT_THREADS] = {0};
+    usize bad                  = 0;
+    for (char* line = text; *line;) {
+        char* end = strchr(line, '\n');
+        if (!end) {
+            bad++;
+            break;
+        }
+        *end = 0;
+        usize index, i;
+        int   consumed = 0;
+        if (sscanf(line, "thread %zu line %zu %n", &index, &i, &consumed) !=
+                2 ||
+            index >= OUTPUT_THREADS || i != next[index] ||
+            strlen(line + consumed) != 48) {
+            bad++;
+        } else {
+            next[index]++;
+        }
+        line = end + 1;
+    }
+    TEST_ASSERT_EQ(bad, 0);
+    for (usize i = 0; i < OUTPUT_THREADS; ++i) {
+        TEST_ASSERT_EQ(next[i], OUTPUT_LINES);
+    }
+    KORE_FREE(text);
+}
+
+//------------------------------------------------------------------------------
+// Thread exit and process exit
+
+internal void* print_and_leave(void* context)
+{
+    UNUSED(context);
+    prn("from a plain pthread");
+    return NULL;
+}
+
+TEST_CASE(output, threads_not_made_by_kore_write_out_as_they_end)
+{
+    Capture capture;
+    capture_begin(&capture);
+    pr_set_flush(OUTPUT_FLUSH_FULL);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, print_and_leave, NULL);
+    pthread_join(thread, NULL);
+    usize written = capture_size(&capture);
+
+    pr_set_flush(OUTPUT_FLUSH_AUTO);
+    usize size;
+    char* text = capture_end(&capture, &size);
+    TEST_ASSERT_EQ(written, 21);
+    TEST_ASSERT(!memcmp(text, "from a plain pthread\n", 21));
+    KORE_FREE(text);
+}
+
+internal void print_and_wait(void* context)
+{
+    prn("from a running thread");
+    atomic_store_bool(context, true, MEMORY_RELEASE);
+    for (;;) {
+        time_sleep_ms(1000);
+    }
+}
+
+TEST_CASE(output, exit_writes_out_threads_still_running)
+{
+    // The child exits while its thread still holds a buffered line.
+    int pipe_ends[2];
+    TEST_ASSERT_EQ(pipe(pipe_ends), 0);
+    pr_flush();
+    pid_t child = fork();
+    if (child == 0) {
+        dup2(pipe_ends[1], STDOUT_FILENO);
+        close(pipe_ends[0]);
+        close(pipe_ends[1]);
+        pr_set_flush(OUTPUT_FLUSH_FULL);
+        prn("from main");
+
+        bool   printed = false;
+        Thread thread;
+        thread_create(&thread, print_and_wait, &printed);
+        thread_detach(&thread);
+        while (!atomic_load_bool(&printed, MEMORY_ACQUIRE)) {
+            time_sleep_ms(1);
+        }
+        exit(0);
+    }
+    close(pipe_ends[1]);
+
+    char  text[128];
+    usize size = 0;
+    for (ssize_t got; (got = read(pipe_ends[0],
+                                  text + size,
+                                  sizeof(text) - 1 - size)) > 0;) {
+        size += (usize)got;
+    }
+    close(pipe_ends[0]);
+    text[size] = 0;
+    int status;
+    waitpid(child, &status, 0);
+
+    TEST_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    TEST_ASSERT_EQ(size, 32);
+    TEST_ASSERT(strstr(text, "from main\n"));
+    TEST_ASSERT(strstr(text, "from a running thread\n"));
+}
+
+#endif // OS_POSIX
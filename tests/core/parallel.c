@@ -0,0 +1,218 @@
+//> use: core
+
+#include <core/core.h>
+#include <test.h>
+
+#define PARALLEL_COUNT 100003 // Not a multiple of any chunk size
+
+typedef struct {
+    u32 key;
+    u32 index; // Position before sorting, to check stability
+} Record;
+
+DEF_SLICE(Record) RecordSlice;
+
+internal void fill_records(Record* records, usize count)
+{
+    random_seed(42);
+    for (usize i = 0; i < count; ++i) {
+        records[i].key   = (u32)random_range_u64(0, 999);
+        records[i].index = (u32)i;
+    }
+}
+
+// Checks that records are ordered by key, and by original index within a key.
+internal usize count_unstable(Record* records, usize count)
+{
+    usize bad = 0;
+    for (usize i = 1; i < count; ++i) {
+        Record a = records[i - 1];
+        Record b = records[i];
+        bad += a.key > b.key || (a.key == b.key && a.index > b.index);
+    }
+    return bad;
+}
+
+//------------------------------------------------------------------------------
+// For, reduce and scan
+
+internal void square_range(void* context, usize begin, usize end)
+{
+    u64* values = context;
+    for (usize i = begin; i < end; ++i) {
+        values[i] = (u64)i * i;
+    }
+}
+
+internal void sum_range(void* context, usize begin, usize end, void* result)
+{
+    u64* values = context;
+    u64* sum    = result;
+    for (usize i = begin; i < end; ++i) {
+        *sum += values[i];
+    }
+}
+
+internal void add_u64(void* context, void* accumulator, const void* value)
+{
+    UNUSED(context);
+    *(u64*)accumulator += *(const u64*)value;
+}
+
+TEST_CASE(parallel, for_and_reduce_cover_every_element)
+{
+    JobSystem system;
+    job_system_init(&system, .worker_count = 4);
+
+    Array(u64) values = NULL;
+    array_reserve(values, PARALLEL_COUNT);
+    parallel_for(&system, array_count(values), 1000, square_range, values);
+
+    u64 sum = 0;
+    parallel_reduce(
+        &system, PARALLEL_COUNT, 1000, sum_range, add_u64, values, &sum, 8);
+
+    u64   expected = 0;
+    usize wrong    = 0;
+    for (u64 i = 0; i < PARALLEL_COUNT; ++i) {
+        wrong += values[i] != i * i;
+        expected += i * i;
+    }
+    TEST_ASSERT_EQ(wrong, 0);
+    TEST_ASSERT_EQ(sum, expected);
+
+    array_free(values);
+    job_system_done(&system);
+}
+
+TEST_CASE(parallel, scans_match_serial_totals)
+{
+    JobSystem system;
+    job_system_init(&system, .worker_count = 4);
+
+    Array(u64) input  = NULL;
+    Array(u64) output = NULL;
+    array_reserve(input, PARALLEL_COUNT);
+    array_reserve(output, PARALLEL_COUNT);
+    for (usize i = 0; i < PARALLEL_COUNT; ++i) {
+        input[i] = i % 7;
+    }
+
+    u64 zero = 0;
+    parallel_scan(&system,
+                  PARALLEL_ARRAY(input),
+                  output,
+                  500,
+                  add_u64,
+                  NULL,
+                  &zero,
+                  true);
+    usize wrong   = 0;
+    u64   running = 0;
+    for (usize i = 0; i < PARALLEL_COUNT; ++i) {
+        running += input[i];
+        wrong += output[i] != running;
+    }
+    TEST_ASSERT_EQ(wrong, 0);
+
+    // Exclusive, in place.
+    parallel_scan(&system,
+                  PARALLEL_ARRAY(input),
+                  input,
+                  500,
+                  add_u64,
+                  NULL,
+                  &zero,
+                  false);
+    for (usize i = 0; i < PARALLEL_COUNT; ++i) {
+        wrong += input[i] != output[i] - i % 7;
+    }
+    TEST_ASSERT_EQ(wrong, 0);
+
+    array_free(output);
+    array_free(input);
+    job_system_done(&system);
+}
+
+//------------------------------------------------------------------------------
+// Sorting and partitioning
+
+internal int compare_records(void* context, const void* a, const void* b)
+{
+    UNUSED(context);
+    u32 x = ((const Record*)a)->key;
+    u32 y = ((const Record*)b)->key;
+    return (x > y) - (x < y);
+}
+
+TEST_CASE(parallel, sorts_are_stable)
+{
+    JobSystem system;
+    job_system_init(&system, .worker_count = 4);
+
+    RecordSlice records = {
+        .data  = KORE_ARRAY_ALLOC(Record, PARALLEL_COUNT),
+        .count = PARALLEL_COUNT,
+    };
+
+    fill_records(records.data, records.count);
+    parallel_sort(&system, PARALLEL_SLICE(records), compare_records, NULL);
+    TEST_ASSERT_EQ(count_unstable(records.data, records.count), 0);
+
+    fill_records(records.data, records.count);
+    parallel_radix_sort(&system,
+                        PARALLEL_SLICE(records),
+                        offsetof(Record, key),
+                        sizeof(u32));
+    TEST_ASSERT_EQ(count_unstable(records.data, records.count), 0);
+
+    // Short ranges run inline.
+    Record few[3] = {{3, 0}, {1, 1}, {3, 2}};
+    parallel_sort(&system, few, 3, sizeof(Record), compare_records, NULL);
+    TEST_ASSERT_EQ(few[0].key, 1);
+    TEST_ASSERT_EQ(few[1].index, 0);
+    TEST_ASSERT_EQ(few[2].index, 2);
+
+    KORE_ARRAY_FREE(records.data);
+    job_system_done(&system);
+}
+
+internal bool is_even_key(void* context, const void* element)
+{
+    UNUSED(context);
+    return ((const Record*)element)->key % 2 == 0;
+}
+
+TEST_CASE(parallel, partition_keeps_order_within_groups)
+{
+    JobSystem system;
+    job_system_init(&system, .worker_count = 4);
+
+    Array(Record) input  = NULL;
+    Array(Record) output = NULL;
+    array_reserve(input, PARALLEL_COUNT);
+    array_reserve(output, PARALLEL_COUNT);
+    fill_records(input, PARALLEL_COUNT);
+
+    usize even = parallel_partition(
+        &system, PARALLEL_ARRAY(input), output, is_even_key, NULL);
+
+    usize expected = 0;
+    for (usize i = 0; i < PARALLEL_COUNT; ++i) {
+        expected += input[i].key % 2 == 0;
+    }
+    TEST_ASSERT_EQ(even, expected);
+
+    usize misplaced = 0;
+    for (usize i = 0; i < PARALLEL_COUNT; ++i) {
+        misplaced += (output[i].key % 2 == 0) != (i < even);
+        if (i > 0 && i != even) {
+            misplaced += output[i - 1].index > output[i].index;
+        }
+    }
+    TEST_ASSERT_EQ(misplaced, 0);
+
+    array_free(output);
+    array_free(input);
+    job_system_done(&system);
+}
@@ -0,0 +1,68 @@
+//> use: core
+
+#include <core/core.h>
+#include <test.h>
+
+typedef struct {
+    u64 key;
+    u32 value;
+} PoolNode;
+
+TEST_CASE(pool, slots_are_adjacent_and_recycled)
+{
+    Arena arena;
+    arena_init(&arena, .reserved_size = MB(1), .grow_rate = 1);
+
+    Pool pool;
+    pool_init_typed(&pool, &arena, PoolNode);
+    TEST_ASSERT_EQ(pool.slot_size, sizeof(PoolNode));
+
+    PoolNode* a = pool_new(&pool, PoolNode);
+    PoolNode* b = pool_new(&pool, PoolNode);
+    PoolNode* c = pool_new(&pool, PoolNode);
+    TEST_ASSERT_EQ((u8*)b - (u8*)a, sizeof(PoolNode));
+    TEST_ASSERT_EQ((u8*)c - (u8*)b, sizeof(PoolNode));
+    TEST_ASSERT_EQ(pool.count, 3);
+
+    // Freed slots are reused most-recent first.
+    pool_free(&pool, b);
+    pool_free(&pool, a);
+    TEST_ASSERT_EQ(pool.count, 1);
+    TEST_ASSERT_EQ(pool_new(&pool, PoolNode), a);
+    TEST_ASSERT_EQ(pool_new(&pool, PoolNode), b);
+    TEST_ASSERT_EQ(pool_new(&pool, PoolNode),
+                   (PoolNode*)((u8*)c + sizeof(PoolNode)));
+
+    arena_done(&arena);
+}
+
+TEST_CASE(pool, small_slots_hold_free_list_and_span_chunks)
+{
+    Arena arena;
+    arena_init(&arena, .reserved_size = MB(1), .grow_rate = 1);
+
+    Pool pool;
+    pool_init(&pool, &arena, 1, 1);
+    TEST_ASSERT_EQ(pool.slot_size, sizeof(void*));
+
+    // Allocate across several chunks and check every slot is distinct.
+    usize count = arena.alloc_granularity / sizeof(void*) * 3;
+    u8**  slots = KORE_ARRAY_ALLOC(u8*, count);
+    for (usize i = 0; i < count; ++i) {
+        slots[i]  = pool_alloc(&pool);
+        *slots[i] = (u8)i;
+    }
+
+    usize mismatches = 0;
+    for (usize i = 0; i < count; ++i) {
+        if (*slots[i] != (u8)i || ((usize)slots[i] % sizeof(void*)) != 0) {
+            mismatches++;
+        }
+        pool_free(&pool, slots[i]);
+    }
+    TEST_ASSERT_EQ(mismatches, 0);
+    TEST_ASSERT_EQ(pool.count, 0);
+
+    KORE_ARRAY_FREE(slots);
+    arena_done(&arena);
+}
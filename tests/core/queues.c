@@ -0,0 +1,208 @@
+//> use: core
+
+#include <core/core.h>
+#include <test.h>
+
+#define QUEUE_ITEMS 200000
+
+//------------------------------------------------------------------------------
+// SPSC
+
+typedef struct {
+    SpscQueue* queue;
+    u64        sum;
+    usize      out_of_order;
+} SpscConsumer;
+
+internal void spsc_consumer(void* context)
+{
+    SpscConsumer* consumer = context;
+    u64           expected = 0;
+    u64           batch[16];
+    while (expected < QUEUE_ITEMS) {
+        usize count = spsc_pop_batch(consumer->queue, batch, 16);
+        if (count == 0) {
+            u64 value;
+            spsc_pop(consumer->queue, &value);
+            batch[0] = value;
+            count    = 1;
+        }
+        for (usize i = 0; i < count; ++i) {
+            consumer->out_of_order += batch[i] != expected++;
+            consumer->sum += batch[i];
+        }
+    }
+}
+
+TEST_CASE(queue, spsc_preserves_order_across_threads)
+{
+    Arena arena;
+    arena_init(&arena, .reserved_size = MB(1));
+
+    SpscQueue queue;
+    spsc_init(&queue, &arena, 100, sizeof(u64));
+    TEST_ASSERT_EQ(queue.capacity, 128);
+    TEST_ASSERT_EQ((usize)queue.buffer % 64, 0);
+
+    SpscConsumer consumer = {.queue = &queue};
+    Thread       thread;
+    thread_create(&thread, spsc_consumer, &consumer);
+
+    // Alternate single pushes with batches that wrap around the ring.
+    u64 next = 0;
+    while (next < QUEUE_ITEMS) {
+        if (next % 3 == 0) {
+            spsc_push(&queue, &next);
+            next++;
+        } else {
+            u64   batch[10];
+            usize count = MIN(10, QUEUE_ITEMS - next);
+            for (usize i = 0; i < count; ++i) {
+                batch[i] = next + i;
+            }
+            next += spsc_push_batch(&queue, batch, count);
+        }
+    }
+    thread_join(&thread);
+
+    TEST_ASSERT_EQ(consumer.out_of_order, 0);
+    TEST_ASSERT_EQ(consumer.sum, (u64)QUEUE_ITEMS * (QUEUE_ITEMS - 1) / 2);
+
+    u64 value;
+    TEST_ASSERT(!spsc_try_pop(&queue, &value));
+
+    arena_done(&arena);
+}
+
+//------------------------------------------------------------------------------
+// MPMC
+
+#define MPMC_PRODUCERS 4
+#define MPMC_CONSUMERS 4
+
+typedef struct {
+    MpmcQueue* queue;
+    u32        id;    // Producer id, stored in the top bits of each item
+    u64        sum;   // Sum of consumed sequence numbers
+    u64        count; // Items consumed
+    u64        last[MPMC_PRODUCERS]; // Last sequence seen from each producer
+    usize      out_of_order;
+} MpmcWorker;
+
+internal void mpmc_producer(void* context)
+{
+    MpmcWorker* worker = context;
+    u64         items  = QUEUE_ITEMS / MPMC_PRODUCERS;
+    for (u64 i = 1; i <= items;) {
+        if (i % 4 == 0 && i + 4 <= items) {
+            u64 batch[4];
+            for (u64 j = 0; j < 4; ++j) {
+                batch[j] = ((u64)worker->id << 32) | (i + j);
+            }
+            i += mpmc_push_batch(worker->queue, batch, 4);
+        } else {
+            u64 item = ((u64)worker->id << 32) | i;
+            mpmc_push(worker->queue, &item);
+            i++;
+        }
+    }
+}
+
+internal void mpmc_consumer(void* context)
+{
+    MpmcWorker* worker = context;
+    u64         items  = QUEUE_ITEMS / MPMC_CONSUMERS;
+    while (worker->count < items) {
+        u64   batch[8];
+        usize count = mpmc_pop_batch(
+            worker->queue, batch, MIN(8, items - worker->count));
+        if (count == 0) {
+            mpmc_pop(worker->queue, &batch[0]);
+            count = 1;
+        }
+
+        // Items from one producer must arrive in the order they were pushed.
+        for (usize i = 0; i < count; ++i) {
+            u32 producer = (u32)(batch[i] >> 32);
+            u64 sequence = batch[i] & 0xffffffffu;
+            worker->out_of_order += sequence <= worker->last[producer];
+            worker->last[producer] = sequence;
+            worker->sum += sequence;
+        }
+        worker->count += count;
+    }
+}
+
+TEST_CASE(queue, mpmc_delivers_every_item_once)
+{
+    Arena arena;
+    arena_init(&arena, .reserved_size = MB(1));
+
+    MpmcQueue queue;
+    mpmc_init(&queue, &arena, 64, sizeof(u64));
+
+    MpmcWorker producers[MPMC_PRODUCERS] = {0};
+    MpmcWorker consumers[MPMC_CONSUMERS] = {0};
+    Thread     threads[MPMC_PRODUCERS + MPMC_CONSUMERS];
+    for (u32 i = 0; i < MPMC_CONSUMERS; ++i) {
+        consumers[i].queue = &queue;
+        thread_create(&threads[i], mpmc_consumer, &consumers[i]);
+    }
+    for (u32 i = 0; i < MPMC_PRODUCERS; ++i) {
+        producers[i] = (MpmcWorker){.queue = &queue, .id = i};
+        thread_create(
+            &threads[MPMC_CONSUMERS + i], mpmc_producer, &producers[i]);
+    }
+    for (usize i = 0; i < MPMC_PRODUCERS + MPMC_CONSUMERS; ++i) {
+        thread_join(&threads[i]);
+    }
+
+    u64   sum          = 0;
+    u64   count        = 0;
+    usize out_of_order = 0;
+    for (usize i = 0; i < MPMC_CONSUMERS; ++i) {
+        sum += consumers[i].sum;
+        count += consumers[i].count;
+        out_of_order += consumers[i].out_of_order;
+    }
+    u64 per_producer = QUEUE_ITEMS / MPMC_PRODUCERS;
+    TEST_ASSERT_EQ(count, QUEUE_ITEMS);
+    TEST_ASSERT_EQ(sum, MPMC_PRODUCERS * per_producer * (per_producer + 1) / 2);
+    TEST_ASSERT_EQ(out_of_order, 0);
+
+    u64 value;
+    TEST_ASSERT(!mpmc_try_pop(&queue, &value));
+
+    arena_done(&arena);
+}
+
+TEST_CASE(queue, mpmc_try_reports_full_and_empty)
+{
+    Arena arena;
+    arena_init(&arena, .reserved_size = MB(1));
+
+    typedef struct {
+        u32 a;
+        u8  b;
+    } Odd;
+
+    MpmcQueue queue;
+    mpmc_init(&queue, &arena, 4, sizeof(Odd));
+
+    Odd items[6] = {{1, 2}, {3, 4}, {5, 6}, {7, 8}, {9, 10}, {11, 12}};
+    TEST_ASSERT_EQ(mpmc_push_batch(&queue, items, 6), 4);
+    TEST_ASSERT(!mpmc_try_push(&queue, &items[4]));
+
+    Odd out[6];
+    TEST_ASSERT(mpmc_try_pop(&queue, &out[0]));
+    TEST_ASSERT_EQ(mpmc_pop_batch(&queue, &out[1], 5), 3);
+    TEST_ASSERT(!mpmc_try_pop(&queue, &out[4]));
+    TEST_ASSERT_MEM_EQ(out, items, sizeof(Odd) * 4);
+
+    // Cells are reused on the next lap.
+    TEST_ASSERT_EQ(mpmc_push_batch(&queue, &items[2], 4), 4);
+    TEST_ASSERT_EQ(mpmc_pop_batch(&queue, out, 6), 4);
+    TEST_ASSERT_MEM_EQ(out, &items[2], sizeof(Odd) * 4);
+
+    arena_done(&arena);
+}
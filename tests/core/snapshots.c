@@ -0,0 +1,264 @@
+//> use: core
+
+#include <core/core.h>
+#include <test.h>
+
+#define SNAPSHOT_READERS 3
+#define SNAPSHOT_WRITES 20000
+#define SEQ_VALUES 64
+
+//------------------------------------------------------------------------------
+// Seqlock
+
+typedef struct {
+    u64 values[SEQ_VALUES]; // All equal outside a write
+} SeqValues;
+
+typedef struct {
+    SeqLock   lock;
+    SeqValues data;
+    bool      done;
+    usize     torn[SNAPSHOT_READERS];
+    usize     reads[SNAPSHOT_READERS];
+} SeqShared;
+
+typedef struct {
+    SeqShared* shared;
+    usize      index;
+} SeqReader;
+
+internal void read_values(void* context)
+{
+    SeqReader* reader = context;
+    SeqShared* shared = reader->shared;
+    usize      torn = 0, reads = 0;
+    while (!atomic_load_bool(&shared->done, MEMORY_ACQUIRE)) {
+        SeqValues copy;
+        seqlock_read(&shared->lock, &copy, &shared->data, sizeof(copy));
+        for (usize i = 1; i < SEQ_VALUES; ++i) {
+            torn += copy.values[i] != copy.values[0];
+        }
+        reads++;
+    }
+    shared->torn[reader->index]  = torn;
+    shared->reads[reader->index] = reads;
+}
+
+// Increments every value in place, one at a time, under the write lock.
+internal void write_values(void* context)
+{
+    SeqShared* shared = context;
+    for (usize i = 0; i < SNAPSHOT_WRITES; ++i) {
+        seqlock_write_lock(&shared->lock);
+        for (usize v = 0; v < SEQ_VALUES; ++v) {
+            shared->data.values[v]++;
+        }
+        seqlock_write_unlock(&shared->lock);
+        if (i % 1000 == 0) {
+            time_sleep_ms(1);
+        }
+    }
+}
+
+TEST_CASE(snapshot, seqlock_readers_never_see_torn_writes)
+{
+    SeqShared shared = {0};
+    seqlock_init(&shared.lock);
+
+    SeqReader readers[SNAPSHOT_READERS];
+    Thread    threads[SNAPSHOT_READERS];
+    for (usize i = 0; i < SNAPSHOT_READERS; ++i) {
+        readers[i] = (SeqReader){&shared, i};
+        thread_create(&threads[i], read_values, &readers[i]);
+    }
+
+    // Two writers exclude each other, so no increment is lost.
+    Thread writers[2];
+    for (usize i = 0; i < 2; ++i) {
+        thread_create(&writers[i], write_values, &shared);
+    }
+    for (usize i = 0; i < 2; ++i) {
+        thread_join(&writers[i]);
+    }
+    atomic_store_bool(&shared.done, true, MEMORY_RELEASE);
+    for (usize i = 0; i < SNAPSHOT_READERS; ++i) {
+        thread_join(&threads[i]);
+    }
+
+    TEST_ASSERT_EQ(shared.data.values[0], 2 * SNAPSHOT_WRITES);
+    TEST_ASSERT_EQ(shared.data.values[SEQ_VALUES - 1], 2 * SNAPSHOT_WRITES);
+    TEST_ASSERT_EQ(shared.lock.sequence, 4 * SNAPSHOT_WRITES);
+    for (usize i = 0; i < SNAPSHOT_READERS; ++i) {
+        TEST_ASSERT_EQ(shared.torn[i], 0);
+        TEST_ASSERT_GT(shared.reads[i], 0);
+    }
+
+    // A read that overlaps a write retries.
+    u32 start = seqlock_read_begin(&shared.lock);
+    TEST_ASSERT(!seqlock_read_retry(&shared.lock, start));
+    SeqValues zero = {0};
+    seqlock_write(&shared.lock, &shared.data, &zero, sizeof(zero));
+    TEST_ASSERT(seqlock_read_retry(&shared.lock, start));
+}
+
+//------------------------------------------------------------------------------
+// Snapshot
+
+typedef struct {
+    void* freed[4]; // Objects passed to record_free, in order
+    usize count;
+} FreeLog;
+
+internal void record_free(void* context, void* ptr)
+{
+    FreeLog* log             = context;
+    log->freed[log->count++] = ptr;
+}
+
+TEST_CASE(snapshot, nested_reads_hold_back_the_old_object)
+{
+    EpochDomain domain;
+    epoch_domain_init(&domain);
+
+    // Two records on one thread stand in for a reader and a writer.
+    EpochThread* reader = epoch_register(&domain);
+    EpochThread* writer = epoch_register(&domain);
+
+    // Nothing is published yet, and replacing nothing retires nothing.
+    FreeLog  log = {0};
+    Snapshot snapshot;
+    snapshot_init(&snapshot,
+                  .domain       = &domain,
+                  .free_func    = record_free,
+                  .free_context = &log);
+    TEST_ASSERT_NULL(snapshot_current(&snapshot));
+    TEST_ASSERT_NULL(snapshot_read_begin(&snapshot, reader));
+    snapshot_read_end(&snapshot, reader);
+
+    u64 a = 1, b = 2;
+    snapshot_publish(&snapshot, writer, &a);
+    TEST_ASSERT(snapshot_current(&snapshot) == &a);
+    TEST_ASSERT_EQ(epoch_pending(writer), 0);
+
+    // A nested read keeps the object it started with until the outer read
+    // ends, however often the writer collects.
+    TEST_ASSERT(snapshot_read_begin(&snapshot, reader) == &a);
+    snapshot_publish(&snapshot, writer, &b);
+    TEST_ASSERT(snapshot_current(&snapshot) == &b);
+    TEST_ASSERT(snapshot_read_begin(&snapshot, reader) == &b);
+    for (usize i = 0; i < 4; ++i) {
+        epoch_collect(writer);
+    }
+    snapshot_read_end(&snapshot, reader);
+    epoch_collect(writer);
+    TEST_ASSERT_EQ(log.count, 0);
+
+    snapshot_read_end(&snapshot, reader);
+    epoch_collect(writer);
+    epoch_collect(writer);
+    TEST_ASSERT_EQ(log.count, 1);
+    TEST_ASSERT(log.freed[0] == &a);
+
+    // Done frees the current object at once, and only once.
+    snapshot_done(&snapshot);
+    TEST_ASSERT_EQ(log.count, 2);
+    TEST_ASSERT(log.freed[1] == &b);
+    TEST_ASSERT_NULL(snapshot_current(&snapshot));
+    snapshot_done(&snapshot);
+    TEST_ASSERT_EQ(log.count, 2);
+
+    epoch_unregister(writer);
+    epoch_unregister(reader);
+    epoch_domain_done(&domain);
+}
+
+typedef struct {
+    u64 version;
+} Config;
+
+typedef struct {
+    Snapshot snapshot;
+    usize    backwards[SNAPSHOT_READERS]; // Reads older than the one before
+    usize    reads[SNAPSHOT_READERS];
+} ConfigShared;
+
+typedef struct {
+    ConfigShared* shared;
+    usize         index;
+} ConfigReader;
+
+// Reads until the last version is published, so every reader reads at least
+// once however the threads are scheduled.
+internal void read_configs(void* context)
+{
+    ConfigReader* reader = context;
+    ConfigShared* shared = reader->shared;
+    EpochThread*  me     = epoch_register(shared->snapshot.domain);
+
+    usize backwards = 0, reads = 0;
+    u64   version   = 0;
+    while (version != SNAPSHOT_WRITES) {
+        const Config* config = snapshot_read_begin(&shared->snapshot, me);
+        backwards += config->version < version;
+        version = config->version;
+        snapshot_read_end(&shared->snapshot, me);
+        reads++;
+    }
+
+    epoch_unregister(me);
+    shared->backwards[reader->index] = backwards;
+    shared->reads[reader->index]     = reads;
+}
+
+internal Config* new_config(u64 version)
+{
+    Config* config  = KORE_ALLOC(sizeof(Config));
+    config->version = version;
+    return config;
+}
+
+TEST_CASE(snapshot, readers_see_versions_in_order_and_all_are_freed)
+{
+#if CONFIG_DEBUG
+    usize allocations = mem_get_allocation_count();
+#endif
+
+    // No free function: replaced configs go back to the heap.
+    EpochDomain domain;
+    epoch_domain_init(&domain, .collect_threshold = 16);
+    ConfigShared shared = {0};
+    snapshot_init(
+        &shared.snapshot, .domain = &domain, .initial = new_config(0));
+
+    ConfigReader readers[SNAPSHOT_READERS];
+    Thread       threads[SNAPSHOT_READERS];
+    for (usize i = 0; i < SNAPSHOT_READERS; ++i) {
+        readers[i] = (ConfigReader){&shared, i};
+        thread_create(&threads[i], read_configs, &readers[i]);
+    }
+
+    EpochThread* me = epoch_register(&domain);
+    for (u64 v = 1; v <= SNAPSHOT_WRITES; ++v) {
+        const Config* current = snapshot_current(&shared.snapshot);
+        TEST_ASSERT_EQ(current->version, v - 1);
+        snapshot_publish(&shared.snapshot, me, new_config(v));
+    }
+    for (usize i = 0; i < SNAPSHOT_READERS; ++i) {
+        thread_join(&threads[i]);
+    }
+    epoch_unregister(me); // Frees every replaced config
+
+    for (usize i = 0; i < SNAPSHOT_READERS; ++i) {
+        TEST_ASSERT_EQ(shared.backwards[i], 0);
+        TEST_ASSERT_GT(shared.reads[i], 0);
+    }
+#if CONFIG_DEBUG
+    TEST_ASSERT_EQ(mem_get_allocation_count(), allocations + 1);
+#endif
+    snapshot_done(&shared.snapshot);
+#if CONFIG_DEBUG
+    TEST_ASSERT_EQ(mem_get_allocation_count(), allocations);
+#endif
+
+    epoch_domain_done(&domain);
+}
@@ -0,0 +1,102 @@
+//> use: core
+
+#include <core/core.h>
+#include <test.h>
+
+#if OS_LINUX
+#    include <sys/prctl.h>
+#endif // OS_LINUX
+
+typedef struct {
+    char name[16];
+    u64  stack_sum;
+    bool ran;
+} ThreadProbe;
+
+internal void thread_probe(void* context)
+{
+    ThreadProbe* probe = context;
+
+    // Touch more stack than a minimal default would allow.
+    volatile u8 stack[KB(512)];
+    for (usize i = 0; i < sizeof(stack); i += KB(4)) {
+        stack[i] = 1;
+    }
+    for (usize i = 0; i < sizeof(stack); i += KB(4)) {
+        probe->stack_sum += stack[i];
+    }
+
+#if OS_LINUX
+    prctl(PR_GET_NAME, probe->name, 0, 0, 0);
+#endif // OS_LINUX
+    probe->ran = true;
+}
+
+TEST_CASE(thread, create_join_with_name_and_stack_size)
+{
+    ThreadProbe probe = {0};
+    Thread      thread;
+    TEST_ASSERT(thread_create(&thread,
+                              thread_probe,
+                              &probe,
+                              .stack_size = MB(2),
+                              .name       = "probe-thread-with-long-name"));
+    thread_join(&thread);
+
+    TEST_ASSERT(probe.ran);
+    TEST_ASSERT_EQ(probe.stack_sum, KB(512) / KB(4));
+#if OS_LINUX
+    TEST_ASSERT_STR_EQ(probe.name, "probe-thread-wi");
+#endif // OS_LINUX
+
+    TEST_ASSERT_GE(thread_cpu_count(), 1);
+}
+
+typedef struct {
+    u64 input;
+    u64 output;
+} PoolTask;
+
+internal void pool_task_square(void* context)
+{
+    PoolTask* task = context;
+    task->output   = task->input * task->input;
+}
+
+TEST_CASE(thread, pool_runs_every_task_and_drains_on_done)
+{
+    ThreadPool pool;
+    thread_pool_init(&pool, .thread_count = 4, .queue_capacity = 8);
+    TEST_ASSERT_EQ(pool.thread_count, 4);
+
+    // More tasks than the queue holds, so submission has to wait for room.
+    enum { TASK_COUNT = 1000 };
+    PoolTask* tasks = KORE_ARRAY_ALLOC(PoolTask, TASK_COUNT);
+    for (u64 i = 0; i < TASK_COUNT; ++i) {
+        tasks[i] = (PoolTask){.input = i};
+        thread_pool_submit(&pool, pool_task_square, &tasks[i]);
+    }
+    thread_pool_wait(&pool);
+
+    usize wrong = 0;
+    for (u64 i = 0; i < TASK_COUNT; ++i) {
+        wrong += tasks[i].output != i * i;
+        tasks[i] = (PoolTask){.input = i + 1};
+    }
+    TEST_ASSERT_EQ(wrong, 0);
+    TEST_ASSERT_EQ(pool.queued, 0);
+    TEST_ASSERT_EQ(pool.running, 0);
+
+    // Tasks still queued when the pool is shut down are run first.
+    for (u64 i = 0; i < TASK_COUNT; ++i) {
+        thread_pool_submit(&pool, pool_task_square, &tasks[i]);
+    }
+    thread_pool_done(&pool);
+
+    for (u64 i = 0; i < TASK_COUNT; ++i) {
+        wrong += tasks[i].output != (i + 1) * (i + 1);
+    }
+    TEST_ASSERT_EQ(wrong, 0);
+
+    KORE_ARRAY_FREE(tasks);
+}
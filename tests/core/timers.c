@@ -0,0 +1,198 @@
+//> use: core
+
+#include <core/core.h>
+#include <test.h>
+
+#define TIMER_COUNT 5000
+
+//------------------------------------------------------------------------------
+// Expiry
+
+typedef struct {
+    TimePoint* now;      // Time passed to the running advance
+    TimePoint* previous; // Time passed to the advance before it
+    TimePoint  deadline;
+    usize      fired;
+    usize      early;
+    usize      late;
+} TimerCheck;
+
+internal void check_fire(void* context)
+{
+    TimerCheck* check = context;
+    check->fired++;
+    check->early += *check->now < check->deadline;
+    // Due a whole tick before the previous advance stopped.
+    check->late += *check->previous >= check->deadline + time_from_ms(1);
+}
+
+TEST_CASE(timer, fires_on_time_across_all_levels)
+{
+    TimePoint  start = time_from_secs(1000);
+    TimerWheel wheel;
+    timer_wheel_init(&wheel, .start = start);
+
+    // Deadlines from nanoseconds to years away, so every level is used and
+    // some are beyond the top one.
+    random_seed(47);
+    local_persist TimerCheck checks[TIMER_COUNT];
+    TimePoint                now = start, previous = start;
+    TimePoint                last = start;
+    for (usize i = 0; i < TIMER_COUNT; ++i) {
+        u64 scale = 1ull << random_range_u64(0, 57);
+        checks[i] = (TimerCheck){
+            .now      = &now,
+            .previous = &previous,
+            .deadline = start + random_range_u64(0, scale),
+        };
+        last = MAX(last, checks[i].deadline);
+        timer_schedule(&wheel, checks[i].deadline, check_fire, &checks[i]);
+    }
+    TEST_ASSERT_EQ(wheel.count, TIMER_COUNT);
+
+    // Walk forward in steps of wildly different sizes.
+    usize fired = 0;
+    while (previous <= last) {
+        u64 step = random_range_u64(0, 1ull << random_range_u64(0, 56));
+        now      = previous + step;
+        fired += timer_wheel_advance(&wheel, now);
+        previous = now;
+    }
+
+    usize early = 0, late = 0, wrong = 0;
+    for (usize i = 0; i < TIMER_COUNT; ++i) {
+        early += checks[i].early;
+        late += checks[i].late;
+        wrong += checks[i].fired != 1;
+    }
+    TEST_ASSERT_EQ(fired, TIMER_COUNT);
+    TEST_ASSERT_EQ(wheel.count, 0);
+    TEST_ASSERT_EQ(early, 0);
+    TEST_ASSERT_EQ(late, 0);
+    TEST_ASSERT_EQ(wrong, 0);
+
+    timer_wheel_done(&wheel);
+}
+
+//------------------------------------------------------------------------------
+// Handles
+
+typedef struct {
+    TimerWheel* wheel;
+    TimerHandle rival; // Cancelled when this timer fires
+    usize       fired;
+} TimerChain;
+
+internal void count_fire(void* context) { ++*(usize*)context; }
+
+// Cancels its rival in the same batch and schedules a follow-up.
+internal void chain_fire(void* context)
+{
+    TimerChain* chain = context;
+    chain->fired++;
+    timer_cancel(chain->wheel, chain->rival);
+    if (chain->fired < 3) {
+        timer_schedule(chain->wheel, 0, chain_fire, chain);
+    }
+}
+
+TEST_CASE(timer, cancel_and_reschedule_keep_handles_safe)
+{
+    TimePoint  start = time_from_secs(1000);
+    TimerWheel wheel;
+    timer_wheel_init(&wheel, .start = start, .tick = time_from_ms(10));
+
+    usize       fired   = 0;
+    TimerHandle none    = {0};
+    TimerHandle soon    = timer_schedule(
+        &wheel, start + time_from_ms(50), count_fire, &fired);
+    TimerHandle later   = timer_schedule(
+        &wheel, start + time_from_secs(100), count_fire, &fired);
+    TimerHandle dropped = timer_schedule(
+        &wheel, start + time_from_ms(50), count_fire, &fired);
+    TEST_ASSERT(!timer_pending(&wheel, none));
+    TEST_ASSERT(!timer_cancel(&wheel, none));
+
+    TEST_ASSERT(timer_cancel(&wheel, dropped));
+    TEST_ASSERT(!timer_cancel(&wheel, dropped));
+    TEST_ASSERT(!timer_pending(&wheel, dropped));
+
+    // The cancelled record is reused, but the old handle no longer matches.
+    TimerHandle reused = timer_schedule(
+        &wheel, start + time_from_ms(60), count_fire, &fired);
+    TEST_ASSERT(reused.timer == dropped.timer);
+    TEST_ASSERT(!timer_cancel(&wheel, dropped));
+    TEST_ASSERT(timer_pending(&wheel, reused));
+
+    // Bring the long timer forward.
+    TEST_ASSERT(timer_reschedule(&wheel, later, start + time_from_ms(200)));
+    TEST_ASSERT_EQ(timer_wheel_advance(&wheel, start + time_from_ms(40)), 0);
+    TEST_ASSERT_EQ(timer_wheel_advance(&wheel, start + time_from_ms(60)), 2);
+    TEST_ASSERT(!timer_pending(&wheel, soon));
+    TEST_ASSERT(!timer_cancel(&wheel, reused));
+    TEST_ASSERT(!timer_reschedule(&wheel, soon, start));
+    TEST_ASSERT_EQ(timer_wheel_advance(&wheel, start + time_from_ms(200)), 1);
+    TEST_ASSERT_EQ(fired, 3);
+    TEST_ASSERT_EQ(wheel.count, 0);
+
+    // Callbacks can cancel the rest of their batch and schedule more timers,
+    // which wait for the next tick.
+    TimePoint  now = start + time_from_secs(1);
+    TimerChain a   = {.wheel = &wheel};
+    TimerChain b   = {.wheel = &wheel};
+    b.rival        = timer_schedule(&wheel, now, chain_fire, &a);
+    a.rival        = timer_schedule(&wheel, now, chain_fire, &b);
+    TEST_ASSERT_EQ(timer_wheel_advance(&wheel, now), 1);
+    TEST_ASSERT_EQ(a.fired + b.fired, 1);
+    TEST_ASSERT_EQ(wheel.count, 1);
+    now += time_from_ms(10);
+    TEST_ASSERT_EQ(timer_wheel_advance(&wheel, now), 1);
+    now += time_from_ms(10);
+    TEST_ASSERT_EQ(timer_wheel_advance(&wheel, now), 1);
+    TEST_ASSERT_EQ(a.fired + b.fired, 3);
+    TEST_ASSERT_EQ(wheel.count, 0);
+
+    timer_wheel_done(&wheel);
+}
+
+//------------------------------------------------------------------------------
+// Next deadline
+
+TEST_CASE(timer, next_deadline_bounds_the_wait)
+{
+    TimePoint  start = time_from_secs(1000);
+    TimerWheel wheel;
+    timer_wheel_init(&wheel, .start = start);
+    TEST_ASSERT_EQ(timer_wheel_next_deadline(&wheel), TIMER_NEVER);
+    TEST_ASSERT_EQ(timer_wheel_timeout_ms(&wheel, start), -1);
+
+    usize     fired    = 0;
+    TimePoint deadline = start + time_from_secs(3600) + time_from_us(1500);
+    timer_schedule(&wheel, deadline, count_fire, &fired);
+
+    // Sleeping until each reported deadline reaches the timer in a handful of
+    // wakeups, one per level it has to come down, and never overshoots.
+    TimePoint now    = start;
+    usize     wakeup = 0;
+    while (!fired) {
+        TimePoint next = timer_wheel_next_deadline(&wheel);
+        TEST_ASSERT_GT(next, now);
+        TEST_ASSERT_LE(next, deadline + time_from_ms(1));
+        int timeout = timer_wheel_timeout_ms(&wheel, now);
+        TEST_ASSERT_GT(timeout, 0);
+        TEST_ASSERT_GE(now + time_from_ms((u64)timeout), next);
+        now = next;
+        timer_wheel_advance(&wheel, now);
+        wakeup++;
+    }
+    TEST_ASSERT_GE(now, deadline);
+    TEST_ASSERT_LE(wakeup, TIMER_WHEEL_LEVELS);
+    TEST_ASSERT_EQ(timer_wheel_next_deadline(&wheel), TIMER_NEVER);
+
+    // A deadline already passed is due on the next tick.
+    timer_schedule(&wheel, start, count_fire, &fired);
+    TEST_ASSERT_EQ(timer_wheel_next_deadline(&wheel), now + time_from_ms(1));
+    TEST_ASSERT_EQ(timer_wheel_timeout_ms(&wheel, now + time_from_ms(2)), 0);
+
+    timer_wheel_done(&wheel);
+}
@@ -0,0 +1,149 @@
+//> use: core
+
+#include <core/core.h>
+#include <test.h>
+
+//------------------------------------------------------------------------------
+// Topology
+
+TEST_CASE(topology, cpus_nodes_and_spread_agree)
+{
+    const CpuTopology* topology = cpu_topology();
+    TEST_ASSERT_GE(topology->cpu_count, 1);
+    TEST_ASSERT_GE(topology->node_count, 1);
+    TEST_ASSERT(cpu_topology() == topology);
+
+    usize on_nodes  = 0;
+    usize bad_nodes = 0;
+    usize unordered = 0;
+    for (usize n = 0; n < topology->node_count; ++n) {
+        on_nodes += topology->node_cpus[n];
+    }
+    for (usize i = 0; i < topology->cpu_count; ++i) {
+        const CpuInfo* cpu = &topology->cpus[i];
+        bad_nodes += cpu->node >= topology->node_count ||
+                     topology->cpu_node[cpu->id] != cpu->node;
+        unordered += i > 0 && topology->cpus[i - 1].id >= cpu->id;
+    }
+    TEST_ASSERT_EQ(on_nodes, topology->cpu_count);
+    TEST_ASSERT_EQ(bad_nodes, 0);
+    TEST_ASSERT_EQ(unordered, 0);
+
+    // The spread order visits every CPU once, then wraps.
+    bool  seen[TOPOLOGY_MAX_CPUS] = {0};
+    usize repeats                 = 0;
+    for (usize i = 0; i < topology->cpu_count; ++i) {
+        u32 cpu = cpu_spread(i);
+        repeats += seen[cpu];
+        seen[cpu] = true;
+    }
+    TEST_ASSERT_EQ(repeats, 0);
+    TEST_ASSERT_EQ(cpu_spread(topology->cpu_count), cpu_spread(0));
+}
+
+//------------------------------------------------------------------------------
+// Pinning
+
+typedef struct {
+    u32 cpu;         // CPU the thread ran on
+    u32 pinned_node; // thread_pinned_node() inside the thread
+    u32 node_pinned; // thread_pin_node() succeeded
+    u32 scratch_node;
+} PinReport;
+
+internal void report_pinning(void* context)
+{
+    PinReport* report   = context;
+    report->cpu         = thread_current_cpu();
+    report->pinned_node = thread_pinned_node();
+
+    ArenaScratch scratch = scratch_begin(NULL);
+    report->scratch_node = scratch.arena->numa_node;
+    scratch_end(scratch);
+
+    report->node_pinned = thread_pin_node(0);
+}
+
+TEST_CASE(topology, threads_pin_to_cpus_and_nodes)
+{
+    // The topology only lists CPUs in the affinity mask, so this one is
+    // allowed even under taskset or a cpuset.
+    const CpuTopology* topology = cpu_topology();
+    const CpuInfo*     last     = &topology->cpus[topology->cpu_count - 1];
+
+    PinReport report = {0};
+    Thread    thread;
+    thread_create(
+        &thread, report_pinning, &report, .cpu = THREAD_CPU(last->id));
+    thread_join(&thread);
+
+#if OS_LINUX || OS_WINDOWS
+    TEST_ASSERT_EQ(report.cpu, last->id);
+    TEST_ASSERT_EQ(report.pinned_node, ARENA_NODE(last->node));
+    TEST_ASSERT_EQ(report.scratch_node, ARENA_NODE(last->node));
+    TEST_ASSERT(report.node_pinned);
+#endif
+
+    // Unpinned threads leave placement to the OS.
+    report = (PinReport){0};
+    thread_create(&thread, report_pinning, &report);
+    thread_join(&thread);
+    TEST_ASSERT_EQ(report.pinned_node, 0);
+    TEST_ASSERT_EQ(report.scratch_node, 0);
+}
+
+// Tries every listed CPU, which fails if one is outside the affinity mask.
+internal void pin_everywhere(void* context)
+{
+    const CpuTopology* topology = cpu_topology();
+    usize*             refused  = context;
+    for (usize i = 0; i < topology->cpu_count; ++i) {
+        *refused += !thread_pin_cpu(topology->cpus[i].id);
+    }
+}
+
+TEST_CASE(topology, every_listed_cpu_can_be_pinned)
+{
+    usize  refused = 0;
+    Thread thread;
+    thread_create(&thread, pin_everywhere, &refused);
+    thread_join(&thread);
+#if OS_LINUX || OS_WINDOWS
+    TEST_ASSERT_EQ(refused, 0);
+#endif
+}
+
+internal void count_pinned(void* context)
+{
+    atomic_fetch_add_u32(context, thread_pinned_node() != 0, MEMORY_RELAXED);
+}
+
+TEST_CASE(topology, pinned_pools_and_node_arenas)
+{
+    ThreadPool pool;
+    thread_pool_init(&pool, .thread_count = 2, .pin_workers = true);
+    u32 pinned = 0;
+    for (usize i = 0; i < 16; ++i) {
+        thread_pool_submit(&pool, count_pinned, &pinned);
+    }
+    thread_pool_wait(&pool);
+    thread_pool_done(&pool);
+#if OS_LINUX || OS_WINDOWS
+    TEST_ASSERT_EQ(pinned, 16);
+#endif
+
+    // Binding is a preference, so it works on single-node machines too.
+    Arena arena;
+    arena_init(&arena, .reserved_size = MB(8), .numa_node = ARENA_NODE(0));
+    TEST_ASSERT_EQ(arena.numa_node, ARENA_NODE(0));
+    u8* data = arena_alloc(&arena, MB(2));
+    memset(data, 0xab, MB(2));
+    TEST_ASSERT_EQ(data[MB(2) - 1], 0xab);
+    arena_done(&arena);
+
+    arena_init(&arena, .chained = true, .numa_node = ARENA_NODE(0));
+    data = arena_alloc(&arena, KB(256));
+    memset(data, 0xcd, KB(256));
+    TEST_ASSERT_EQ(data[0], 0xcd);
+    arena_done(&arena);
+}